@@ -0,0 +1,131 @@
+#include "activitybar.h"
+#include "motiontrack.h"
+
+#include <QMouseEvent>
+#include <QPainter>
+#include <QtMath>
+
+namespace {
+constexpr int    ACTIVITY_BINS   = 600;     // 폭이 달라도 이 해상도로 모아 두고 그릴 때 맞춤
+constexpr qint64 SEGMENT_GAP_MS  = 1000;    // 이보다 짧게 멈춘 움직임은 한 구간
+constexpr qint64 PRE_ROLL_MS     = 1000;    // 구간으로 이동할 때 이만큼 앞에서 시작
+constexpr qint64 NEXT_SLACK_MS   = 250;     // 지금 위치의 구간을 다시 고르지 않도록
+constexpr qint64 PREV_SLACK_MS   = 1500;    // 방금 이동한 구간에서 한 번 더 누르면 그 앞 구간으로
+constexpr int    BAR_HEIGHT      = 36;
+}
+
+ActivityBar::ActivityBar(QWidget *parent)
+    : QWidget(parent)
+{
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
+    setCursor(Qt::PointingHandCursor);
+    setToolTip(QStringLiteral("움직임 활동 (누르면 그 위치로 이동)"));
+}
+
+QSize ActivityBar::sizeHint() const
+{
+    return QSize(640, BAR_HEIGHT);
+}
+
+void ActivityBar::setTrack(const MotionTrack& track)
+{
+    m_durationMs = track.durationMs();
+    m_positionMs = 0;
+    m_segments = track.segments(SEGMENT_GAP_MS);
+    m_levels.fill(0.0f, ACTIVITY_BINS);
+
+    // 구간마다 최대 면적 → 클립 안의 최대값 기준으로 (제곱근으로 작은 움직임도 보이게)
+    int maxArea = 1;
+    for (const MotionTrack::Frame& f : track.frames) maxArea = qMax(maxArea, f.area);
+    for (const MotionTrack::Frame& f : track.frames) {
+        const int bin = track.frameCount > 0 ? int(qint64(f.index) * ACTIVITY_BINS / track.frameCount) : 0;
+        const float level = float(qSqrt(double(f.area) / maxArea));
+        float& slot = m_levels[qBound(0, bin, ACTIVITY_BINS - 1)];
+        slot = qMax(slot, qMax(level, 0.15f));   // 아주 작은 움직임도 표시
+    }
+    update();
+}
+
+void ActivityBar::clear()
+{
+    m_levels.clear();
+    m_segments.clear();
+    m_durationMs = 0;
+    m_positionMs = 0;
+    update();
+}
+
+void ActivityBar::setPosition(qint64 ms)
+{
+    if (!hasTrack() || xAt(ms) == xAt(m_positionMs)) {   // 같은 픽셀이면 다시 그리지 않음
+        m_positionMs = ms;
+        return;
+    }
+    m_positionMs = ms;
+    update();
+}
+
+qint64 ActivityBar::nextMotion(qint64 afterMs) const
+{
+    for (const auto& seg : m_segments) {
+        const qint64 target = qMax<qint64>(0, seg.first - PRE_ROLL_MS);
+        if (target > afterMs + NEXT_SLACK_MS) return target;
+    }
+    return -1;
+}
+
+qint64 ActivityBar::previousMotion(qint64 beforeMs) const
+{
+    for (auto it = m_segments.crbegin(); it != m_segments.crend(); ++it) {
+        const qint64 target = qMax<qint64>(0, it->first - PRE_ROLL_MS);
+        if (target < beforeMs - PREV_SLACK_MS) return target;
+    }
+    return -1;
+}
+
+void ActivityBar::paintEvent(QPaintEvent *)
+{
+    QPainter p(this);
+    p.fillRect(rect(), QColor("#202020"));
+    if (!hasTrack()) {
+        p.setPen(QColor("#888"));
+        p.drawText(rect(), Qt::AlignCenter, QStringLiteral("움직임 기록 없음"));
+        return;
+    }
+
+    // 픽셀 열마다 그 열에 들어가는 구간의 최대값
+    const int w = width(), h = height();
+    for (int x = 0; x < w; ++x) {
+        const int from = x * ACTIVITY_BINS / w;
+        const int to   = qMax(from + 1, (x + 1) * ACTIVITY_BINS / w);
+        float level = 0.0f;
+        for (int b = from; b < to && b < m_levels.size(); ++b) level = qMax(level, m_levels.at(b));
+        if (level <= 0.0f) continue;
+        const int barH = qMax(2, int(level * (h - 4)));
+        p.fillRect(x, h - 2 - barH, 1, barH, QColor("#e0a030"));
+    }
+
+    p.setPen(QPen(Qt::white, 2));
+    const int px = xAt(m_positionMs);
+    p.drawLine(px, 0, px, h);
+}
+
+void ActivityBar::mousePressEvent(QMouseEvent *event)
+{
+    if (hasTrack() && event->button() == Qt::LeftButton) emit seekRequested(timeAt(event->position().toPoint().x()));
+}
+
+void ActivityBar::mouseMoveEvent(QMouseEvent *event)
+{
+    if (hasTrack() && (event->buttons() & Qt::LeftButton)) emit seekRequested(timeAt(event->position().toPoint().x()));
+}
+
+qint64 ActivityBar::timeAt(int x) const
+{
+    return width() > 0 ? qBound<qint64>(0, qint64(x) * m_durationMs / width(), m_durationMs) : 0;
+}
+
+int ActivityBar::xAt(qint64 ms) const
+{
+    return m_durationMs > 0 ? int(qBound<qint64>(0, ms, m_durationMs) * width() / m_durationMs) : 0;
+}
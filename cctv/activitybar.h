@@ -0,0 +1,48 @@
+#ifndef ACTIVITYBAR_H
+#define ACTIVITYBAR_H
+
+#include <QList>
+#include <QPair>
+#include <QVector>
+#include <QWidget>
+
+struct MotionTrack;
+
+// 재생 중인 클립의 움직임 활동 막대 (Tab2 플레이어 아래).
+// 가로축은 클립 시간, 막대 높이는 그 구간의 최대 전경 면적. 누르거나 끌면 그 위치로 이동 요청.
+class ActivityBar : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit ActivityBar(QWidget *parent = nullptr);
+
+    void setTrack(const MotionTrack& track);
+    void clear();
+    bool hasTrack() const { return m_durationMs > 0; }
+    void setPosition(qint64 ms);
+
+    // 움직임 구간 시작 (조금 앞에서부터 보이도록 PRE_ROLL만큼 당김). 없으면 -1
+    qint64 nextMotion(qint64 afterMs) const;
+    qint64 previousMotion(qint64 beforeMs) const;
+
+    QSize sizeHint() const override;
+
+signals:
+    void seekRequested(qint64 ms);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+
+private:
+    qint64 timeAt(int x) const;
+    int    xAt(qint64 ms) const;
+
+    QVector<float> m_levels;                     // 구간별 활동 (0~1)
+    QList<QPair<qint64, qint64>> m_segments;     // 움직임 구간 [시작, 끝) ms
+    qint64 m_durationMs = 0;
+    qint64 m_positionMs = 0;
+};
+
+#endif // ACTIVITYBAR_H
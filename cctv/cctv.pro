@@ -1,4 +1,4 @@
-QT       += core gui widgets multimedia multimediawidgets websockets concurrent
+QT       += core gui widgets multimedia multimediawidgets network sql
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -9,20 +9,68 @@ CONFIG += c++17 link_pkgconfig
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 PKGCONFIG += opencv4
 
+# libjpeg-turbo(TurboJPEG)가 있으면 스트리밍 인코더가 이를 직접 사용 (없으면 cv::imencode)
+packagesExist(libturbojpeg) {
+    PKGCONFIG += libturbojpeg
+    DEFINES += CCTV_HAVE_TURBOJPEG
+}
+
+# FFmpeg(libavcodec + libx264)가 있으면 H.264 fMP4 라이브 스트림(?q=h264)을 제공하고
+# 클립 썸네일을 첫 키프레임만 디코딩해 만듦
+packagesExist(libavcodec libavformat libavutil libswscale) {
+    PKGCONFIG += libavcodec libavformat libavutil libswscale
+    DEFINES += CCTV_HAVE_FFMPEG
+}
+
 SOURCES += \
+    activitybar.cpp \
+    clipcatalog.cpp \
+    clipindex.cpp \
+    clipserver.cpp \
+    clipwatcher.cpp \
+    fmp4encoder.cpp \
+    gallerymodel.cpp \
+    httprequest.cpp \
+    jpegencoder.cpp \
     main.cpp \
     mainwidget.cpp \
     motiondetector.cpp \
+    motionpipeline.cpp \
+    motionsearchdialog.cpp \
+    motiontrack.cpp \
+    pipelinestats.cpp \
     streamserver.cpp \
     tab1_camera.cpp \
-    tab2_video.cpp
+    tab2_video.cpp \
+    thumbnailcache.cpp \
+    thumbnailloader.cpp \
+    trace.cpp \
+    wsprotocol.cpp
 
 HEADERS += \
+    activitybar.h \
+    clipcatalog.h \
+    clipindex.h \
+    clipserver.h \
+    clipwatcher.h \
+    fmp4encoder.h \
+    gallerymodel.h \
+    httprequest.h \
+    jpegencoder.h \
     mainwidget.h \
     motiondetector.h \
+    motionpipeline.h \
+    motionsearchdialog.h \
+    motiontrack.h \
+    pipelinestats.h \
+    streamframe.h \
     streamserver.h \
     tab1_camera.h \
-    tab2_video.h
+    tab2_video.h \
+    thumbnailcache.h \
+    thumbnailloader.h \
+    trace.h \
+    wsprotocol.h
 
 FORMS += \
     mainwidget.ui \
@@ -0,0 +1,180 @@
+#include "clipcatalog.h"
+
+#include <algorithm>
+#include <QDir>
+#include <QFileInfo>
+#include <QStringList>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/videoio.hpp>
+
+#ifdef CCTV_HAVE_FFMPEG
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libswscale/swscale.h>
+}
+#endif
+
+namespace {
+ClipInfo toClip(const QFileInfo& fi, const QDate& date)
+{
+    ClipInfo c;
+    c.fileName = fi.fileName();
+    c.path     = fi.absoluteFilePath();
+    c.date     = date;
+    c.size     = fi.size();
+    c.modified = fi.lastModified();
+    return c;
+}
+
+#ifdef CCTV_HAVE_FFMPEG
+constexpr int KEYFRAME_MAX_TRIES = 3;       // 키프레임에서 프레임이 나오지 않으면 다음 키프레임으로 (손상된 앞부분, 재정렬 지연)
+
+// 첫 키프레임 하나만 디코딩해 바로 썸네일 크기의 BGR로 변환합니다.
+// 키프레임이 아닌 패킷은 디코더에 넣지도 않고(skip_frame=NONKEY), 코덱이 지원하면 lowres로 축소 디코딩.
+// 색변환과 축소는 sws_scale 한 번으로 끝냄 (전체 해상도 BGR 프레임을 만들지 않음)
+bool keyframeThumbnail(const QString& path, cv::Size target, cv::Mat& bgr)
+{
+    AVFormatContext* fmt = nullptr;
+    if (avformat_open_input(&fmt, path.toUtf8().constData(), nullptr, nullptr) < 0) return false;
+
+    AVCodecContext* dec = nullptr;
+    AVPacket* pkt = av_packet_alloc();
+    AVFrame* frame = av_frame_alloc();
+    bool ok = false;
+
+    // MP4는 moov만으로 코덱 정보가 채워지므로 find_stream_info(여러 프레임 디코딩)는 필요할 때만
+    int stream = av_find_best_stream(fmt, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+    if (stream >= 0 && fmt->streams[stream]->codecpar->width <= 0 && avformat_find_stream_info(fmt, nullptr) >= 0) {
+        stream = av_find_best_stream(fmt, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+    }
+    const AVCodec* codec = stream >= 0 ? avcodec_find_decoder(fmt->streams[stream]->codecpar->codec_id) : nullptr;
+    if (codec && pkt && frame && (dec = avcodec_alloc_context3(codec))
+        && avcodec_parameters_to_context(dec, fmt->streams[stream]->codecpar) >= 0) {
+        dec->skip_frame = AVDISCARD_NONKEY;
+        dec->thread_count = 1;          // 프레임 스레딩은 출력이 스레드 수만큼 늦어짐
+        int lowres = 0;
+        while (lowres < codec->max_lowres && (dec->width >> (lowres + 1)) >= target.width
+               && (dec->height >> (lowres + 1)) >= target.height) {
+            ++lowres;
+        }
+        dec->lowres = lowres;
+
+        if (avcodec_open2(dec, codec, nullptr) >= 0) {
+            int tries = 0;
+            bool got = false;
+            while (!got && tries < KEYFRAME_MAX_TRIES && av_read_frame(fmt, pkt) >= 0) {
+                if (pkt->stream_index == stream && (pkt->flags & AV_PKT_FLAG_KEY)) {
+                    ++tries;
+                    if (avcodec_send_packet(dec, pkt) >= 0) got = avcodec_receive_frame(dec, frame) >= 0;
+                }
+                av_packet_unref(pkt);
+            }
+            // 마지막 시도(또는 파일 끝)까지 출력이 밀려 있으면 그때 디코더를 비워 남은 프레임을 받음.
+            // 비우면 디코더가 EOF가 되므로 시도 사이에는 비우지 않음
+            if (!got && tries > 0 && avcodec_send_packet(dec, nullptr) >= 0) {
+                got = avcodec_receive_frame(dec, frame) >= 0;
+            }
+
+            if (got && frame->width > 0 && frame->height > 0) {
+                const cv::Size size = ClipCatalog::fitInside(cv::Size(frame->width, frame->height), target);
+                SwsContext* sws = sws_getContext(frame->width, frame->height, AVPixelFormat(frame->format),
+                                                 size.width, size.height, AV_PIX_FMT_BGR24,
+                                                 SWS_AREA, nullptr, nullptr, nullptr);
+                if (sws) {
+                    bgr.create(size, CV_8UC3);
+                    uint8_t* dst[] = { bgr.data };
+                    const int dstStride[] = { int(bgr.step) };
+                    ok = sws_scale(sws, frame->data, frame->linesize, 0, frame->height, dst, dstStride) > 0;
+                    sws_freeContext(sws);
+                }
+            }
+        }
+    }
+
+    av_frame_free(&frame);
+    av_packet_free(&pkt);
+    avcodec_free_context(&dec);
+    avformat_close_input(&fmt);
+    return ok;
+}
+#endif
+}
+
+namespace ClipCatalog {
+
+cv::Size fitInside(cv::Size source, cv::Size target)
+{
+    const double scale = std::min(double(target.width) / source.width, double(target.height) / source.height);
+    return cv::Size(std::max(1, int(source.width * scale + 0.5)), std::max(1, int(source.height * scale + 0.5)));
+}
+
+bool isVideoFile(const QString& fileName)
+{
+    const QString ext = QFileInfo(fileName).suffix().toLower();
+    static const QStringList ok = {"mp4","mov","m4v","avi","mkv","wmv"};
+    return ok.contains(ext);
+}
+
+QDate dateFromName(const QString& fileName)
+{
+    const QStringList parts = QFileInfo(fileName).baseName().split('_');
+    if (parts.size() < 2) return QDate();
+    return QDate::fromString(parts.at(1), "yyyyMMdd");
+}
+
+QMap<QDate, QList<ClipInfo>> scan(const QString& dir)
+{
+    QMap<QDate, QList<ClipInfo>> groupedByDate;
+    const auto entries = QDir(dir).entryInfoList(QDir::Files | QDir::NoDotAndDotDot, QDir::Name | QDir::Reversed);
+    for (const QFileInfo& fi : entries) {
+        if (!isVideoFile(fi.fileName())) continue;
+        const QDate date = dateFromName(fi.fileName());
+        if (date.isValid()) groupedByDate[date].append(toClip(fi, date));
+    }
+    return groupedByDate;
+}
+
+bool find(const QString& dir, const QString& fileName, ClipInfo& out)
+{
+    if (fileName.isEmpty() || fileName.startsWith('.') || fileName.contains('/') || fileName.contains('\\')
+        || !isVideoFile(fileName)) {
+        return false;
+    }
+    const QFileInfo fi(QDir(dir).filePath(fileName));
+    if (!fi.isFile()) return false;
+    out = toClip(fi, dateFromName(fi.fileName()));
+    return true;
+}
+
+QString proxyDirectory(const QString& dir)
+{
+    return QDir(dir).filePath(".proxy");
+}
+
+bool findProxy(const ClipInfo& clip, ClipInfo& out)
+{
+    const QFileInfo fi(QDir(proxyDirectory(QFileInfo(clip.path).absolutePath())).filePath(clip.fileName));
+    if (!fi.isFile() || fi.size() == 0) return false;
+    out = toClip(fi, clip.date);
+    return true;
+}
+
+bool thumbnailFrame(const QString& path, cv::Size target, cv::Mat& bgr)
+{
+#ifdef CCTV_HAVE_FFMPEG
+    if (keyframeThumbnail(path, target, bgr)) return true;
+#endif
+    // FFmpeg이 없거나 열지 못한 파일: OpenCV로 전체 디코딩 후 축소
+    cv::VideoCapture cap(path.toStdString());
+    if (!cap.isOpened()) return false;
+    cv::Mat frame;
+    for (int i = 0; i < 10; ++i) cap.read(frame);   // 첫 프레임은 검거나 흐린 경우가 많아 조금 건너뜀
+    if (frame.empty()) cap.read(frame);
+    if (frame.empty()) return false;
+
+    cv::resize(frame, bgr, fitInside(frame.size(), target), 0, 0, cv::INTER_AREA);
+    return true;
+}
+
+} // namespace ClipCatalog
@@ -0,0 +1,47 @@
+#ifndef CLIPCATALOG_H
+#define CLIPCATALOG_H
+
+#include <QDate>
+#include <QDateTime>
+#include <QList>
+#include <QMap>
+#include <QString>
+#include <opencv2/core.hpp>
+
+// 녹화 폴더의 클립 목록. Tab2 갤러리와 스트림 서버의 /api/clips가 같은 규칙을 씁니다.
+struct ClipInfo
+{
+    QString   fileName;     // detect_yyyyMMdd_HHmmss.mp4
+    QString   path;         // 절대 경로
+    QDate     date;         // 파일 이름의 날짜
+    qint64    size = 0;
+    QDateTime modified;
+};
+
+namespace ClipCatalog {
+
+bool isVideoFile(const QString& fileName);
+// 파일 이름(detect_yyyyMMdd_...)의 날짜. 규칙에 맞지 않으면 무효
+QDate dateFromName(const QString& fileName);
+
+// 파일 이름(detect_yyyyMMdd_...)의 날짜로 묶은 클립. 각 날짜 안은 이름 역순(최신 먼저)
+QMap<QDate, QList<ClipInfo>> scan(const QString& dir);
+
+// dir 바로 아래의 클립 하나. 경로 구분자/숨김 파일/동영상이 아닌 이름은 거부
+bool find(const QString& dir, const QString& fileName, ClipInfo& out);
+
+// 녹화기가 클립과 함께 쓰는 저해상도 프록시 폴더 (<dir>/.proxy, 숨김 → 목록에 안 나옴)
+QString proxyDirectory(const QString& dir);
+// clip의 프록시가 있으면 그 파일 정보 (이름/날짜는 원본과 같음)
+bool findProxy(const ClipInfo& clip, ClipInfo& out);
+
+// 화면비를 유지하며 target 안에 들어가는 크기
+cv::Size fitInside(cv::Size source, cv::Size target);
+
+// 클립 앞부분의 한 장을 target 안에 맞게 축소한 BGR 프레임.
+// FFmpeg이 있으면 첫 키프레임만 디코딩해 바로 축소하고, 없으면 OpenCV로 약 10프레임 뒤를 가져옴
+bool thumbnailFrame(const QString& path, cv::Size target, cv::Mat& bgr);
+
+} // namespace ClipCatalog
+
+#endif // CLIPCATALOG_H
@@ -0,0 +1,363 @@
+#include "clipindex.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QStringList>
+#include <QVariant>
+#include <algorithm>
+#include <atomic>
+
+namespace {
+constexpr int BUSY_TIMEOUT_MS = 2000;   // 다른 스레드가 쓰는 중이면 이만큼 기다림
+constexpr int SCHEMA_VERSION = 1;      // PRAGMA user_version. 1: 움직임 검색
+constexpr int HIT_GAP_S      = 2;      // 이보다 짧게 끊긴 초들은 검색 결과 한 건으로
+
+const char* const DB_FILE = ".clips.sqlite";   // 숨김 파일 → 갤러리/클립 서버 목록에 안 나옴
+
+const char* const CLIP_COLUMNS = "file_name, day, size, modified_ms";
+
+// Query 조건. 바인딩 이름 :from/:to/:snapshot
+QStringList queryConditions(const ClipIndex::Query& query)
+{
+    QStringList where;
+    if (query.from.isValid())  where << "day >= :from";
+    if (query.to.isValid())    where << "day <= :to";
+    if (query.snapshot >= 0)   where << "rowid <= :snapshot";
+    return where;
+}
+
+QString whereClause(const QStringList& conditions)
+{
+    return conditions.isEmpty() ? QString() : " WHERE " + conditions.join(" AND ");
+}
+
+void bindQuery(QSqlQuery& q, const ClipIndex::Query& query)
+{
+    if (query.from.isValid())  q.bindValue(":from", query.from.toString(Qt::ISODate));
+    if (query.to.isValid())    q.bindValue(":to", query.to.toString(Qt::ISODate));
+    if (query.snapshot >= 0)   q.bindValue(":snapshot", query.snapshot);
+}
+}
+
+ClipIndex::ClipIndex(const QString& clipDir)
+    : m_dir(clipDir)
+{
+    static std::atomic_int serial{0};
+    m_connection = QStringLiteral("cctv-clipindex-%1").arg(++serial);
+
+    QDir().mkpath(m_dir);
+    m_db = QSqlDatabase::addDatabase("QSQLITE", m_connection);
+    m_db.setDatabaseName(QDir(m_dir).filePath(DB_FILE));
+    m_db.setConnectOptions(QStringLiteral("QSQLITE_BUSY_TIMEOUT=%1").arg(BUSY_TIMEOUT_MS));
+    if (!m_db.open()) {
+        qWarning() << "[ClipIndex] open failed:" << m_db.lastError().text();
+        return;
+    }
+
+    m_open = exec("PRAGMA journal_mode=WAL")
+          && exec("PRAGMA synchronous=NORMAL")
+          && exec("CREATE TABLE IF NOT EXISTS clips ("
+                  " file_name   TEXT PRIMARY KEY,"
+                  " day         TEXT NOT NULL,"        // 파일 이름의 날짜 (yyyy-MM-dd)
+                  " size        INTEGER NOT NULL,"
+                  " modified_ms INTEGER NOT NULL,"
+                  " start_ms    INTEGER,"
+                  " end_ms      INTEGER,"
+                  " duration_ms INTEGER,"
+                  " peak_area   REAL,"
+                  " thumb_key   TEXT)")
+          && exec("CREATE INDEX IF NOT EXISTS clips_by_day ON clips(day DESC, file_name DESC)")
+          && migrate();
+}
+
+// 예전 버전이 만든 파일에 열을 추가. 두 스레드가 동시에 열 수 있으므로 쓰기 잠금을 잡은 뒤 버전을 확인
+bool ClipIndex::migrate()
+{
+    if (!exec("BEGIN IMMEDIATE")) return false;
+    QSqlQuery q(m_db);
+    if (!q.exec("PRAGMA user_version") || !q.next()) {
+        exec("ROLLBACK");
+        return false;
+    }
+    const int version = q.value(0).toInt();
+    q.finish();
+
+    bool ok = true;
+    if (version < 1) {
+        // 칸 비트맵은 64비트 정수 3개 (SQLite의 & 연산으로 바로 비교)
+        ok = exec("ALTER TABLE clips ADD COLUMN cells_a INTEGER")
+          && exec("ALTER TABLE clips ADD COLUMN cells_b INTEGER")
+          && exec("ALTER TABLE clips ADD COLUMN cells_c INTEGER")
+          && exec("CREATE TABLE motion_cells ("
+                  " file_name TEXT NOT NULL,"
+                  " second    INTEGER NOT NULL,"       // 클립 안의 초
+                  " cells_a   INTEGER NOT NULL,"
+                  " cells_b   INTEGER NOT NULL,"
+                  " cells_c   INTEGER NOT NULL,"
+                  " PRIMARY KEY (file_name, second)) WITHOUT ROWID")
+          && exec("CREATE INDEX clips_by_start ON clips(start_ms)");
+    }
+    if (ok && version < SCHEMA_VERSION) ok = exec(QStringLiteral("PRAGMA user_version = %1").arg(SCHEMA_VERSION));
+    if (!ok) {
+        exec("ROLLBACK");
+        return false;
+    }
+    return exec("COMMIT");
+}
+
+ClipIndex::~ClipIndex()
+{
+    m_db.close();
+    m_db = QSqlDatabase();   // 연결을 지우기 전에 핸들을 놓아야 함
+    QSqlDatabase::removeDatabase(m_connection);
+}
+
+bool ClipIndex::exec(const QString& sql)
+{
+    QSqlQuery q(m_db);
+    if (q.exec(sql)) return true;
+    qWarning() << "[ClipIndex]" << sql << "failed:" << q.lastError().text();
+    return false;
+}
+
+bool ClipIndex::addRecording(const ClipInfo& clip, const Recording& rec)
+{
+    if (!m_open) return false;
+    QSqlQuery q(m_db);
+    // REPLACE는 줄을 지우고 새로 넣어 rowid가 바뀌므로 UPSERT로 (Query::snapshot 유지)
+    q.prepare("INSERT INTO clips"
+              " (file_name, day, size, modified_ms, start_ms, end_ms, duration_ms, peak_area, thumb_key)"
+              " VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)"
+              " ON CONFLICT(file_name) DO UPDATE SET day = excluded.day, size = excluded.size,"
+              " modified_ms = excluded.modified_ms, start_ms = excluded.start_ms, end_ms = excluded.end_ms,"
+              " duration_ms = excluded.duration_ms, peak_area = excluded.peak_area, thumb_key = excluded.thumb_key");
+    q.addBindValue(clip.fileName);
+    q.addBindValue(clip.date.toString(Qt::ISODate));
+    q.addBindValue(clip.size);
+    q.addBindValue(clip.modified.toMSecsSinceEpoch());
+    q.addBindValue(rec.start.toMSecsSinceEpoch());
+    q.addBindValue(rec.end.toMSecsSinceEpoch());
+    q.addBindValue(rec.start.msecsTo(rec.end));
+    q.addBindValue(rec.peakArea);
+    q.addBindValue(QString::fromLatin1(rec.thumbKey));
+    if (q.exec()) return true;
+    qWarning() << "[ClipIndex] addRecording failed:" << q.lastError().text();
+    return false;
+}
+
+bool ClipIndex::upsert(const ClipInfo& clip)
+{
+    if (!m_open || !clip.date.isValid()) return false;
+    QSqlQuery q(m_db);
+    q.prepare("INSERT INTO clips (file_name, day, size, modified_ms) VALUES (?, ?, ?, ?)"
+              " ON CONFLICT(file_name) DO UPDATE SET size = excluded.size, modified_ms = excluded.modified_ms");
+    q.addBindValue(clip.fileName);
+    q.addBindValue(clip.date.toString(Qt::ISODate));
+    q.addBindValue(clip.size);
+    q.addBindValue(clip.modified.toMSecsSinceEpoch());
+    if (q.exec()) return true;
+    qWarning() << "[ClipIndex] upsert failed:" << q.lastError().text();
+    return false;
+}
+
+bool ClipIndex::remove(const QString& fileName)
+{
+    if (!m_open) return false;
+    QSqlQuery q(m_db);
+    q.prepare("DELETE FROM motion_cells WHERE file_name = ?");
+    q.addBindValue(fileName);
+    if (!q.exec()) return false;
+    q.prepare("DELETE FROM clips WHERE file_name = ?");
+    q.addBindValue(fileName);
+    return q.exec();
+}
+
+bool ClipIndex::update(const QList<ClipInfo>& added, const QList<ClipInfo>& removed)
+{
+    if (!m_open) return false;
+    if (added.isEmpty() && removed.isEmpty()) return true;
+    if (!exec("BEGIN IMMEDIATE")) return false;
+    bool ok = true;
+    for (int i = 0; ok && i < removed.size(); ++i) ok = remove(removed.at(i).fileName);
+    for (int i = 0; ok && i < added.size(); ++i) {
+        if (added.at(i).date.isValid()) ok = upsert(added.at(i));
+    }
+    if (!ok) {
+        qWarning() << "[ClipIndex] update failed, rolling back";
+        exec("ROLLBACK");
+        return false;
+    }
+    return exec("COMMIT");
+}
+
+bool ClipIndex::setMotion(const QString& fileName, const MotionTrack& track)
+{
+    if (!m_open) return false;
+    const QList<QPair<int, MotionCells>> seconds = track.cellsPerSecond();
+    MotionCells whole;
+    for (const auto& s : seconds) whole |= s.second;
+
+    if (!exec("BEGIN IMMEDIATE")) return false;
+    QSqlQuery q(m_db);
+    q.prepare("DELETE FROM motion_cells WHERE file_name = ?");
+    q.addBindValue(fileName);
+    bool ok = q.exec();
+
+    q.prepare("INSERT INTO motion_cells (file_name, second, cells_a, cells_b, cells_c) VALUES (?, ?, ?, ?, ?)");
+    for (int i = 0; ok && i < seconds.size(); ++i) {
+        q.addBindValue(fileName);
+        q.addBindValue(seconds.at(i).first);
+        for (quint64 word : seconds.at(i).second.bits) q.addBindValue(qint64(word));
+        ok = q.exec();
+    }
+
+    if (ok) {
+        q.prepare("UPDATE clips SET cells_a = ?, cells_b = ?, cells_c = ? WHERE file_name = ?");
+        for (quint64 word : whole.bits) q.addBindValue(qint64(word));
+        q.addBindValue(fileName);
+        ok = q.exec();
+    }
+    if (!ok) {
+        qWarning() << "[ClipIndex] setMotion failed:" << q.lastError().text();
+        exec("ROLLBACK");
+        return false;
+    }
+    return exec("COMMIT");
+}
+
+qint64 ClipIndex::snapshot() const
+{
+    if (!m_open) return -1;
+    QSqlQuery q(m_db);
+    if (!q.exec("SELECT COALESCE(MAX(rowid), 0) FROM clips") || !q.next()) return -1;
+    return q.value(0).toLongLong();
+}
+
+QList<QPair<QDate, int>> ClipIndex::days(const Query& query) const
+{
+    QList<QPair<QDate, int>> out;
+    if (!m_open) return out;
+    QSqlQuery q(m_db);
+    q.setForwardOnly(true);
+    q.prepare("SELECT day, COUNT(*) FROM clips" + whereClause(queryConditions(query))
+              + " GROUP BY day ORDER BY day DESC");
+    bindQuery(q, query);
+    if (!q.exec()) return out;
+    while (q.next()) out.append({QDate::fromString(q.value(0).toString(), Qt::ISODate), q.value(1).toInt()});
+    return out;
+}
+
+QList<ClipInfo> ClipIndex::page(const Query& query, const ClipInfo* after, int limit) const
+{
+    QList<ClipInfo> out;
+    if (!m_open) return out;
+    QStringList where = queryConditions(query);
+    if (after) where << "(day < :afterDay OR (day = :sameDay AND file_name < :afterName))";
+
+    QSqlQuery q(m_db);
+    q.setForwardOnly(true);
+    q.prepare(QStringLiteral("SELECT %1 FROM clips").arg(CLIP_COLUMNS) + whereClause(where)
+              + " ORDER BY day DESC, file_name DESC LIMIT :limit");
+    bindQuery(q, query);
+    if (after) {
+        q.bindValue(":afterDay", after->date.toString(Qt::ISODate));
+        q.bindValue(":sameDay", after->date.toString(Qt::ISODate));
+        q.bindValue(":afterName", after->fileName);
+    }
+    q.bindValue(":limit", limit);
+    if (!q.exec()) {
+        qWarning() << "[ClipIndex] page failed:" << q.lastError().text();
+        return out;
+    }
+    out.reserve(limit);
+    while (q.next()) out.append(toClip(q));
+    return out;
+}
+
+QList<ClipInfo> ClipIndex::all(const Query& query) const
+{
+    QList<ClipInfo> out;
+    if (!m_open) return out;
+    QSqlQuery q(m_db);
+    q.setForwardOnly(true);
+    q.prepare(QStringLiteral("SELECT %1 FROM clips").arg(CLIP_COLUMNS) + whereClause(queryConditions(query)));
+    bindQuery(q, query);
+    if (!q.exec()) return out;
+    while (q.next()) out.append(toClip(q));
+    return out;
+}
+
+QList<ClipIndex::MotionHit> ClipIndex::searchMotion(const MotionCells& region, const QDateTime& from,
+                                                    const QDateTime& to, int limit) const
+{
+    QList<MotionHit> hits;
+    if (!m_open || region.isEmpty() || limit <= 0) return hits;
+    const qint64 fromMs = from.toMSecsSinceEpoch();
+    const qint64 toMs   = to.toMSecsSinceEpoch();
+
+    // 시간 범위는 clips_by_start로, 클립 비트맵으로 한 번 더 거른 뒤 초 단위 줄은 기본 키로 읽음
+    QSqlQuery q(m_db);
+    q.setForwardOnly(true);
+    q.prepare("SELECT c.file_name, c.day, c.size, c.modified_ms, c.start_ms, m.second,"
+              " m.cells_a, m.cells_b, m.cells_c"
+              " FROM clips c JOIN motion_cells m ON m.file_name = c.file_name"
+              " WHERE c.start_ms <= ? AND c.end_ms >= ?"
+              " AND ((c.cells_a & ?) != 0 OR (c.cells_b & ?) != 0 OR (c.cells_c & ?) != 0)"
+              " AND ((m.cells_a & ?) != 0 OR (m.cells_b & ?) != 0 OR (m.cells_c & ?) != 0)"
+              " AND c.start_ms + m.second * 1000 BETWEEN ? AND ?"
+              " ORDER BY c.file_name, m.second");
+    q.addBindValue(toMs);
+    q.addBindValue(fromMs);
+    for (int pass = 0; pass < 2; ++pass) {
+        for (quint64 word : region.bits) q.addBindValue(qint64(word));
+    }
+    q.addBindValue(fromMs);
+    q.addBindValue(toMs);
+    if (!q.exec()) {
+        qWarning() << "[ClipIndex] searchMotion failed:" << q.lastError().text();
+        return hits;
+    }
+
+    // 같은 클립에서 가까운 초들은 한 건으로 묶음
+    int lastSecond = 0;
+    while (q.next()) {
+        const QString name = q.value(0).toString();
+        const int second = q.value(5).toInt();
+        MotionCells cells;
+        for (int i = 0; i < MotionCells::WORDS; ++i) cells.bits[i] = quint64(q.value(6 + i).toLongLong());
+        const int score = cells.overlap(region);
+
+        if (!hits.isEmpty() && hits.last().clip.fileName == name && second - lastSecond <= HIT_GAP_S) {
+            hits.last().endMs = (second + 1) * 1000LL;
+            hits.last().score += score;
+        } else {
+            MotionHit hit;
+            hit.clip    = toClip(q);
+            hit.startMs = second * 1000LL;
+            hit.endMs   = hit.startMs + 1000;
+            hit.at      = QDateTime::fromMSecsSinceEpoch(q.value(4).toLongLong() + hit.startMs);
+            hit.score   = score;
+            hits.append(hit);
+        }
+        lastSecond = second;
+    }
+
+    std::sort(hits.begin(), hits.end(), [](const MotionHit& a, const MotionHit& b) {
+        return a.score != b.score ? a.score > b.score : a.at > b.at;
+    });
+    if (hits.size() > limit) hits.resize(limit);
+    return hits;
+}
+
+ClipInfo ClipIndex::toClip(const QSqlQuery& q) const
+{
+    ClipInfo c;
+    c.fileName = q.value(0).toString();
+    c.path     = m_dir + '/' + c.fileName;
+    c.date     = QDate::fromString(q.value(1).toString(), Qt::ISODate);
+    c.size     = q.value(2).toLongLong();
+    c.modified = QDateTime::fromMSecsSinceEpoch(q.value(3).toLongLong());
+    return c;
+}
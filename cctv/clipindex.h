@@ -0,0 +1,90 @@
+#ifndef CLIPINDEX_H
+#define CLIPINDEX_H
+
+#include <QDate>
+#include <QDateTime>
+#include <QList>
+#include <QPair>
+#include <QSqlDatabase>
+#include <QString>
+#include "clipcatalog.h"
+#include "motiontrack.h"
+
+class QSqlQuery;
+
+// 녹화 폴더의 클립 색인 (SQLite, <폴더>/.clips.sqlite).
+// 녹화기가 클립을 마칠 때 한 줄씩 쓰고, 갤러리는 폴더를 훑는 대신 날짜 범위/페이지 단위로 조회합니다.
+// QSqlDatabase 연결은 만든 스레드에서만 쓸 수 있으므로 스레드마다 ClipIndex를 따로 만듭니다
+// (WAL 모드라 녹화 스레드가 쓰는 동안에도 GUI 스레드가 읽을 수 있음).
+// 움직임 검색용으로 클립마다 움직임이 지나간 칸(MotionCells)과 초마다의 칸도 함께 둡니다.
+class ClipIndex
+{
+public:
+    // 녹화기가 아는 추가 정보
+    struct Recording {
+        QDateTime start;
+        QDateTime end;
+        double    peakArea = 0.0;   // 녹화 중 가장 큰 움직임 영역 (픽셀)
+        QByteArray thumbKey;        // ThumbnailCache 키
+    };
+
+    // 움직임 검색 결과 한 건: 클립 안의 [startMs, endMs) 구간
+    struct MotionHit {
+        ClipInfo  clip;
+        QDateTime at;               // 구간 시작의 벽시계 시각
+        qint64    startMs = 0;      // 클립 안의 위치 (플레이어가 이동할 곳)
+        qint64    endMs   = 0;
+        int       score   = 0;      // 영역과 겹친 칸 수의 합 (영역 안 움직임이 많고 길수록 큼)
+    };
+
+    // 조회 범위. snapshot은 그 시점까지 들어간 줄만 보도록 (갤러리가 표를 만든 뒤 녹화기가 추가한 클립 제외)
+    struct Query {
+        QDate  from;                // 무효면 제한 없음
+        QDate  to;
+        qint64 snapshot = -1;       // snapshot()의 값, -1이면 제한 없음
+    };
+
+    explicit ClipIndex(const QString& clipDir);
+    ~ClipIndex();
+    ClipIndex(const ClipIndex&) = delete;
+    ClipIndex& operator=(const ClipIndex&) = delete;
+
+    bool isOpen() const { return m_open; }
+    QString directory() const { return m_dir; }
+
+    // 녹화 완료 (이미 있으면 덮어씀)
+    bool addRecording(const ClipInfo& clip, const Recording& rec);
+    // 폴더에서 발견한 클립 (이미 있으면 크기/수정 시각만 갱신하고 녹화 정보는 유지)
+    bool upsert(const ClipInfo& clip);
+    bool remove(const QString& fileName);
+    // 폴더와 맞춘 차이를 한 트랜잭션으로 (upsert/remove를 여러 건 하면서 커밋은 한 번)
+    bool update(const QList<ClipInfo>& added, const QList<ClipInfo>& removed);
+    // 녹화기의 움직임 기록을 검색 색인에 넣음 (클립 전체 칸 + 초마다 칸, 이미 있으면 교체)
+    bool setMotion(const QString& fileName, const MotionTrack& track);
+
+    // 지금까지 들어간 마지막 줄 (Query::snapshot)
+    qint64 snapshot() const;
+    // 날짜별 클립 수 (최신 날짜 먼저)
+    QList<QPair<QDate, int>> days(const Query& query = {}) const;
+    // 화면 순서(날짜 역순, 이름 역순)로 after 다음부터 limit개 (after가 없으면 처음부터).
+    // OFFSET 대신 (day, file_name) 키로 이어 읽으므로 페이지가 깊어져도 인덱스 탐색 한 번
+    QList<ClipInfo> page(const Query& query, const ClipInfo* after, int limit) const;
+    // 범위 안의 모든 클립 (폴더와 맞춰 볼 때)
+    QList<ClipInfo> all(const Query& query = {}) const;
+    // region을 지나간 움직임을 [from, to] 안에서 찾아 점수 순으로 최대 limit건.
+    // 클립 전체 비트맵으로 먼저 거르고 남은 클립의 초 단위 비트맵만 봄 (동영상은 열지 않음)
+    QList<MotionHit> searchMotion(const MotionCells& region, const QDateTime& from, const QDateTime& to,
+                                  int limit) const;
+
+private:
+    bool exec(const QString& sql);
+    bool migrate();
+    ClipInfo toClip(const QSqlQuery& q) const;
+
+    QString      m_dir;
+    QString      m_connection;
+    QSqlDatabase m_db;
+    bool         m_open = false;
+};
+
+#endif // CLIPINDEX_H
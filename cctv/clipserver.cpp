@@ -0,0 +1,442 @@
+#include "clipserver.h"
+#include "clipcatalog.h"
+#include "clipindex.h"
+#include "httprequest.h"
+#include "jpegencoder.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSet>
+#include <QSocketNotifier>
+#include <QTcpSocket>
+#include <QUrl>
+#include <QDebug>
+
+#ifdef Q_OS_LINUX
+#include <sys/sendfile.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace {
+constexpr int    THUMB_W          = 240;
+constexpr int    THUMB_H          = 135;
+constexpr int    THUMB_QUALITY    = 80;
+constexpr int    THUMB_CACHE_COST = 8 * 1024 * 1024;   // 썸네일 캐시 최대 바이트
+constexpr qint64 SENDFILE_CHUNK   = 4 * 1024 * 1024;   // sendfile() 한 번에 넘기는 최대 바이트
+constexpr qint64 COPY_CHUNK       = 256 * 1024;        // sendfile이 없는 플랫폼의 읽기/쓰기 단위
+constexpr int    LIST_PAGE_CLIPS  = 200;               // /api/clips 기본 페이지 크기
+constexpr int    LIST_MAX_CLIPS   = 1000;
+
+// 크기 + 수정 시각: 녹화가 끝난 파일은 바뀌지 않으므로 이것으로 충분
+QByteArray etagFor(const ClipInfo &clip)
+{
+    return '"' + QByteArray::number(clip.size, 16) + '-'
+           + QByteArray::number(clip.modified.toMSecsSinceEpoch(), 16) + '"';
+}
+
+QByteArray videoMimeType(const QString &fileName)
+{
+    const QString ext = QFileInfo(fileName).suffix().toLower();
+    if (ext == "mp4" || ext == "m4v") return "video/mp4";
+    if (ext == "mov") return "video/quicktime";
+    if (ext == "mkv") return "video/x-matroska";
+    if (ext == "avi") return "video/x-msvideo";
+    if (ext == "wmv") return "video/x-ms-wmv";
+    return "application/octet-stream";
+}
+
+QByteArray connectionValue(bool keepAlive)
+{
+    return keepAlive ? "keep-alive" : "close";
+}
+}
+
+ClipServer::ClipServer(const QString &clipDir, QObject *parent)
+    : QObject(parent), m_clipDir(clipDir), m_index(std::make_unique<ClipIndex>(clipDir))
+{
+    // 동영상 열기/디코딩이 무거우므로 인코딩 워커와 별도로, 적은 수로 제한
+    m_thumbPool.setMaxThreadCount(2);
+    m_thumbCache.setMaxCost(THUMB_CACHE_COST);
+}
+
+ClipServer::~ClipServer()
+{
+    m_thumbPool.clear();
+    m_thumbPool.waitForDone();
+    const QList<QTcpSocket*> sockets = m_transfers.keys();
+    for (QTcpSocket *socket : sockets) endTransfer(socket);
+}
+
+bool ClipServer::handle(QTcpSocket *socket, const HttpRequest &req)
+{
+    if (req.path == "/api/clips") {
+        serveClipList(socket, req);
+        return true;
+    }
+    if (!req.path.startsWith("/clips/")) return false;
+
+    QString name = req.path.mid(7);
+    const bool thumb = name.endsWith("/thumb.jpg");
+    if (thumb) name.chop(10);
+
+    // 녹화 폴더 바로 아래의 동영상 파일만 (경로 이동/숨김 파일 차단)
+    ClipInfo clip;
+    if (!ClipCatalog::find(m_clipDir, name, clip)) {
+        replyError(socket, 404, req.keepAlive());
+        return true;
+    }
+    if (thumb) {
+        serveThumbnail(socket, req, clip);
+        return true;
+    }
+    // 원격 재생은 기본이 프록시 (대역폭). ETag가 파일마다 다르므로 Range/If-Range도 그대로 맞음
+    ClipInfo proxy;
+    if (req.query.queryItemValue("q") != "full" && ClipCatalog::findProxy(clip, proxy)) clip = proxy;
+    serveFile(socket, req, clip);
+    return true;
+}
+
+void ClipServer::socketClosed(QTcpSocket *socket)
+{
+    endTransfer(socket);
+    m_thumbPending.remove(socket);
+    for (auto it = m_thumbWaiters.begin(); it != m_thumbWaiters.end(); ++it) {
+        it.value().removeIf([socket](const ThumbWaiter &w) { return w.socket == socket; });
+    }
+}
+
+void ClipServer::serveClipList(QTcpSocket *socket, const HttpRequest &req)
+{
+    // Tab2 갤러리처럼 최신 날짜/이름부터. 색인을 날짜 범위 + (날짜, 이름) 키로 이어 읽으므로 폴더는 훑지 않음
+    ClipIndex::Query query;
+    query.from = QDate::fromString(req.query.queryItemValue("from"), Qt::ISODate);
+    query.to   = QDate::fromString(req.query.queryItemValue("to"), Qt::ISODate);
+    bool ok = false;
+    int limit = req.query.queryItemValue("limit").toInt(&ok);
+    if (!ok || limit <= 0) limit = LIST_PAGE_CLIPS;
+    limit = qMin(limit, LIST_MAX_CLIPS);
+
+    QList<ClipInfo> clips;
+    QHash<QDate, int> dayCounts;
+    bool more = false;
+    if (m_index->isOpen()) {
+        // 페이지를 넘기는 동안 새로 녹화된 클립이 끼어들지 않도록 첫 페이지의 snapshot을 이어 씀
+        query.snapshot = req.query.queryItemValue("snapshot").toLongLong(&ok);
+        if (!ok || query.snapshot < 0) query.snapshot = m_index->snapshot();
+        ClipInfo after;
+        after.fileName = req.query.queryItemValue("after", QUrl::FullyDecoded);
+        after.date = ClipCatalog::dateFromName(after.fileName);
+        if (!after.fileName.isEmpty() && !after.date.isValid()) {
+            replyError(socket, 400, req.keepAlive());
+            return;
+        }
+        clips = m_index->page(query, after.fileName.isEmpty() ? nullptr : &after, limit + 1);
+        more = clips.size() > limit;
+        if (more) clips.removeLast();
+        for (const auto &day : m_index->days(query)) dayCounts.insert(day.first, day.second);
+    } else {
+        // 색인을 쓸 수 없으면 Tab2처럼 폴더를 훑음 (페이지 없이 전부)
+        const QMap<QDate, QList<ClipInfo>> grouped = ClipCatalog::scan(m_clipDir);
+        for (auto it = grouped.constEnd(); it != grouped.constBegin();) {
+            --it;
+            if ((query.from.isValid() && it.key() < query.from) || (query.to.isValid() && it.key() > query.to)) continue;
+            clips.append(it.value());
+            dayCounts.insert(it.key(), it.value().size());
+        }
+    }
+
+    // 클립마다 stat하지 않도록 프록시 이름은 한 번에 (숨김 = 아직 쓰는 중은 빠짐)
+    const QStringList proxyNames = QDir(ClipCatalog::proxyDirectory(m_clipDir)).entryList(QDir::Files);
+    const QSet<QString> proxies(proxyNames.cbegin(), proxyNames.cend());
+
+    QJsonArray days;
+    QJsonArray dayClips;
+    for (int i = 0; i < clips.size(); ++i) {
+        const ClipInfo &clip = clips.at(i);
+        const QString url = "/clips/" + QString::fromLatin1(QUrl::toPercentEncoding(clip.fileName));
+        dayClips << QJsonObject {
+            { "name", clip.fileName },
+            { "size", clip.size },
+            { "modified", clip.modified.toString(Qt::ISODate) },
+            { "url", url },                  // 프록시가 있으면 프록시
+            { "full", url + "?q=full" },     // 항상 원본
+            { "proxy", proxies.contains(clip.fileName) },
+            { "thumb", url + "/thumb.jpg" },
+        };
+        if (i + 1 == clips.size() || clips.at(i + 1).date != clip.date) {
+            days << QJsonObject {
+                { "date", clip.date.toString(Qt::ISODate) },
+                { "count", dayCounts.value(clip.date, int(dayClips.size())) },   // 이 페이지 밖까지 포함한 그날 전체
+                { "clips", dayClips },
+            };
+            dayClips = QJsonArray();
+        }
+    }
+    QJsonObject result { { "days", days } };
+    if (query.snapshot >= 0) result.insert("snapshot", query.snapshot);
+    if (more) result.insert("next", clips.last().fileName);   // 다음 페이지: ?after=<next>&snapshot=<snapshot>
+    const QByteArray body = QJsonDocument(result).toJson(QJsonDocument::Compact);
+
+    const bool keepAlive = req.keepAlive();
+    socket->write(Http::responseHead(200, {
+        { "Content-Type", "application/json; charset=utf-8" },
+        { "Content-Length", QByteArray::number(body.size()) },
+        { "Cache-Control", "no-cache" },
+        { "Access-Control-Allow-Origin", "*" },   // 파일로 연 index.html에서도 fetch 가능하도록
+        { "Connection", connectionValue(keepAlive) },
+    }));
+    if (req.method != "HEAD") socket->write(body);
+    emit responseFinished(socket, keepAlive);
+}
+
+// ---- 썸네일 ----
+
+void ClipServer::serveThumbnail(QTcpSocket *socket, const HttpRequest &req, const ClipInfo &clip)
+{
+    ThumbWaiter w;
+    w.socket = socket;
+    w.etag = etagFor(clip);
+    w.keepAlive = req.keepAlive();
+    w.headOnly = (req.method == "HEAD");
+
+    if (req.header("if-none-match") == w.etag) {
+        socket->write(Http::responseHead(304, {
+            { "ETag", w.etag },
+            { "Connection", connectionValue(w.keepAlive) },
+        }));
+        emit responseFinished(socket, w.keepAlive);
+        return;
+    }
+
+    // 파일이 바뀌면(크기/수정 시각) 키도 바뀌어 예전 썸네일은 자연히 밀려남
+    const QString key = clip.fileName + '|' + QString::fromLatin1(w.etag);
+    if (const QByteArray *cached = m_thumbCache.object(key)) {
+        answerThumbnail(w, *cached);
+        return;
+    }
+
+    // 같은 클립을 기다리는 요청은 한 번만 생성해서 함께 응답
+    QList<ThumbWaiter> &waiters = m_thumbWaiters[key];
+    waiters << w;
+    m_thumbPending.insert(socket);
+    if (waiters.size() > 1) return;
+
+    const QString path = clip.path;
+    const QByteArray diskKey = ThumbnailCache::key(clip.path, clip.size, clip.modified);
+    m_thumbPool.start([this, key, path, diskKey]() {
+        // 갤러리가 이미 만든 썸네일이 있으면 동영상을 열지 않음
+        QByteArray jpeg;
+        if (!m_diskCache.loadJpeg(diskKey, jpeg)) {
+            cv::Mat bgr;
+            if (ClipCatalog::thumbnailFrame(path, cv::Size(THUMB_W, THUMB_H), bgr)) {
+                JpegEncoder::Options opt;
+                opt.quality = THUMB_QUALITY;
+                JpegEncoder::threadLocal().encode(bgr, opt, jpeg);
+                if (!jpeg.isEmpty()) m_diskCache.storeJpeg(diskKey, jpeg);
+            }
+        }
+        QMetaObject::invokeMethod(this, [this, key, jpeg]() {
+            onThumbnailEncoded(key, jpeg);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void ClipServer::onThumbnailEncoded(const QString &key, const QByteArray &jpeg)
+{
+    const QList<ThumbWaiter> waiters = m_thumbWaiters.take(key);
+    for (const ThumbWaiter &w : waiters) m_thumbPending.remove(w.socket);
+    if (jpeg.isEmpty()) {
+        qWarning() << "[ClipServer] thumbnail failed:" << key;
+        for (const ThumbWaiter &w : waiters) {
+            if (w.socket) replyError(w.socket, 404, w.keepAlive);
+        }
+        return;
+    }
+    m_thumbCache.insert(key, new QByteArray(jpeg), jpeg.size());
+    for (const ThumbWaiter &w : waiters) answerThumbnail(w, jpeg);
+}
+
+void ClipServer::answerThumbnail(const ThumbWaiter &w, const QByteArray &jpeg)
+{
+    if (!w.socket) return;
+    w.socket->write(Http::responseHead(200, {
+        { "Content-Type", "image/jpeg" },
+        { "Content-Length", QByteArray::number(jpeg.size()) },
+        { "ETag", w.etag },
+        { "Cache-Control", "max-age=3600" },
+        { "Access-Control-Allow-Origin", "*" },
+        { "Connection", connectionValue(w.keepAlive) },
+    }));
+    if (!w.headOnly) w.socket->write(jpeg);
+    emit responseFinished(w.socket, w.keepAlive);
+}
+
+// ---- 동영상 파일 (Range + sendfile) ----
+
+void ClipServer::serveFile(QTcpSocket *socket, const HttpRequest &req, const ClipInfo &clip)
+{
+    const bool keepAlive = req.keepAlive();
+    const QByteArray etag = etagFor(clip);
+    const QByteArray lastModified = Http::date(clip.modified);
+
+    qint64 first = 0, last = clip.size - 1;
+    bool satisfiable = true;
+    bool ranged = req.byteRange(clip.size, &first, &last, &satisfiable);
+    // If-Range가 현재 파일과 다르면 Range를 무시하고 전체를 보냄
+    const QByteArray ifRange = req.header("if-range");
+    if (ranged && !ifRange.isEmpty() && ifRange != etag && ifRange != lastModified) {
+        ranged = false;
+        first = 0;
+        last = clip.size - 1;
+    }
+    if (ranged && !satisfiable) {
+        replyError(socket, 416, keepAlive, { { "Content-Range", "bytes */" + QByteArray::number(clip.size) } });
+        return;
+    }
+    if (!ranged && req.header("if-none-match") == etag) {
+        socket->write(Http::responseHead(304, {
+            { "ETag", etag },
+            { "Connection", connectionValue(keepAlive) },
+        }));
+        emit responseFinished(socket, keepAlive);
+        return;
+    }
+
+    auto *file = new QFile(clip.path);
+    if (!file->open(QIODevice::ReadOnly)) {
+        delete file;
+        replyError(socket, 404, keepAlive);
+        return;
+    }
+
+    const qint64 length = clip.size > 0 ? last - first + 1 : 0;
+    QList<QPair<QByteArray, QByteArray>> headers {
+        { "Content-Type", videoMimeType(clip.fileName) },
+        { "Content-Length", QByteArray::number(length) },
+        { "Accept-Ranges", "bytes" },
+        { "ETag", etag },
+        { "Last-Modified", lastModified },
+        { "Access-Control-Allow-Origin", "*" },
+        { "Connection", connectionValue(keepAlive) },
+    };
+    if (ranged) {
+        headers.append({ "Content-Range", "bytes " + QByteArray::number(first) + '-' + QByteArray::number(last)
+                                          + '/' + QByteArray::number(clip.size) });
+    }
+    socket->write(Http::responseHead(ranged ? 206 : 200, headers));
+    if (req.method == "HEAD" || length == 0) {
+        delete file;
+        emit responseFinished(socket, keepAlive);
+        return;
+    }
+
+    Transfer t;
+    t.file = file;
+    t.offset = first;
+    t.remaining = length;
+    t.keepAlive = keepAlive;
+#ifdef Q_OS_LINUX
+    // QTcpSocket이 같은 fd에 이미 notifier를 갖고 있으므로 dup한 fd로 쓰기 가능 여부를 감시
+    t.fd = ::dup(int(socket->socketDescriptor()));
+    if (t.fd < 0) {
+        delete file;
+        socket->abort();
+        return;
+    }
+    t.writable = new QSocketNotifier(t.fd, QSocketNotifier::Write, this);
+    t.writable->setEnabled(false);
+    connect(t.writable, &QSocketNotifier::activated, this, [this, socket]() {
+        auto it = m_transfers.find(socket);
+        if (it == m_transfers.end()) return;
+        it.value().writable->setEnabled(false);
+        pump(socket);
+    });
+#else
+    file->seek(first);
+#endif
+    // 응답 헤더(소켓 쓰기 버퍼)가 다 나간 뒤에 본문을 시작
+    t.bytesWritten = connect(socket, &QTcpSocket::bytesWritten, this, [this, socket]() { pump(socket); });
+    m_transfers.insert(socket, t);
+    socket->flush();
+    pump(socket);
+}
+
+void ClipServer::pump(QTcpSocket *socket)
+{
+    auto it = m_transfers.find(socket);
+    if (it == m_transfers.end()) return;
+    Transfer &t = it.value();
+
+#ifdef Q_OS_LINUX
+    // 본문은 소켓 쓰기 버퍼를 거치지 않고 커널이 파일 → 소켓으로 바로 복사 (유저 공간 복사 없음)
+    if (socket->bytesToWrite() > 0) return;
+    while (t.remaining > 0) {
+        off_t off = t.offset;
+        const ssize_t n = ::sendfile(t.fd, t.file->handle(), &off, size_t(qMin(t.remaining, SENDFILE_CHUNK)));
+        if (n > 0) {
+            t.offset += n;
+            t.remaining -= n;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            t.writable->setEnabled(true);   // 소켓 버퍼에 자리가 나면 이어서
+            return;
+        }
+        // 파일이 줄었거나(n == 0) 연결 오류: Content-Length를 지킬 수 없으므로 연결을 끊음
+        qWarning() << "[ClipServer] sendfile failed:" << (n < 0 ? qt_error_string(errno) : QStringLiteral("EOF"));
+        socket->abort();   // disconnected → socketClosed()에서 정리 (t는 더 이상 쓰지 않음)
+        return;
+    }
+#else
+    while (t.remaining > 0 && socket->bytesToWrite() < COPY_CHUNK) {
+        const QByteArray chunk = t.file->read(qMin(t.remaining, COPY_CHUNK));
+        if (chunk.isEmpty()) {
+            socket->abort();
+            return;
+        }
+        socket->write(chunk);
+        t.remaining -= chunk.size();
+    }
+    if (t.remaining > 0 || socket->bytesToWrite() > 0) return;
+#endif
+
+    const bool keepAlive = t.keepAlive;
+    endTransfer(socket);
+    emit responseFinished(socket, keepAlive);
+}
+
+void ClipServer::endTransfer(QTcpSocket *socket)
+{
+    auto it = m_transfers.find(socket);
+    if (it == m_transfers.end()) return;
+    Transfer t = it.value();
+    m_transfers.erase(it);
+
+    disconnect(t.bytesWritten);
+    delete t.writable;
+#ifdef Q_OS_LINUX
+    if (t.fd >= 0) ::close(t.fd);
+#endif
+    delete t.file;
+}
+
+void ClipServer::replyError(QTcpSocket *socket, int status, bool keepAlive,
+                            const QList<QPair<QByteArray, QByteArray>> &extraHeaders)
+{
+    const QByteArray body = Http::reasonPhrase(status) + "\n";
+    QList<QPair<QByteArray, QByteArray>> headers {
+        { "Content-Type", "text/plain; charset=utf-8" },
+        { "Content-Length", QByteArray::number(body.size()) },
+        { "Connection", connectionValue(keepAlive) },
+    };
+    headers << extraHeaders;
+    socket->write(Http::responseHead(status, headers));
+    socket->write(body);
+    emit responseFinished(socket, keepAlive);
+}
@@ -0,0 +1,83 @@
+#ifndef CLIPSERVER_H
+#define CLIPSERVER_H
+
+#include <QObject>
+#include <QHash>
+#include <QCache>
+#include <QList>
+#include <QPointer>
+#include <QSet>
+#include <QThreadPool>
+#include <memory>
+#include "thumbnailcache.h"
+
+class QFile;
+class QSocketNotifier;
+class QTcpSocket;
+struct HttpRequest;
+struct ClipInfo;
+class ClipIndex;
+
+// 스트림 서버 포트에서 녹화 클립을 원격으로 제공합니다 (StreamServer의 네트워크 스레드에서 동작).
+//   GET /api/clips                  날짜별 클립 목록 (JSON, Tab2 갤러리와 같은 색인/순서).
+//                                   ?from=&to=(yyyy-MM-dd) 날짜 범위, ?limit= 페이지 크기,
+//                                   ?after=<next>&snapshot=<snapshot> 다음 페이지
+//   GET /clips/<name>/thumb.jpg     썸네일 (메모리/디스크 캐시 + ETag)
+//   GET /clips/<name>               MP4 본문. Range 지원, Linux에서는 sendfile()로 커널 안에서 바로 전송.
+//                                   360p 프록시가 있으면 그것을 보냄 (?q=full이면 원본)
+class ClipServer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ClipServer(const QString &clipDir, QObject *parent = nullptr);
+    ~ClipServer();
+
+    // 이 요청을 처리했으면 true (응답이 끝나면 responseFinished가 옴)
+    bool handle(QTcpSocket *socket, const HttpRequest &req);
+    // 파일 전송/썸네일 생성 중인 연결은 다음 요청을 읽지 않고 기다려야 함
+    bool isBusy(QTcpSocket *socket) const { return m_transfers.contains(socket) || m_thumbPending.contains(socket); }
+    // 소켓이 끊기거나 지워지기 전에 호출 (진행 중인 전송 정리)
+    void socketClosed(QTcpSocket *socket);
+
+signals:
+    void responseFinished(QTcpSocket *socket, bool keepAlive);
+
+private:
+    struct Transfer {
+        QFile*           file = nullptr;
+        qint64           offset = 0;
+        qint64           remaining = 0;
+        bool             keepAlive = false;
+        int              fd = -1;                  // 소켓 fd의 dup (QTcpSocket의 notifier와 겹치지 않게)
+        QSocketNotifier* writable = nullptr;
+        QMetaObject::Connection bytesWritten;
+    };
+
+    struct ThumbWaiter {
+        QPointer<QTcpSocket> socket;
+        QByteArray etag;
+        bool keepAlive = false;
+        bool headOnly  = false;
+    };
+
+    void serveClipList(QTcpSocket *socket, const HttpRequest &req);
+    void serveThumbnail(QTcpSocket *socket, const HttpRequest &req, const ClipInfo &clip);
+    void serveFile(QTcpSocket *socket, const HttpRequest &req, const ClipInfo &clip);
+    void onThumbnailEncoded(const QString &key, const QByteArray &jpeg);
+    void answerThumbnail(const ThumbWaiter &w, const QByteArray &jpeg);
+    void pump(QTcpSocket *socket);
+    void endTransfer(QTcpSocket *socket);
+    void replyError(QTcpSocket *socket, int status, bool keepAlive,
+                    const QList<QPair<QByteArray, QByteArray>> &extraHeaders = {});
+
+    QString      m_clipDir;
+    std::unique_ptr<ClipIndex> m_index;             // 네트워크 스레드 전용 연결 (갤러리와 같은 파일)
+    QThreadPool  m_thumbPool;                       // 썸네일 생성 (동영상 열기/디코딩)
+    QCache<QString, QByteArray> m_thumbCache;       // 메모리 캐시. 키: 이름|크기|수정시각, 비용: 바이트
+    ThumbnailCache m_diskCache;                     // 갤러리와 공유하는 디스크 캐시
+    QHash<QString, QList<ThumbWaiter>> m_thumbWaiters;
+    QSet<QTcpSocket*> m_thumbPending;               // m_thumbWaiters에 들어 있는 연결
+    QHash<QTcpSocket*, Transfer> m_transfers;
+};
+
+#endif // CLIPSERVER_H
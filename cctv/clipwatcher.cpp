@@ -0,0 +1,53 @@
+#include "clipwatcher.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QSet>
+
+namespace {
+constexpr int RESCAN_DEBOUNCE_MS = 500;   // 이름 바꾸기/복사처럼 연달아 오는 변경을 한 번에 처리
+}
+
+ClipWatcher::ClipWatcher(QObject *parent)
+    : QObject(parent)
+{
+    m_debounce.setSingleShot(true);
+    m_debounce.setInterval(RESCAN_DEBOUNCE_MS);
+    connect(&m_debounce, &QTimer::timeout, this, &ClipWatcher::rescan);
+    connect(&m_fs, &QFileSystemWatcher::directoryChanged, &m_debounce, qOverload<>(&QTimer::start));
+}
+
+void ClipWatcher::setDirectory(const QString& dir, const QList<ClipInfo>& known)
+{
+    m_debounce.stop();
+    if (!m_fs.directories().isEmpty()) m_fs.removePaths(m_fs.directories());
+    m_dir = dir;
+    m_known.clear();
+    m_known.reserve(known.size());
+    for (const ClipInfo& c : known) m_known.insert(c.fileName, c);
+    if (!m_fs.addPath(dir)) qWarning() << "[ClipWatcher] cannot watch" << dir;
+}
+
+void ClipWatcher::rescan()
+{
+    // 숨김 파일(녹화 중)은 QDir::Hidden 없이 나열하면 빠짐
+    const QStringList names = QDir(m_dir).entryList(QDir::Files | QDir::NoDotAndDotDot);
+    const QSet<QString> present(names.cbegin(), names.cend());
+
+    QList<ClipInfo> removed;
+    for (auto it = m_known.cbegin(); it != m_known.cend(); ++it) {
+        if (!present.contains(it.key())) removed << it.value();
+    }
+    for (const ClipInfo& c : std::as_const(removed)) m_known.remove(c.fileName);
+
+    QList<ClipInfo> added;
+    for (const QString& name : names) {
+        if (m_known.contains(name) || !ClipCatalog::isVideoFile(name)) continue;
+        ClipInfo clip;
+        // scan()과 같은 규칙: 이름에 날짜가 없는 파일은 갤러리에 넣지 않음. 빈 파일은 아직 쓰는 중일 수 있음
+        if (!ClipCatalog::find(m_dir, name, clip) || !clip.date.isValid() || clip.size == 0) continue;
+        m_known.insert(name, clip);
+        added << clip;
+    }
+    if (!added.isEmpty() || !removed.isEmpty()) emit clipsChanged(added, removed);
+}
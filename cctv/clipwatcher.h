@@ -0,0 +1,38 @@
+#ifndef CLIPWATCHER_H
+#define CLIPWATCHER_H
+
+#include <QObject>
+#include <QDate>
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QTimer>
+#include "clipcatalog.h"
+
+// 녹화 폴더 감시. 폴더가 바뀌면 잠시 모았다가(디바운스) 이름 목록만 다시 읽어
+// 이전 목록과의 차이(추가/삭제된 클립)만 한 번에 알립니다. 그대로인 파일은 stat도 하지 않음.
+// 녹화 중인 파일은 숨김 이름(.detect_...)이라 목록에 나타나지 않고, 완성되어 이름이 바뀔 때 추가됩니다.
+class ClipWatcher : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ClipWatcher(QObject *parent = nullptr);
+
+    // 감시 시작. known은 호출자가 이미 알고 있는 클립 (폴더를 훑은 결과나 클립 색인)
+    void setDirectory(const QString& dir, const QList<ClipInfo>& known);
+    // 폴더 변경이 없어도 곧 한 번 훑음 (known과 실제 폴더가 다를 수 있을 때)
+    void rescanSoon() { m_debounce.start(); }
+
+signals:
+    // 한 번 훑을 때마다 한 번 (처음 훑을 때는 앱이 꺼져 있던 동안의 차이 전체일 수 있음)
+    void clipsChanged(const QList<ClipInfo>& added, const QList<ClipInfo>& removed);
+
+private:
+    void rescan();
+
+    QString                 m_dir;
+    QFileSystemWatcher      m_fs;
+    QTimer                  m_debounce;
+    QHash<QString, ClipInfo> m_known;     // 파일 이름 → 클립
+};
+
+#endif // CLIPWATCHER_H
@@ -0,0 +1,231 @@
+#include "fmp4encoder.h"
+
+#include <QDebug>
+#include <opencv2/imgproc.hpp>
+
+#ifdef CCTV_HAVE_FFMPEG
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/opt.h>
+}
+
+namespace {
+constexpr int MUX_IO_BUFFER = 64 * 1024;
+
+// FFmpeg 6.1(libavformat 61)부터 write 콜백의 버퍼가 const
+#if LIBAVFORMAT_VERSION_MAJOR >= 61
+int muxerWrite(void* opaque, const uint8_t* buf, int size)
+#else
+int muxerWrite(void* opaque, uint8_t* buf, int size)
+#endif
+{
+    static_cast<QByteArray*>(opaque)->append(reinterpret_cast<const char*>(buf), size);
+    return size;
+}
+
+// extradata(avcC 또는 Annex B)의 SPS에서 profile/constraint/level을 읽어 "avc1.PPCCLL" 생성
+QString avcCodecString(const uint8_t* data, int size)
+{
+    auto hex = [](uint8_t v) { return QString::asprintf("%02x", v); };
+    if (size >= 4 && data[0] == 1) {   // avcC
+        return "avc1." + hex(data[1]) + hex(data[2]) + hex(data[3]);
+    }
+    for (int i = 0; i + 4 < size; ++i) {   // Annex B: 00 00 01 [nal] [profile] [constraint] [level]
+        if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1 && (data[i + 3] & 0x1F) == 7 && i + 6 < size) {
+            return "avc1." + hex(data[i + 4]) + hex(data[i + 5]) + hex(data[i + 6]);
+        }
+    }
+    return QStringLiteral("avc1.42e01f");   // 알 수 없으면 Baseline 3.1로 가정
+}
+}
+#endif
+
+Fmp4Encoder::Fmp4Encoder(const Options& opt)
+    : m_opt(opt)
+{
+}
+
+Fmp4Encoder::~Fmp4Encoder()
+{
+    close();
+}
+
+bool Fmp4Encoder::isAvailable()
+{
+#ifdef CCTV_HAVE_FFMPEG
+    return avcodec_find_encoder_by_name("libx264") || avcodec_find_encoder(AV_CODEC_ID_H264);
+#else
+    return false;
+#endif
+}
+
+#ifdef CCTV_HAVE_FFMPEG
+
+bool Fmp4Encoder::open(int width, int height)
+{
+    close();
+
+    const AVCodec* codec = avcodec_find_encoder_by_name("libx264");
+    if (!codec) codec = avcodec_find_encoder(AV_CODEC_ID_H264);
+    if (!codec) return false;
+
+    m_codec = avcodec_alloc_context3(codec);
+    m_codec->width        = width;
+    m_codec->height       = height;
+    m_codec->pix_fmt      = AV_PIX_FMT_YUV420P;
+    m_codec->time_base    = AVRational{1, 1000};          // 밀리초 타임스탬프
+    m_codec->framerate    = AVRational{m_opt.fps, 1};
+    m_codec->gop_size     = m_opt.gopFrames;
+    m_codec->max_b_frames = 0;                             // 라이브: 재정렬 지연 없음
+    m_codec->bit_rate     = int64_t(m_opt.bitrateKbps) * 1000;
+    m_codec->rc_max_rate  = m_codec->bit_rate;
+    m_codec->rc_buffer_size = int(m_codec->bit_rate);      // 약 1초 VBV
+    m_codec->flags       |= AV_CODEC_FLAG_GLOBAL_HEADER;   // MP4 avcC에 SPS/PPS
+    av_opt_set(m_codec->priv_data, "preset", "veryfast", 0);
+    av_opt_set(m_codec->priv_data, "tune", "zerolatency", 0);
+    av_opt_set(m_codec->priv_data, "profile", "main", 0);
+    av_opt_set(m_codec->priv_data, "forced-idr", "1", 0);  // requestKeyframe()가 IDR이 되도록
+
+    if (avcodec_open2(m_codec, codec, nullptr) < 0) {
+        qWarning() << "[Fmp4Encoder] avcodec_open2 failed for" << codec->name;
+        close();
+        return false;
+    }
+
+    if (avformat_alloc_output_context2(&m_mux, nullptr, "mp4", nullptr) < 0 || !m_mux) {
+        close();
+        return false;
+    }
+    auto* ioBuf = static_cast<unsigned char*>(av_malloc(MUX_IO_BUFFER));
+    m_mux->pb = avio_alloc_context(ioBuf, MUX_IO_BUFFER, 1, &m_out, nullptr, &muxerWrite, nullptr);
+    m_mux->flags |= AVFMT_FLAG_CUSTOM_IO;
+
+    m_stream = avformat_new_stream(m_mux, nullptr);
+    avcodec_parameters_from_context(m_stream->codecpar, m_codec);
+    m_stream->time_base = m_codec->time_base;
+
+    // empty_moov: 헤더에 샘플 없는 moov만 → init segment
+    // frag_custom: av_write_frame(NULL)을 부를 때마다 fragment 하나 (프레임 단위 저지연)
+    AVDictionary* opts = nullptr;
+    av_dict_set(&opts, "movflags", "empty_moov+default_base_moof+frag_custom", 0);
+    m_out.clear();
+    const int rc = avformat_write_header(m_mux, &opts);
+    av_dict_free(&opts);
+    if (rc < 0) {
+        qWarning() << "[Fmp4Encoder] avformat_write_header failed";
+        close();
+        return false;
+    }
+    avio_flush(m_mux->pb);
+    m_init = m_out;
+    m_out.clear();
+    m_mime = QStringLiteral("video/mp4; codecs=\"%1\"")
+                 .arg(avcCodecString(m_codec->extradata, m_codec->extradata_size));
+
+    m_frame = av_frame_alloc();
+    m_frame->width  = width;
+    m_frame->height = height;
+    m_frame->format = AV_PIX_FMT_YUV420P;
+    m_packet = av_packet_alloc();
+
+    m_size = cv::Size(width, height);
+    m_firstTs = -1;
+    m_lastPts = -1;
+    qDebug() << "[Fmp4Encoder] opened" << width << "x" << height << m_mime;
+    return true;
+}
+
+void Fmp4Encoder::close()
+{
+    if (m_mux) {
+        if (m_mux->pb) {
+            av_freep(&m_mux->pb->buffer);
+            avio_context_free(&m_mux->pb);
+        }
+        avformat_free_context(m_mux);
+        m_mux = nullptr;
+        m_stream = nullptr;
+    }
+    if (m_codec) avcodec_free_context(&m_codec);
+    if (m_frame) av_frame_free(&m_frame);
+    if (m_packet) av_packet_free(&m_packet);
+    m_size = cv::Size();
+    m_init.clear();
+    m_mime.clear();
+}
+
+bool Fmp4Encoder::encode(const cv::Mat& bgr, qint64 timestampMs, QList<Fragment>& out)
+{
+    if (bgr.empty() || bgr.type() != CV_8UC3) return false;
+
+    // 목표 해상도: maxHeight 이하, 4:2:0에 맞게 짝수
+    int h = bgr.rows, w = bgr.cols;
+    if (m_opt.maxHeight > 0 && h > m_opt.maxHeight) {
+        w = w * m_opt.maxHeight / h;
+        h = m_opt.maxHeight;
+    }
+    w &= ~1;
+    h &= ~1;
+    if (cv::Size(w, h) != m_size && !open(w, h)) return false;
+
+    if (w == bgr.cols && h == bgr.rows) {
+        m_scaled = bgr;
+    } else if (w >= bgr.cols - 1 && h >= bgr.rows - 1) {
+        m_scaled = bgr(cv::Rect(0, 0, w, h));   // 홀수 폭/높이만 1픽셀 잘라냄
+    } else {
+        cv::resize(bgr, m_scaled, cv::Size(w, h), 0, 0, cv::INTER_AREA);
+    }
+    cv::cvtColor(m_scaled, m_yuv, cv::COLOR_BGR2YUV_I420);
+
+    // I420 한 덩어리 버퍼를 그대로 가리킴 (인코더가 필요하면 내부에서 복사)
+    m_frame->data[0] = m_yuv.data;
+    m_frame->data[1] = m_yuv.data + w * h;
+    m_frame->data[2] = m_frame->data[1] + (w / 2) * (h / 2);
+    m_frame->linesize[0] = w;
+    m_frame->linesize[1] = w / 2;
+    m_frame->linesize[2] = w / 2;
+
+    if (m_firstTs < 0) m_firstTs = timestampMs;
+    qint64 pts = timestampMs - m_firstTs;
+    if (pts <= m_lastPts) pts = m_lastPts + 1;
+    m_lastPts = pts;
+    m_frame->pts = pts;
+    m_frame->pict_type = m_forceKeyframe.exchange(false) ? AV_PICTURE_TYPE_I : AV_PICTURE_TYPE_NONE;
+
+    if (avcodec_send_frame(m_codec, m_frame) < 0) return false;
+    return drainPackets(out);
+}
+
+bool Fmp4Encoder::drainPackets(QList<Fragment>& out)
+{
+    const int64_t frameDuration = qMax(1, 1000 / qMax(1, m_opt.fps));
+    while (avcodec_receive_packet(m_codec, m_packet) == 0) {
+        const bool key = (m_packet->flags & AV_PKT_FLAG_KEY) != 0;
+        // fragment에 샘플이 하나뿐이라 길이를 먹서가 추정할 수 없으므로 명시
+        if (m_packet->duration <= 0) m_packet->duration = frameDuration;
+        av_packet_rescale_ts(m_packet, m_codec->time_base, m_stream->time_base);
+        m_packet->stream_index = m_stream->index;
+
+        const int rc = av_write_frame(m_mux, m_packet);
+        av_packet_unref(m_packet);
+        if (rc < 0) return false;
+
+        av_write_frame(m_mux, nullptr);   // 지금까지의 샘플로 moof+mdat 하나를 내보냄
+        avio_flush(m_mux->pb);
+        if (!m_out.isEmpty()) {
+            out << Fragment{m_out, key};
+            m_out.clear();
+        }
+    }
+    return true;
+}
+
+#else // !CCTV_HAVE_FFMPEG
+
+bool Fmp4Encoder::open(int, int) { return false; }
+void Fmp4Encoder::close() {}
+bool Fmp4Encoder::encode(const cv::Mat&, qint64, QList<Fragment>&) { return false; }
+bool Fmp4Encoder::drainPackets(QList<Fragment>&) { return false; }
+
+#endif
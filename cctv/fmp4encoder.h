@@ -0,0 +1,75 @@
+#ifndef FMP4ENCODER_H
+#define FMP4ENCODER_H
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <atomic>
+#include <opencv2/core.hpp>
+
+struct AVCodecContext;
+struct AVFormatContext;
+struct AVStream;
+struct AVFrame;
+struct AVPacket;
+
+// 라이브 H.264 → fragmented MP4 (Media Source Extensions 용).
+// 한 번 인코딩한 결과를 init segment(ftyp+moov)와 프레임당 하나의 fragment(moof+mdat)로 잘라
+// 모든 시청자가 공유합니다. 상태가 있는 인코더이므로 한 스레드에서 순서대로만 호출해야 합니다.
+// FFmpeg(libavcodec/libavformat) 없이 빌드하면 isAvailable()이 false인 빈 구현이 됩니다.
+class Fmp4Encoder
+{
+public:
+    struct Options {
+        int gopFrames   = 30;     // 키프레임 간격 (새 시청자는 최근 키프레임부터 바로 재생)
+        int bitrateKbps = 1500;
+        int maxHeight   = 720;    // 0 = 원본 해상도
+        int fps         = 30;     // 레이트 컨트롤 기준값 (실제 타임스탬프는 캡처 시각 사용)
+    };
+
+    struct Fragment {
+        QByteArray data;
+        bool       keyframe = false;
+    };
+
+    explicit Fmp4Encoder(const Options& opt = Options());
+    ~Fmp4Encoder();
+    Fmp4Encoder(const Fmp4Encoder&) = delete;
+    Fmp4Encoder& operator=(const Fmp4Encoder&) = delete;
+
+    static bool isAvailable();
+
+    // BGR 프레임 하나를 인코딩해 완성된 fragment들을 out에 추가합니다.
+    // 첫 호출(또는 해상도 변경) 시 인코더/먹서를 열고 init segment를 새로 만듭니다.
+    bool encode(const cv::Mat& bgr, qint64 timestampMs, QList<Fragment>& out);
+
+    QByteArray initSegment() const { return m_init; }
+    // MediaSource.isTypeSupported()에 넘길 MIME (예: video/mp4; codecs="avc1.42c01f")
+    QString mimeType() const { return m_mime; }
+
+    // 다음 프레임을 키프레임으로 (다른 스레드에서 호출 가능)
+    void requestKeyframe() { m_forceKeyframe = true; }
+
+private:
+    bool open(int width, int height);
+    void close();
+    bool drainPackets(QList<Fragment>& out);
+
+private:
+    Options          m_opt;
+    AVCodecContext*  m_codec  = nullptr;
+    AVFormatContext* m_mux    = nullptr;
+    AVStream*        m_stream = nullptr;
+    AVFrame*         m_frame  = nullptr;
+    AVPacket*        m_packet = nullptr;
+    cv::Size         m_size;
+    cv::Mat          m_scaled, m_yuv;
+    qint64           m_firstTs = -1;
+    qint64           m_lastPts = -1;
+    QByteArray       m_out;        // 먹서가 쓰는 바이트가 여기에 모임
+    QByteArray       m_init;
+    QString          m_mime;
+    std::atomic_bool m_forceKeyframe{false};
+};
+
+#endif // FMP4ENCODER_H
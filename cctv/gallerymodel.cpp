@@ -0,0 +1,443 @@
+#include "gallerymodel.h"
+#include "thumbnailcache.h"
+#include "thumbnailloader.h"
+
+#include <QColor>
+#include <QDebug>
+#include <QFont>
+#include <QPainter>
+#include <QTimer>
+#include <algorithm>
+
+namespace {
+constexpr int FETCH_BATCH_CLIPS = 400;              // fetchMore 한 번에 색인에서 읽는 클립 수
+constexpr int ICON_CACHE_KB    = 64 * 1024;         // 아이콘 LRU 상한 (240x135 기준 약 500장)
+constexpr int SPRITE_CACHE_KB  = 32 * 1024;         // 스프라이트 LRU 상한 (48타일 기준 약 15개)
+}
+
+GalleryModel::GalleryModel(QSize thumbSize, QObject *parent)
+    : QAbstractListModel(parent)
+    , m_thumbSize(thumbSize)
+{
+    m_icons.setMaxCost(ICON_CACHE_KB);
+    m_sprites.setMaxCost(SPRITE_CACHE_KB);
+    m_loadingIcon   = placeholder(QStringLiteral("LOADING"));
+    m_noPreviewIcon = placeholder(QStringLiteral("NO PREVIEW"));
+
+    m_thumbs = new ThumbnailLoader(thumbSize, this);
+    connect(m_thumbs, &ThumbnailLoader::thumbnailReady, this, &GalleryModel::onThumbnailReady);
+
+    // 한 번의 그리기에서 나온 요청을 모아 로더에 한꺼번에 넘김
+    m_flushTimer = new QTimer(this);
+    m_flushTimer->setSingleShot(true);
+    m_flushTimer->setInterval(0);
+    connect(m_flushTimer, &QTimer::timeout, this, &GalleryModel::flushRequests);
+}
+
+GalleryModel::~GalleryModel() = default;
+
+void GalleryModel::resetState()
+{
+    m_thumbs->cancel();
+    m_icons.clear();
+    m_requested.clear();
+    m_requests.clear();
+    m_touched.clear();
+    m_batch.clear();
+    m_clips.clear();
+    m_sections.clear();
+    m_unlisted.clear();
+    m_sprites.clear();
+    m_noSprite.clear();
+    m_scrubClip = ClipInfo();
+    m_scrubTile = -1;
+    m_scrubIcon = QPixmap();
+}
+
+void GalleryModel::reload(const ClipIndex* index, const ClipIndex::Query& query)
+{
+    beginResetModel();
+    resetState();
+    m_index = index;
+    m_query = query;
+    if (m_query.snapshot < 0) m_query.snapshot = index->snapshot();   // 표와 페이지가 같은 시점을 보도록
+
+    int row = 0, clip = 0;
+    const QList<QPair<QDate, int>> days = index->days(m_query);
+    m_sections.reserve(days.size());
+    for (const auto& day : days) {
+        m_sections.append(Section{day.first, row, clip, day.second});
+        row += 1 + day.second;
+        clip += day.second;
+    }
+    m_clips = index->page(m_query, nullptr, FETCH_BATCH_CLIPS);
+    endResetModel();
+}
+
+void GalleryModel::setClips(const QMap<QDate, QList<ClipInfo>>& byDate)
+{
+    beginResetModel();
+    resetState();
+    m_index = nullptr;
+    m_query = ClipIndex::Query();
+
+    int row = 0;
+    for (auto it = byDate.constEnd(); it != byDate.constBegin();) {
+        --it;
+        m_sections.append(Section{it.key(), row, int(m_clips.size()), int(it.value().size())});
+        m_clips.append(it.value());
+        row += 1 + it.value().size();
+    }
+    endResetModel();
+}
+
+void GalleryModel::insertClip(const ClipInfo& clip)
+{
+    if (!clip.date.isValid()) return;
+    const int pos = clipPosition(clip);
+    if (pos < m_clips.size() && m_clips.at(pos).fileName == clip.fileName) {   // 이미 있으면 정보만 갱신
+        m_clips[pos] = clip;
+        forgetThumbnail(clip.fileName);
+        const QModelIndex idx = index(rowForClip(pos));
+        emit dataChanged(idx, idx);
+        return;
+    }
+    if (pos == m_clips.size() && !allLoaded()) {   // 아직 읽지 않은 구간 (색인 페이지와 어긋나지 않게 표에 넣지 않음)
+        m_unlisted.insert(clip.fileName);
+        return;
+    }
+
+    int s = sectionForDate(clip.date);
+    if (s >= 0) {
+        const Section& sec = m_sections.at(s);
+        const int row = sec.firstRow + 1 + (pos - sec.firstClip);
+        beginInsertRows(QModelIndex(), row, row);
+        m_clips.insert(pos, clip);
+        ++m_sections[s].count;
+        shiftSections(s + 1, 1, 1);
+        endInsertRows();
+    } else {   // 새 날짜: 머리글 + 클립
+        s = -s - 1;
+        const int row = s < m_sections.size() ? m_sections.at(s).firstRow : totalRows();
+        beginInsertRows(QModelIndex(), row, row + 1);
+        m_clips.insert(pos, clip);
+        m_sections.insert(s, Section{clip.date, row, pos, 1});
+        shiftSections(s + 1, 2, 1);
+        endInsertRows();
+    }
+}
+
+void GalleryModel::removeClip(const ClipInfo& clip)
+{
+    const int pos = clipPosition(clip);
+    const bool loaded = pos < m_clips.size() && m_clips.at(pos).fileName == clip.fileName;
+    if (!loaded && (m_unlisted.remove(clip.fileName) || allLoaded())) return;
+    forgetThumbnail(clip.fileName);
+
+    const int s = sectionForDate(clip.date);
+    if (s < 0) return;
+    const Section sec = m_sections.at(s);
+    const bool lastOfDay = sec.count == 1;
+    auto change = [&]() {
+        if (loaded) m_clips.removeAt(pos);
+        if (lastOfDay) {
+            m_sections.removeAt(s);
+            shiftSections(s, -2, -1);
+        } else {
+            --m_sections[s].count;
+            shiftSections(s + 1, -1, -1);
+        }
+    };
+    if (!loaded) {   // 읽지 않은 구간: 표만 고침 (보이는 행 변화 없음)
+        change();
+        return;
+    }
+
+    // 그 날짜의 마지막 클립이거나, 읽어 둔 클립 중 그 날짜의 유일한 클립이면 머리글도 함께 사라짐
+    const bool headerGoes = lastOfDay || (!allLoaded() && pos == m_clips.size() - 1 && pos == sec.firstClip);
+    const int first = headerGoes ? sec.firstRow : sec.firstRow + 1 + (pos - sec.firstClip);
+    const int last  = headerGoes ? sec.firstRow + 1 : first;
+    beginRemoveRows(QModelIndex(), first, last);
+    change();
+    endRemoveRows();
+}
+
+void GalleryModel::dropStaleThumbnails()
+{
+    QSet<int> stale;
+    for (auto it = m_requested.cbegin(); it != m_requested.cend(); ++it) {
+        if (!m_touched.contains(it.key())) stale.insert(it.value());
+    }
+    m_touched.clear();
+    if (stale.isEmpty()) return;
+    m_thumbs->discardPending(stale);
+    for (int id : std::as_const(stale)) m_requested.remove(m_requests.take(id).fileName);
+    m_batch.removeIf([&stale](int id) { return stale.contains(id); });
+}
+
+void GalleryModel::scrub(const QModelIndex& index, double fraction)
+{
+    const int clip = index.isValid() && index.row() < loadedRows() ? clipForRow(index.row()) : -1;
+    const QImage* strip = clip >= 0 ? sprite(m_clips.at(clip)) : nullptr;
+    const int tiles = strip ? strip->width() / ThumbnailCache::SPRITE_TILE_WIDTH : 0;
+    if (tiles <= 0) {
+        const ClipInfo previous = m_scrubClip;
+        m_scrubClip = ClipInfo();
+        m_scrubTile = -1;
+        m_scrubIcon = QPixmap();
+        if (!previous.fileName.isEmpty()) iconChanged(previous);
+        return;
+    }
+
+    const ClipInfo& info = m_clips.at(clip);
+    const int tile = qBound(0, int(fraction * tiles), tiles - 1);
+    if (info.fileName == m_scrubClip.fileName && tile == m_scrubTile) return;
+
+    // 타일은 고정 크기로 늘려 저장했으므로 썸네일의 화면비로 되돌려 그림
+    const QPixmap* icon = m_icons.object(info.fileName);
+    const QSize size = icon ? icon->size() : m_thumbSize;
+    const QImage frame = strip->copy(tile * ThumbnailCache::SPRITE_TILE_WIDTH, 0,
+                                     ThumbnailCache::SPRITE_TILE_WIDTH, strip->height());
+    m_scrubIcon = QPixmap::fromImage(frame.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation));
+
+    const ClipInfo previous = m_scrubClip;
+    m_scrubClip = info;
+    m_scrubTile = tile;
+    if (!previous.fileName.isEmpty() && previous.fileName != info.fileName) iconChanged(previous);
+    iconChanged(info);
+}
+
+int GalleryModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : loadedRows();
+}
+
+bool GalleryModel::canFetchMore(const QModelIndex &parent) const
+{
+    return !parent.isValid() && m_index && !allLoaded();
+}
+
+void GalleryModel::fetchMore(const QModelIndex &parent)
+{
+    if (parent.isValid() || !m_index || allLoaded()) return;
+    QList<ClipInfo> page = m_index->page(m_query, m_clips.isEmpty() ? nullptr : &m_clips.last(),
+                                         qMin(FETCH_BATCH_CLIPS, totalClips() - int(m_clips.size())));
+    if (page.isEmpty()) {
+        qWarning() << "[GalleryModel] index returned no more clips; refresh to resync";
+        return;
+    }
+    const int first = loadedRows();
+    const int loaded = m_clips.size() + page.size();
+    const int last = (loaded == totalClips() ? totalRows() : rowForClip(loaded - 1) + 1) - 1;
+    beginInsertRows(QModelIndex(), first, last);
+    m_clips.append(page);
+    endInsertRows();
+}
+
+QVariant GalleryModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= loadedRows()) return QVariant();
+    const int clip = clipForRow(index.row());
+
+    if (clip < 0) {   // 날짜 머리글
+        switch (role) {
+        case Qt::DisplayRole:
+            return sectionForRow(index.row()).date.toString("yyyy년 M월 d일 (dddd)");
+        case Qt::FontRole: {
+            QFont font;
+            font.setBold(true); font.setPointSize(14);
+            return font;
+        }
+        case Qt::BackgroundRole:
+            return QColor("#f0f0f0");
+        case IsHeaderRole:
+            return true;
+        case PathRole:
+            return QString();
+        default:
+            return QVariant();
+        }
+    }
+
+    const ClipInfo& info = m_clips.at(clip);
+    switch (role) {
+    case Qt::DisplayRole:
+        return info.fileName;
+    case Qt::ToolTipRole:
+    case PathRole:
+        return info.path;
+    case Qt::DecorationRole:
+        if (info.fileName == m_scrubClip.fileName) return m_scrubIcon;
+        return thumbnail(info);
+    case IsHeaderRole:
+        return false;
+    default:
+        return QVariant();
+    }
+}
+
+Qt::ItemFlags GalleryModel::flags(const QModelIndex &index) const
+{
+    const Qt::ItemFlags f = QAbstractListModel::flags(index);
+    if (index.isValid() && clipForRow(index.row()) < 0) return f & ~Qt::ItemIsSelectable;
+    return f;
+}
+
+int GalleryModel::totalRows() const
+{
+    return m_sections.isEmpty() ? 0 : m_sections.last().firstRow + 1 + m_sections.last().count;
+}
+
+int GalleryModel::totalClips() const
+{
+    return m_sections.isEmpty() ? 0 : m_sections.last().firstClip + m_sections.last().count;
+}
+
+int GalleryModel::loadedRows() const
+{
+    if (allLoaded()) return totalRows();
+    return m_clips.isEmpty() ? 0 : rowForClip(m_clips.size() - 1) + 1;
+}
+
+const GalleryModel::Section& GalleryModel::sectionForRow(int row) const
+{
+    auto it = std::upper_bound(m_sections.cbegin(), m_sections.cend(), row,
+                               [](int r, const Section& s) { return r < s.firstRow; });
+    return *(it - 1);
+}
+
+int GalleryModel::sectionForDate(const QDate& date) const
+{
+    auto it = std::lower_bound(m_sections.cbegin(), m_sections.cend(), date,
+                               [](const Section& s, const QDate& d) { return s.date > d; });
+    const int pos = int(it - m_sections.cbegin());
+    return (it != m_sections.cend() && it->date == date) ? pos : -(pos + 1);
+}
+
+int GalleryModel::clipPosition(const ClipInfo& clip) const
+{
+    auto it = std::lower_bound(m_clips.cbegin(), m_clips.cend(), clip, [](const ClipInfo& a, const ClipInfo& b) {
+        return a.date != b.date ? a.date > b.date : a.fileName > b.fileName;
+    });
+    return int(it - m_clips.cbegin());
+}
+
+void GalleryModel::shiftSections(int fromSection, int rows, int clips)
+{
+    for (int i = fromSection; i < m_sections.size(); ++i) {
+        m_sections[i].firstRow  += rows;
+        m_sections[i].firstClip += clips;
+    }
+}
+
+int GalleryModel::rowForClip(int clip) const
+{
+    auto it = std::upper_bound(m_sections.cbegin(), m_sections.cend(), clip,
+                               [](int c, const Section& s) { return c < s.firstClip; });
+    const Section& s = *(it - 1);
+    return s.firstRow + 1 + (clip - s.firstClip);
+}
+
+int GalleryModel::clipForRow(int row) const
+{
+    const Section& s = sectionForRow(row);
+    return row == s.firstRow ? -1 : s.firstClip + (row - s.firstRow - 1);
+}
+
+// 뷰가 그리는 행에서만 불림 → 보이는 클립만 요청됨
+QPixmap GalleryModel::thumbnail(const ClipInfo& clip) const
+{
+    m_touched.insert(clip.fileName);
+    if (const QPixmap* px = m_icons.object(clip.fileName)) return *px;
+    if (!m_requested.contains(clip.fileName)) {
+        const int id = m_nextRequestId++;
+        m_requested.insert(clip.fileName, id);
+        m_requests.insert(id, clip);
+        m_batch.append(id);
+        m_flushTimer->start();
+    }
+    return m_loadingIcon;
+}
+
+void GalleryModel::forgetThumbnail(const QString& fileName)
+{
+    m_icons.remove(fileName);
+    m_sprites.remove(fileName);
+    m_noSprite.remove(fileName);
+    if (fileName == m_scrubClip.fileName) {
+        m_scrubClip = ClipInfo();
+        m_scrubTile = -1;
+        m_scrubIcon = QPixmap();
+    }
+    const auto it = m_requested.constFind(fileName);
+    if (it == m_requested.cend()) return;
+    const int id = it.value();
+    m_requested.erase(it);
+    m_requests.remove(id);
+    m_batch.removeAll(id);
+    m_thumbs->discardPending({id});
+}
+
+void GalleryModel::flushRequests()
+{
+    QList<ThumbnailLoader::Request> requests;
+    requests.reserve(m_batch.size());
+    for (int id : std::as_const(m_batch)) {
+        const auto it = m_requests.constFind(id);
+        if (it == m_requests.cend()) continue;
+        requests << ThumbnailLoader::Request{id, it->path, ThumbnailCache::key(it->path, it->size, it->modified)};
+    }
+    m_batch.clear();
+    m_thumbs->enqueue(requests);   // 이전 요청보다 앞에 (지금 보이는 것이 먼저)
+}
+
+void GalleryModel::onThumbnailReady(int requestId, const QImage& image)
+{
+    const auto it = m_requests.constFind(requestId);
+    if (it == m_requests.cend()) return;   // 그 사이 버리거나 지운 클립
+    const ClipInfo clip = it.value();
+    m_requests.erase(it);
+    m_requested.remove(clip.fileName);
+
+    // 만들지 못한 썸네일은 녹화 중인 파일일 수 있으므로 자리표시만
+    const QPixmap px = image.isNull() ? m_noPreviewIcon : QPixmap::fromImage(image);
+    m_icons.insert(clip.fileName, new QPixmap(px), qMax(1, px.width() * px.height() * px.depth() / 8 / 1024));
+
+    iconChanged(clip);
+}
+
+// 한 번 읽으면 LRU에 둠. 작은 JPEG 한 장이라 GUI 스레드에서 바로 읽음 (마우스를 처음 올릴 때 한 번)
+const QImage* GalleryModel::sprite(const ClipInfo& clip)
+{
+    if (const QImage* cached = m_sprites.object(clip.fileName)) return cached;
+    if (m_noSprite.contains(clip.fileName)) return nullptr;
+
+    QImage img;
+    const QByteArray key = ThumbnailCache::spriteKey(ThumbnailCache::key(clip.path, clip.size, clip.modified));
+    if (!m_spriteStore.load(key, img) || img.width() < ThumbnailCache::SPRITE_TILE_WIDTH) {
+        m_noSprite.insert(clip.fileName);
+        return nullptr;
+    }
+    const int cost = qMax(1, int(img.sizeInBytes() / 1024));
+    m_sprites.insert(clip.fileName, new QImage(img), cost);
+    return m_sprites.object(clip.fileName);   // 상한보다 크면 insert가 거부함
+}
+
+void GalleryModel::iconChanged(const ClipInfo& clip)
+{
+    const int pos = clipPosition(clip);
+    if (pos >= m_clips.size() || m_clips.at(pos).fileName != clip.fileName) return;
+    const QModelIndex idx = index(rowForClip(pos));
+    emit dataChanged(idx, idx, {Qt::DecorationRole});
+}
+
+QPixmap GalleryModel::placeholder(const QString& text) const
+{
+    QPixmap px(m_thumbSize);
+    px.fill(Qt::black);
+    QPainter p(&px);
+    p.setPen(Qt::white);
+    p.drawText(px.rect(), Qt::AlignCenter, text);
+    p.end();
+    return px;
+}
@@ -0,0 +1,117 @@
+#ifndef GALLERYMODEL_H
+#define GALLERYMODEL_H
+
+#include <QAbstractListModel>
+#include <QCache>
+#include <QDate>
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QPixmap>
+#include <QSet>
+#include <QSize>
+#include "clipcatalog.h"
+#include "clipindex.h"
+#include "thumbnailcache.h"
+
+class QTimer;
+class ThumbnailLoader;
+
+// Tab2 갤러리 모델. 행 = 날짜 머리글 + 그 날짜의 클립들 (최신 날짜/최신 클립 먼저).
+// 행마다 객체를 만들지 않고 날짜 구간 표(날짜별 클립 수)와 읽어 둔 클립 목록에서 그때그때 계산합니다.
+// 클립 색인이 있으면 구간 표만 먼저 만들고 클립은 fetchMore 때 한 페이지씩 색인에서 읽습니다.
+// 썸네일은 뷰가 실제로 그리려고 data(DecorationRole)를 물어본 행만 요청하고,
+// 만든 아이콘은 메모리 상한이 있는 LRU 캐시에 둡니다 (밀려난 것은 다시 보일 때 디스크 캐시에서 읽음).
+// 아이콘/요청은 파일 이름으로 관리하므로 클립을 하나씩 넣고 빼도(행 번호가 밀려도) 그대로 유지됩니다.
+// 마우스를 올린 클립은 녹화기가 만든 스크럽 스프라이트에서 위치에 맞는 장면을 대신 보여 줍니다.
+class GalleryModel : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    enum Role {
+        PathRole = Qt::UserRole + 1,    // 클립 절대 경로 (머리글은 빈 문자열)
+        IsHeaderRole,
+    };
+
+    explicit GalleryModel(QSize thumbSize, QObject *parent = nullptr);
+    ~GalleryModel();
+
+    // 색인에서 다시 읽음 (구간 표 + 첫 페이지). 이후 페이지는 fetchMore로. index는 호출자가 소유
+    void reload(const ClipIndex* index, const ClipIndex::Query& query = {});
+    // 색인 없이 전체 목록으로 교체 (ClipCatalog::scan 결과, 모두 한 번에 읽힘)
+    void setClips(const QMap<QDate, QList<ClipInfo>>& byDate);
+    // reload에 쓴 조회 조건 (snapshot 포함)
+    ClipIndex::Query query() const { return m_query; }
+    // 클립 하나 추가/삭제 (필요하면 날짜 머리글도 함께). 다른 행은 건드리지 않음.
+    // 아직 읽지 않은 구간에 들어가는 새 클립은 다음 reload 때 나타남
+    void insertClip(const ClipInfo& clip);
+    void removeClip(const ClipInfo& clip);
+    // 마지막 호출 이후 다시 그려지지 않은(화면에서 벗어난) 행의 대기 중인 썸네일 요청을 버림
+    void dropStaleThumbnails();
+    // 마우스 위치(fraction: 항목 안의 가로 비율 0~1)에 맞는 장면을 아이콘 대신 보여 줌. 무효 index면 원래대로
+    void scrub(const QModelIndex& index, double fraction);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    Qt::ItemFlags flags(const QModelIndex &index) const override;
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
+private:
+    struct Section {
+        QDate date;
+        int   firstRow  = 0;   // 머리글 행
+        int   firstClip = 0;   // m_clips 인덱스
+        int   count     = 0;
+    };
+
+    void resetState();
+    int  totalRows() const;
+    int  totalClips() const;
+    bool allLoaded() const { return m_clips.size() == totalClips(); }
+    int  loadedRows() const;          // 뷰에 노출한 행 수 = 읽어 둔 클립까지의 행
+    const Section& sectionForRow(int row) const;
+    int  sectionForDate(const QDate& date) const;     // 없으면 들어갈 위치를 음수로 (-(pos+1))
+    int  rowForClip(int clip) const;
+    // row가 클립이면 m_clips 인덱스, 머리글이면 -1
+    int  clipForRow(int row) const;
+    // 화면 순서(날짜 역순, 날짜 안은 이름 역순)에서 clip이 있는/들어갈 위치
+    int  clipPosition(const ClipInfo& clip) const;
+    void shiftSections(int fromSection, int rows, int clips);
+    QPixmap thumbnail(const ClipInfo& clip) const;
+    void forgetThumbnail(const QString& fileName);
+    const QImage* sprite(const ClipInfo& clip);
+    void iconChanged(const ClipInfo& clip);   // 그 클립이 읽혀 있으면 아이콘 다시 그리기
+    void flushRequests();
+    void onThumbnailReady(int requestId, const QImage& image);
+    QPixmap placeholder(const QString& text) const;
+
+    const QSize        m_thumbSize;
+    ThumbnailLoader   *m_thumbs = nullptr;
+    const ClipIndex   *m_index = nullptr;
+    ClipIndex::Query   m_query;
+    QList<ClipInfo>    m_clips;          // 읽어 둔 클립 (화면 순서의 앞부분)
+    QList<Section>     m_sections;       // 전체 날짜 구간. 날짜 역순, firstRow/firstClip 오름차순 → 이진 탐색
+    QSet<QString>      m_unlisted;       // 읽지 않은 구간에 들어와 표에 넣지 않은 새 클립
+
+    // 썸네일 (data()는 const지만 요청/캐시는 화면 상태이므로 mutable). 키는 파일 이름
+    mutable QCache<QString, QPixmap> m_icons;     // 비용: KB
+    mutable QHash<QString, int>      m_requested; // 로더에 요청했고 아직 결과가 오지 않은 클립 → 요청 번호
+    mutable QHash<int, ClipInfo>     m_requests;  // 요청 번호 → 클립
+    mutable QSet<QString>            m_touched;   // dropStaleThumbnails 이후 그려진 클립
+    mutable QList<int>               m_batch;     // 다음 flushRequests에서 보낼 요청 번호 (그려진 순서)
+    mutable int                      m_nextRequestId = 0;
+    QTimer            *m_flushTimer = nullptr;
+
+    // 스크럽 (스프라이트는 처음 마우스를 올릴 때 디스크 캐시에서 읽음)
+    ThumbnailCache                   m_spriteStore;
+    QCache<QString, QImage>          m_sprites;   // 비용: KB
+    QSet<QString>                    m_noSprite;  // 스프라이트가 없는 클립 (녹화기 이전 클립 등)
+    ClipInfo                         m_scrubClip;   // 마우스를 올린 클립 (fileName이 비면 없음)
+    int                              m_scrubTile = -1;
+    QPixmap                          m_scrubIcon;
+    QPixmap            m_loadingIcon;
+    QPixmap            m_noPreviewIcon;
+};
+
+#endif // GALLERYMODEL_H
@@ -0,0 +1,98 @@
+#include "httprequest.h"
+
+#include <QLocale>
+#include <QUrl>
+
+bool HttpRequest::isWebSocketUpgrade() const
+{
+    return header("upgrade").toLower() == "websocket";
+}
+
+bool HttpRequest::keepAlive() const
+{
+    const QByteArray conn = header("connection").toLower();
+    if (version == "HTTP/1.0") return conn.contains("keep-alive");
+    return !conn.contains("close");
+}
+
+bool HttpRequest::byteRange(qint64 size, qint64* first, qint64* last, bool* satisfiable) const
+{
+    const QByteArray range = header("range").trimmed();
+    if (!range.startsWith("bytes=") || range.contains(',')) return false;
+
+    const QByteArray spec = range.mid(6).trimmed();
+    const int dash = spec.indexOf('-');
+    if (dash < 0) return false;
+    bool okFirst = false, okLast = false;
+    qint64 a = spec.left(dash).trimmed().toLongLong(&okFirst);
+    qint64 b = spec.mid(dash + 1).trimmed().toLongLong(&okLast);
+
+    if (dash == 0) {                        // bytes=-n : 마지막 n바이트
+        if (!okLast) return false;
+        a = qMax<qint64>(0, size - b);
+        b = size - 1;
+    } else {
+        if (!okFirst) return false;
+        if (dash == spec.size() - 1) b = size - 1;   // bytes=a-
+        else if (!okLast || b < a) return false;
+        b = qMin(b, size - 1);
+    }
+    *satisfiable = (size > 0 && a < size && a <= b);
+    *first = a;
+    *last = b;
+    return true;
+}
+
+bool HttpRequest::parse(const QByteArray& buf, HttpRequest& out, bool* incomplete)
+{
+    const int end = buf.indexOf("\r\n\r\n");
+    if (incomplete) *incomplete = (end < 0);
+    if (end < 0) return false;
+
+    const QList<QByteArray> lines = buf.left(end).split('\n');
+    const QList<QByteArray> requestLine = lines.value(0).trimmed().split(' ');
+    if (requestLine.size() != 3 || !requestLine.at(2).startsWith("HTTP/")) return false;
+
+    out = HttpRequest();
+    out.method = requestLine.at(0);
+    out.version = requestLine.at(2);
+    const QUrl url(QString::fromLatin1(requestLine.at(1)));
+    out.path = url.path(QUrl::FullyDecoded);
+    out.query = QUrlQuery(url);
+    for (int i = 1; i < lines.size(); ++i) {
+        const QByteArray line = lines.at(i).trimmed();
+        const int colon = line.indexOf(':');
+        if (colon <= 0) continue;
+        out.headers.insert(line.left(colon).trimmed().toLower(), line.mid(colon + 1).trimmed());
+    }
+    out.headerLength = end + 4;
+    return true;
+}
+
+QByteArray Http::reasonPhrase(int status)
+{
+    switch (status) {
+    case 200: return "OK";
+    case 206: return "Partial Content";
+    case 304: return "Not Modified";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 416: return "Range Not Satisfiable";
+    case 503: return "Service Unavailable";
+    default:  return "Unknown";
+    }
+}
+
+QByteArray Http::responseHead(int status, const QList<QPair<QByteArray, QByteArray>>& headers)
+{
+    QByteArray head = "HTTP/1.1 " + QByteArray::number(status) + ' ' + reasonPhrase(status) + "\r\n";
+    for (const auto& h : headers) head += h.first + ": " + h.second + "\r\n";
+    head += "\r\n";
+    return head;
+}
+
+QByteArray Http::date(const QDateTime& dt)
+{
+    return QLocale::c().toString(dt.toUTC(), QStringLiteral("ddd, dd MMM yyyy hh:mm:ss 'GMT'")).toLatin1();
+}
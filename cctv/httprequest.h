@@ -0,0 +1,44 @@
+#ifndef HTTPREQUEST_H
+#define HTTPREQUEST_H
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QString>
+#include <QUrlQuery>
+
+// 스트림 서버 포트로 들어오는 간단한 HTTP/1.x 요청 (본문 없는 GET/HEAD 전용)
+struct HttpRequest
+{
+    QByteArray method;
+    QString    path;            // 퍼센트 디코딩된 경로 ("/snapshot.jpg")
+    QUrlQuery  query;
+    QByteArray version;         // "HTTP/1.1"
+    QHash<QByteArray, QByteArray> headers;   // 키는 소문자
+    int        headerLength = 0;             // 빈 줄까지 포함한 바이트 수
+
+    QByteArray header(const QByteArray& name) const { return headers.value(name.toLower()); }
+    bool isWebSocketUpgrade() const;
+    bool keepAlive() const;
+
+    // "Range: bytes=a-b" / "bytes=a-" / "bytes=-n" 하나만 해석합니다.
+    // Range가 없거나 해석할 수 없으면(여러 구간 포함) false → 전체 응답.
+    // 범위가 파일 밖이면 true + *satisfiable = false (416).
+    bool byteRange(qint64 size, qint64* first, qint64* last, bool* satisfiable) const;
+
+    // buf 앞부분에 완전한 요청 헤더가 있으면 파싱해서 true.
+    // 헤더가 아직 덜 왔으면 false + *incomplete = true, 형식 오류면 false + *incomplete = false.
+    static bool parse(const QByteArray& buf, HttpRequest& out, bool* incomplete);
+};
+
+namespace Http {
+// 상태줄 + 헤더 + 빈 줄
+QByteArray responseHead(int status, const QList<QPair<QByteArray, QByteArray>>& headers);
+QByteArray reasonPhrase(int status);
+// Last-Modified 등에 쓰는 IMF-fixdate ("Sun, 06 Nov 1994 08:49:37 GMT")
+QByteArray date(const QDateTime& dt);
+}
+
+#endif // HTTPREQUEST_H
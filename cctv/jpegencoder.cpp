@@ -0,0 +1,80 @@
+#include "jpegencoder.h"
+
+#include <QDebug>
+#include <opencv2/imgcodecs.hpp>
+
+#ifdef CCTV_HAVE_TURBOJPEG
+namespace {
+int toTjSamp(JpegEncoder::Subsampling s)
+{
+    switch (s) {
+    case JpegEncoder::Subsampling::S444: return TJSAMP_444;
+    case JpegEncoder::Subsampling::S422: return TJSAMP_422;
+    case JpegEncoder::Subsampling::Gray: return TJSAMP_GRAY;
+    case JpegEncoder::Subsampling::S420:
+    default:                             return TJSAMP_420;
+    }
+}
+}
+#endif
+
+JpegEncoder::JpegEncoder()
+{
+#ifdef CCTV_HAVE_TURBOJPEG
+    m_handle = tjInitCompress();
+    if (!m_handle) qWarning() << "[JpegEncoder] tjInitCompress failed:" << tjGetErrorStr2(nullptr);
+#endif
+}
+
+JpegEncoder::~JpegEncoder()
+{
+#ifdef CCTV_HAVE_TURBOJPEG
+    if (m_buf) tjFree(m_buf);
+    if (m_handle) tjDestroy(m_handle);
+#endif
+}
+
+JpegEncoder& JpegEncoder::threadLocal()
+{
+    static thread_local JpegEncoder encoder;
+    return encoder;
+}
+
+bool JpegEncoder::encode(const cv::Mat& bgr, const Options& opt, QByteArray& out)
+{
+    if (bgr.empty() || bgr.type() != CV_8UC3) return false;
+
+#ifdef CCTV_HAVE_TURBOJPEG
+    if (!m_handle) return false;
+
+    const int samp = toTjSamp(opt.subsampling);
+    // 해상도/서브샘플링이 바뀔 때만 버퍼를 다시 잡음 (최악의 경우 크기 기준)
+    const unsigned long need = tjBufSize(bgr.cols, bgr.rows, samp);
+    if (need > m_bufSize) {
+        if (m_buf) tjFree(m_buf);
+        m_buf = tjAlloc(static_cast<int>(need));
+        m_bufSize = m_buf ? need : 0;
+        if (!m_buf) return false;
+    }
+
+    unsigned char* dst = m_buf;
+    unsigned long  size = m_bufSize;
+    int flags = TJFLAG_NOREALLOC;
+    if (opt.fastDct) flags |= TJFLAG_FASTDCT;
+
+    if (tjCompress2(m_handle, bgr.data, bgr.cols, static_cast<int>(bgr.step), bgr.rows, TJPF_BGR,
+                    &dst, &size, samp, opt.quality, flags) != 0) {
+        qWarning() << "[JpegEncoder] tjCompress2 failed:" << tjGetErrorStr2(m_handle);
+        return false;
+    }
+    out = QByteArray(reinterpret_cast<const char*>(dst), static_cast<qsizetype>(size));
+    return true;
+#else
+    // libjpeg-turbo 개발 패키지가 없을 때: OpenCV(libjpeg)로 BGR을 직접 인코딩
+    // (서브샘플링/고속 DCT 옵션은 적용되지 않음)
+    const std::vector<int> params = { cv::IMWRITE_JPEG_QUALITY, opt.quality };
+    if (!cv::imencode(".jpg", bgr, m_buf, params)) return false;
+    out = QByteArray(reinterpret_cast<const char*>(m_buf.data()), static_cast<qsizetype>(m_buf.size()));
+    return true;
+#endif
+}
@@ -0,0 +1,49 @@
+#ifndef JPEGENCODER_H
+#define JPEGENCODER_H
+
+#include <QByteArray>
+#include <opencv2/core.hpp>
+
+#ifdef CCTV_HAVE_TURBOJPEG
+#include <turbojpeg.h>
+#else
+#include <vector>
+#endif
+
+// 스트리밍용 JPEG 인코더.
+// TurboJPEG 핸들과 출력 버퍼를 재사용하고 BGR 픽셀을 그대로 입력받으므로
+// QImage 변환(BGR2RGB)과 Qt 이미지 플러그인 계층을 거치지 않습니다.
+// 핸들은 스레드 간 공유할 수 없으므로 스레드마다 하나씩(threadLocal) 사용합니다.
+class JpegEncoder
+{
+public:
+    enum class Subsampling { S444, S422, S420, Gray };
+
+    struct Options {
+        int         quality     = 70;
+        Subsampling subsampling = Subsampling::S420;
+        bool        fastDct     = true;   // 정수 고속 DCT (품질 손실은 미미, 속도 ↑)
+    };
+
+    JpegEncoder();
+    ~JpegEncoder();
+    JpegEncoder(const JpegEncoder&) = delete;
+    JpegEncoder& operator=(const JpegEncoder&) = delete;
+
+    // CV_8UC3(BGR) 프레임을 인코딩해 out에 담습니다. 실패 시 false.
+    bool encode(const cv::Mat& bgr, const Options& opt, QByteArray& out);
+
+    // 호출한 스레드 전용 인코더 (워커 풀에서 사용)
+    static JpegEncoder& threadLocal();
+
+private:
+#ifdef CCTV_HAVE_TURBOJPEG
+    tjhandle       m_handle  = nullptr;
+    unsigned char* m_buf     = nullptr;   // tjBufSize()로 잡아 둔 재사용 버퍼
+    unsigned long  m_bufSize = 0;
+#else
+    std::vector<uchar> m_buf;
+#endif
+};
+
+#endif // JPEGENCODER_H
@@ -1,10 +1,13 @@
 #include "mainwidget.h"
+#include "trace.h"
 
 #include <QApplication>
 
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
+    Trace::configureFromEnvironment();
+    Trace::setThreadName("gui");
     MainWidget w;
     w.show();
     return a.exec();
@@ -25,13 +25,31 @@ MainWidget::MainWidget(QWidget *parent)
     ui->pTab2->setLayout(lay2);
 
     // 1. 스트림 서버 생성 (8080 포트 사용)
-    StreamServer *server = new StreamServer(8080, this);
+    //    전용 네트워크 스레드로 옮겨지므로 parent 없이 만들고 소멸자에서 직접 정리합니다.
+    m_server = new StreamServer(8080);
+    // 갤러리와 같은 녹화 폴더를 원격으로도 제공 (/api/clips)
+    m_server->setClipDirectory(pTab2_video->mediaDirectory());
+    // H.264 스트림(?q=h264)의 GOP/비트레이트/높이(0 = 원본). 환경 변수가 없거나 범위 밖이면 Fmp4Encoder 기본값
+    Fmp4Encoder::Options h264;
+    const auto envInt = [](const char* name, int fallback, int min) {
+        bool ok = false;
+        const int v = qEnvironmentVariableIntValue(name, &ok);
+        return ok && v >= min ? v : fallback;
+    };
+    h264.gopFrames   = envInt("CCTV_H264_GOP", h264.gopFrames, 1);
+    h264.bitrateKbps = envInt("CCTV_H264_KBPS", h264.bitrateKbps, 1);
+    h264.maxHeight   = envInt("CCTV_H264_HEIGHT", h264.maxHeight, 0);
+    m_server->setH264Options(h264);
 
-    // 2. Tab1의 MotionDetector가 프레임을 만들 때마다(frameReady 신호)
+    // 2. Tab1의 MotionDetector가 프레임을 만들 때마다(streamFrameReady 신호)
     //    스트림 서버가 받아서 웹으로 방송하도록(onNewFrame 슬롯) 연결합니다.
+    //    감지 스레드 → 네트워크 스레드로 바로 전달되므로 GUI 스레드는 관여하지 않습니다.
     if (auto det = pTab1_camera->detector()) {
-        connect(det, &MotionDetector::frameReady, server, &StreamServer::onNewFrame);
+        connect(det, &MotionDetector::streamFrameReady, m_server, &StreamServer::onNewFrame, Qt::QueuedConnection);
+        // 스트림 인코딩 시간도 감지 파이프라인 통계에 함께 (Tab1 통계 오버레이)
+        m_server->setPipelineStats(&det->stats());
     }
+    m_server->start();
 
     // (선택) Tab1 감지시 Tab2에도 팝업 띄우고 싶으면:
     if (auto det = pTab1_camera->detector()) {
@@ -45,5 +63,7 @@ MainWidget::MainWidget(QWidget *parent)
 
 MainWidget::~MainWidget()
 {
+    m_server->stop();
+    delete m_server;
     delete ui;
 }
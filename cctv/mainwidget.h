@@ -5,6 +5,8 @@
 #include "tab1_camera.h"
 #include "tab2_video.h"
 
+class StreamServer;
+
 QT_BEGIN_NAMESPACE
 namespace Ui {
 class MainWidget;
@@ -23,5 +25,6 @@ private:
     Ui::MainWidget *ui;
     Tab1_camera *pTab1_camera;
     Tab2_video *pTab2_video;
+    StreamServer *m_server = nullptr;
 };
 #endif // MAINWIDGET_H
@@ -1,36 +1,124 @@
 #include "motiondetector.h"
+#include "clipcatalog.h"
+#include "clipindex.h"
+#include "motionpipeline.h"
+#include "motiontrack.h"
+#include "thumbnailcache.h"
+#include "trace.h"
 
 #include <QDir>
 #include <QDateTime>
 #include <QDebug>
 #include <QMetaObject>
+#include <QFile>
 #include <QFileInfo>
+#include <QHashFunctions>
+#include <QSaveFile>
+#include <QThreadPool>
+#include <algorithm>
+#include <cmath>
 
 using namespace std::chrono;
 
 // ---- Parameters (Adjust if needed) ----
 namespace {
-constexpr int    THRESH_BIN         = 150;    // Binarization threshold
-constexpr int    MIN_AREA           = 1200;   // Minimum contour area
-constexpr int    WARMUP_MS          = 3000;   // 3-second warm-up
-constexpr int    IGN_DILATE_K       = 21;     // Dilation kernel for ignore mask
-constexpr int    IGN_TRIM_K         = 15;     // Erosion kernel for trimming mask
+// 감지 파라미터(이진화, 최소 면적, 워밍업 등)는 motionpipeline.h의 MotionParams
 constexpr int    REC_GRACE_PERIOD_S = 5;      // Record for 5 more seconds after detection stops
+constexpr int    REC_THUMB_W        = 240;    // 갤러리/클립 서버 썸네일과 같은 크기
+constexpr int    REC_THUMB_H        = 135;
+constexpr double SPRITE_INTERVAL_S  = 2.0;    // 스크럽 타일 간격 (영상 시간)
+constexpr int    SPRITE_MAX_TILES   = 48;     // 넘으면 타일을 하나 걸러 버리고 간격을 두 배로
+constexpr int    PROXY_MAX_PENDING  = 30;     // 인코딩이 밀리면 새 프레임 대신 직전 프레임을 다시 씀 (축소/복사 없이)
+constexpr int    TRACK_MAX_BOXES    = 4;      // 프레임마다 남기는 바운딩 박스 수 (큰 것부터)
+
+// SOS 이전에 허프만 테이블(DHT)이 있는 독립적인 JPEG인지 확인.
+// DHT를 생략한 MJPEG(일부 UVC 카메라)은 브라우저가 표시하지 못하므로 원본 전달에서 제외합니다.
+bool isSelfContainedJpeg(const uchar* p, size_t n)
+{
+    if (n < 4 || p[0] != 0xFF || p[1] != 0xD8) return false;
+    size_t i = 2;
+    while (i + 4 <= n) {
+        if (p[i] != 0xFF) return false;
+        const uchar marker = p[i + 1];
+        if (marker == 0xFF) { ++i; continue; }   // fill byte
+        if (marker == 0xC4) return true;         // DHT
+        if (marker == 0xDA) return false;        // SOS
+        i += 2 + ((size_t(p[i + 2]) << 8) | p[i + 3]);
+    }
+    return false;
+}
+
+// 녹화 중 모아 둔 썸네일/스프라이트를 디스크 캐시에 저장 (JPEG 인코딩은 감지 스레드 밖에서)
+void storePreviewAsync(const QByteArray& key, const cv::Mat& thumb, const std::vector<cv::Mat>& tiles)
+{
+    QThreadPool::globalInstance()->start([key, thumb, tiles]() {
+        const ThumbnailCache cache;
+        if (!thumb.empty()) cache.store(key, MotionDetector::matToQImage(thumb));
+        if (!tiles.empty()) {
+            cv::Mat strip;
+            cv::hconcat(tiles, strip);
+            cache.store(ThumbnailCache::spriteKey(key), MotionDetector::matToQImage(strip));
+        }
+    });
 }
-// MOG2 Learning Rates
-constexpr double LR_ARMED           = 0.002;  // Learning rate when armed
-constexpr double LR_WARMUP          = 0.01;   // Learning rate during warm-up
+
+// 움직임 기록 사이드카 저장 (감지 스레드 밖에서, 원자적으로)
+void storeTrackAsync(const QString& path, const QByteArray& data)
+{
+    QThreadPool::globalInstance()->start([path, data]() {
+        QDir().mkpath(QFileInfo(path).path());
+        QSaveFile f(path);
+        if (!f.open(QIODevice::WriteOnly) || f.write(data) != data.size() || !f.commit()) {
+            qWarning() << "[MotionDetector] Failed to write motion track:" << path;
+        }
+    });
+}
+
+// 캡처 시각 (스트림 타임스탬프용 단조 시계, ms)
+qint64 captureTimeMs()
+{
+    return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+// 파이프라인 단계 구간을 추적에 기록. 단계별 소요 시간만 알고 있으므로 시작 시각부터 차례로 이어 붙임
+void traceStages(qint64 startNs, const MotionPipeline::StageTimes& t, quint64 frameId)
+{
+    const std::pair<const char*, qint64> stages[] = {
+        { "brightness", t.brightness }, { "clahe", t.clahe }, { "mog2", t.mog2 },
+        { "mask", t.mask }, { "contours", t.contours },
+    };
+    qint64 at = startNs;
+    for (const auto& [name, ns] : stages) {
+        if (ns <= 0) continue;
+        Trace::complete(name, at, at + ns, frameId);
+        at += ns;
+    }
+}
+}
+struct MotionDetector::ProxyRecording
+{
+    cv::VideoWriter writer;
+    cv::Size        size;
+    QString         path;         // 숨김 파일 (.proxy/.detect_...)
+    QString         finalPath;
+    std::atomic_int pending{0};   // 풀에 넘겼고 아직 쓰지 않은 프레임
+    cv::Mat         last;         // 마지막으로 넘긴 축소 프레임 (감지 스레드에서만)
+    int             dropped = 0;  // 직전 프레임으로 대신한 수, 감지 스레드에서만 셈
+};
 
 MotionDetector::MotionDetector(int camIndex, QObject* parent)
     : QObject(parent), m_camIndex(camIndex)
 {
     m_outDir = QDir::homePath() + "/Videos/cctv";
+    m_proxyPool.setMaxThreadCount(1);
+    qRegisterMetaType<StreamFrame>();
     connect(&m_worker, &QThread::started, this, &MotionDetector::runLoop);
 }
 
 MotionDetector::~MotionDetector()
 {
     stop();
+    m_proxyPool.waitForDone();   // 마지막 프록시 마무리(이름 바꾸기)까지
     // ✅ [수정] 프로그램 종료 시 녹화 중인 파일이 있다면 확실히 마무리합니다.
     if (m_writer.isOpened()) {
         m_writer.release();
@@ -41,19 +129,20 @@ MotionDetector::~MotionDetector()
 void MotionDetector::setOutputDirectory(const QString& dir) { m_outDir = dir; }
 void MotionDetector::setRecordingSeconds(int sec) { if (sec > 0) m_recSeconds = sec; }
 void MotionDetector::setCameraIndex(int idx) { m_camIndex = idx; }
-void MotionDetector::setClaheEnabled(bool enabled) { m_useClahe = enabled; }
+void MotionDetector::setClaheEnabled(bool enabled) { m_params.useClahe = enabled; }
 void MotionDetector::setClaheParams(double clipLimit, int gridWidth, int gridHeight) {
-    if (clipLimit > 0) m_claheClipLimit = clipLimit;
-    if (gridWidth > 0 && gridHeight > 0) m_claheGridSize = cv::Size(gridWidth, gridHeight);
+    if (clipLimit > 0) m_params.claheClipLimit = clipLimit;
+    if (gridWidth > 0 && gridHeight > 0) m_params.claheGridSize = cv::Size(gridWidth, gridHeight);
 }
 void MotionDetector::setMog2Params(int history, double varThreshold) {
-    if (history > 0) m_mog2History = history;
-    if (varThreshold > 0) m_mog2VarThreshold = varThreshold;
+    if (history > 0) m_params.mog2History = history;
+    if (varThreshold > 0) m_params.mog2VarThreshold = varThreshold;
 }
-void MotionDetector::setAutoClaheEnabled(bool enabled) { m_autoClahe = enabled; }
+void MotionDetector::setAutoClaheEnabled(bool enabled) { m_params.autoClahe = enabled; }
+void MotionDetector::setProxyEnabled(bool enabled) { m_proxyEnabled = enabled; }
 void MotionDetector::setAutoClaheParams(int darknessThreshold, double maxClip) {
-    if (darknessThreshold > 0 && darknessThreshold <= 255) m_darknessThreshold = darknessThreshold;
-    if (maxClip > 0) m_claheMaxClip = maxClip;
+    if (darknessThreshold > 0 && darknessThreshold <= 255) m_params.darknessThreshold = darknessThreshold;
+    if (maxClip > 0) m_params.claheMaxClip = maxClip;
 }
 
 void MotionDetector::start()
@@ -81,21 +170,19 @@ void MotionDetector::stop()
     if (m_cap.isOpened()) m_cap.release();
 }
 
-QImage MotionDetector::matToQImage(const cv::Mat& bgr)
-{
-    cv::Mat rgb;
-    cv::cvtColor(bgr, rgb, cv::COLOR_BGR2RGB);
-    return QImage(rgb.data, rgb.cols, rgb.rows, static_cast<int>(rgb.step), QImage::Format_RGB888).copy();
-}
-
 bool MotionDetector::openBestCamera()
 {
     const std::string streamUrl = "http://10.10.16.63:8080/?action=stream";
+    m_streamUrl = streamUrl;
+    m_rawJpeg = false;
     qDebug() << "[MotionDetector] Opening network stream:" << QString::fromStdString(streamUrl);
 
     // FFMPEG 백엔드가 네트워크 스트림에 더 안정적인 경우가 많음
     if (m_cap.open(streamUrl, cv::CAP_FFMPEG)) {
         qDebug() << "[MotionDetector] Stream opened successfully with FFMPEG backend.";
+        // 압축된 패킷을 그대로 받아 직접 디코딩 → 보정하지 않은 프레임은 카메라 JPEG를 재인코딩 없이 스트리밍
+        // (첫 read() 전에 설정해야 하며, MJPEG가 아니면 grabFrame()에서 일반 모드로 다시 엶)
+        m_rawJpeg = m_cap.set(cv::CAP_PROP_FORMAT, -1);
         return true;
     }
 
@@ -109,12 +196,47 @@ bool MotionDetector::openBestCamera()
     return false;
 }
 
+bool MotionDetector::grabFrame(cv::Mat& bgr, QByteArray& jpeg)
+{
+    jpeg.clear();
+    if (!m_rawJpeg) return m_cap.read(bgr) && !bgr.empty();
+
+    cv::Mat packet;
+    if (!m_cap.read(packet) || packet.empty()) return false;
+    const uchar* p = packet.ptr();
+    const size_t n = packet.total() * packet.elemSize();
+    if (n < 2 || p[0] != 0xFF || p[1] != 0xD8) {
+        // JPEG이 아닌 코덱(H.264 등)은 원본 패킷 모드로 쓸 수 없으므로 일반 모드로 다시 엶
+        qDebug() << "[MotionDetector] Stream is not MJPEG, reopening in decoded mode.";
+        m_rawJpeg = false;
+        m_cap.release();
+        if (!m_cap.open(m_streamUrl, cv::CAP_FFMPEG) && !m_cap.open(m_streamUrl, cv::CAP_ANY)) return false;
+        return m_cap.read(bgr) && !bgr.empty();
+    }
+
+    // 카메라가 새 프레임 없이 직전 JPEG를 다시 보내는 경우를 셈 (처리는 그대로)
+    const size_t packetHash = qHashBits(p, n);
+    if (n == m_lastPacketSize && packetHash == m_lastPacketHash) m_stats.add(PipelineStats::FramesDuplicated);
+    m_lastPacketSize = n;
+    m_lastPacketHash = packetHash;
+
+    bgr = cv::imdecode(packet, cv::IMREAD_COLOR);
+    if (bgr.empty()) return false;
+    if (isSelfContainedJpeg(p, n)) {
+        jpeg = QByteArray(reinterpret_cast<const char*>(p), static_cast<qsizetype>(n));
+    }
+    return true;
+}
+
 void MotionDetector::startRecording()
 {
     if (m_recording) return;
 
     QDir().mkpath(m_outDir);
-    const QString path = m_outDir + "/detect_" + QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss") + ".mp4";
+    // 녹화 중에는 숨김 파일(.detect_...)에 쓰고, 끝나면 원래 이름으로 바꿈.
+    // 갤러리/클립 서버/폴더 감시는 숨김 파일을 보지 않으므로 완성된 클립만 나타남
+    const QString name = "detect_" + QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss") + ".mp4";
+    const QString path = m_outDir + "/." + name;
 
     if (m_fps < 1.0) m_fps = 30.0;
     if (m_frameSize.empty()) m_frameSize = cv::Size(1280, 720);
@@ -127,7 +249,17 @@ void MotionDetector::startRecording()
         return;
     }
     m_recording = true;
+    m_recPath = path;
+    m_recFinalPath = m_outDir + "/" + name;
     m_recStarted = std::chrono::steady_clock::now();
+    m_recStartedAt = QDateTime::currentDateTime();
+    m_recPeakArea = 0.0;
+    m_recThumb.release();
+    m_recSprite.clear();
+    m_recFrames = 0;
+    m_spriteStride = 1;
+    if (m_proxyEnabled) startProxy(name);
+    m_track = std::make_unique<MotionTrackWriter>(QSize(m_frameSize.width, m_frameSize.height), m_fps);
     qDebug() << "[MotionDetector] Recording started:" << path;
 }
 
@@ -136,7 +268,134 @@ void MotionDetector::stopRecording()
     if (!m_recording) return;
     m_writer.release();
     m_recording = false;
-    qDebug() << "[MotionDetector] Recording stopped";
+    const bool renamed = QFile::rename(m_recPath, m_recFinalPath);
+    if (m_proxy) finishProxy(renamed);
+    QByteArray track;
+    if (m_track) {
+        track = m_track->finish();
+        m_track.reset();
+        if (renamed) storeTrackAsync(MotionTrack::pathFor(m_outDir, QFileInfo(m_recFinalPath).fileName()), track);
+    }
+    if (!renamed) {
+        emit errorOccured(QStringLiteral("Failed to finalize recording: %1").arg(m_recFinalPath));
+        return;
+    }
+    qDebug() << "[MotionDetector] Recording stopped:" << m_recFinalPath;
+    m_stats.add(PipelineStats::RecordBytesWritten, quint64(QFileInfo(m_recFinalPath).size()));
+
+    ClipInfo clip;
+    if (!ClipCatalog::find(m_outDir, QFileInfo(m_recFinalPath).fileName(), clip)) return;
+    const QByteArray thumbKey = ThumbnailCache::key(clip.path, clip.size, clip.modified);
+
+    // 썸네일/스프라이트는 이미 메모리에 있으므로 파일을 다시 디코딩하지 않고 캐시에 넣음.
+    // 폴더 감시가 새 클립을 알리기(디바운스) 전에 보통 끝나며, 늦으면 갤러리가 한 번 디코딩할 뿐
+    storePreviewAsync(thumbKey, m_recThumb, m_recSprite);
+    m_recThumb.release();
+    m_recSprite.clear();
+
+    // 클립 색인에 한 줄 추가 (갤러리가 폴더를 훑지 않고 바로 찾도록)
+    if (m_index) {
+        ClipIndex::Recording rec;
+        rec.start    = m_recStartedAt;
+        rec.end      = QDateTime::currentDateTime();
+        rec.peakArea = m_recPeakArea;
+        rec.thumbKey = thumbKey;
+        // 움직임 검색 색인 (칸 비트맵)도 함께. 사이드카 파일 대신 방금 만든 바이트를 바로 풀어 씀
+        MotionTrack decoded;
+        if (m_index->addRecording(clip, rec) && MotionTrack::decode(track, decoded)) {
+            m_index->setMotion(clip.fileName, decoded);
+        }
+    }
+}
+
+// 원본과 같은 이름으로 .proxy 폴더에 작은 사본을 씀 (녹화 중에는 숨김 이름)
+void MotionDetector::startProxy(const QString& name)
+{
+    const QString dir = ClipCatalog::proxyDirectory(m_outDir);
+    QDir().mkpath(dir);
+
+    auto proxy = std::make_shared<ProxyRecording>();
+    proxy->path = dir + "/." + name;
+    proxy->finalPath = dir + "/" + name;
+    proxy->size = ClipCatalog::fitInside(m_frameSize, cv::Size(PROXY_MAX_W, PROXY_MAX_H));
+    proxy->size.width &= ~1;    // H.264는 짝수 크기만
+    proxy->size.height &= ~1;
+    if (proxy->size.empty() || proxy->size.width >= m_frameSize.width) return;   // 원본이 이미 작으면 필요 없음
+
+    const int fourcc = cv::VideoWriter::fourcc('a','v','c','1');
+    if (!proxy->writer.open(proxy->path.toStdString(), fourcc, m_fps, proxy->size, true)) {
+        qWarning() << "[MotionDetector] proxy writer open failed:" << proxy->path;
+        return;
+    }
+    m_proxy = proxy;
+}
+
+// 축소는 여기서(작은 프레임만 대기열에 쌓이도록), 인코딩은 프록시 스레드에서
+void MotionDetector::writeProxy(const cv::Mat& frame, quint64 frameId)
+{
+    // 프레임을 건너뛰면 프록시가 원본보다 짧아져 시각이 어긋나므로(움직임 막대, 화질 전환 위치)
+    // 밀릴 때도 칸은 채움: 직전 축소 프레임을 공유해 다시 씀 (새 버퍼 없음)
+    cv::Mat small;
+    if (m_proxy->pending.load() >= PROXY_MAX_PENDING && !m_proxy->last.empty()) {
+        ++m_proxy->dropped;
+        m_stats.add(PipelineStats::ProxyFramesDropped);
+        small = m_proxy->last;
+    } else {
+        cv::resize(frame, small, m_proxy->size, 0, 0, cv::INTER_AREA);
+        m_proxy->last = small;
+    }
+    ++m_proxy->pending;
+    m_proxyPool.start([proxy = m_proxy, small, frameId]() {
+        Trace::setThreadName("proxy-writer");
+        Trace::Scope scope("proxy_write", frameId);
+        Trace::flow(Trace::Flow::Step, frameId);
+        proxy->writer.write(small);
+        --proxy->pending;
+    });
+}
+
+// 남은 프레임을 모두 쓴 뒤 프록시 스레드에서 닫고 이름을 바꿈 (원본 마무리에 실패했으면 지움)
+void MotionDetector::finishProxy(bool keep)
+{
+    std::shared_ptr<ProxyRecording> proxy = std::move(m_proxy);
+    m_proxy.reset();
+    m_proxyPool.start([proxy, keep, stats = &m_stats]() {
+        proxy->writer.release();
+        if (proxy->dropped > 0) {
+            qDebug() << "[MotionDetector] proxy repeated" << proxy->dropped << "frames (encoder behind)";
+        }
+        if (!keep) {
+            QFile::remove(proxy->path);
+        } else if (!QFile::rename(proxy->path, proxy->finalPath)) {
+            qWarning() << "[MotionDetector] Failed to finalize proxy:" << proxy->finalPath;
+        } else {
+            stats->add(PipelineStats::RecordBytesWritten, quint64(QFileInfo(proxy->finalPath).size()));
+        }
+    });
+}
+
+// 녹화 중인 프레임에서 썸네일(첫 프레임 = 감지된 프레임)과 스크럽 타일을 만듦
+void MotionDetector::capturePreview(const cv::Mat& frame)
+{
+    if (m_recThumb.empty()) {
+        cv::resize(frame, m_recThumb, ClipCatalog::fitInside(frame.size(), cv::Size(REC_THUMB_W, REC_THUMB_H)),
+                   0, 0, cv::INTER_AREA);
+    }
+
+    // 간격은 벽시계가 아니라 프레임 수로 (재생 위치와 맞도록)
+    const int every = std::max(1, int(std::lround(SPRITE_INTERVAL_S * m_fps))) * m_spriteStride;
+    if (m_recFrames++ % every != 0) return;
+    cv::Mat tile;
+    cv::resize(frame, tile, cv::Size(ThumbnailCache::SPRITE_TILE_WIDTH, ThumbnailCache::SPRITE_TILE_HEIGHT),
+               0, 0, cv::INTER_AREA);
+    m_recSprite.push_back(tile);
+    if (int(m_recSprite.size()) > SPRITE_MAX_TILES) {
+        std::vector<cv::Mat> kept;
+        kept.reserve(m_recSprite.size() / 2 + 1);
+        for (size_t i = 0; i < m_recSprite.size(); i += 2) kept.push_back(m_recSprite[i]);
+        m_recSprite.swap(kept);
+        m_spriteStride *= 2;
+    }
 }
 
 void MotionDetector::runLoop()
@@ -147,88 +406,68 @@ void MotionDetector::runLoop()
         return;
     }
 
-    auto mog2 = cv::createBackgroundSubtractorMOG2(m_mog2History, m_mog2VarThreshold, true);
-    cv::Ptr<cv::CLAHE> clahe = cv::createCLAHE();
-    clahe->setTilesGridSize(m_claheGridSize);
+    // QSqlDatabase 연결은 이 스레드에서 만들고 이 스레드에서만 씀
+    m_index = std::make_unique<ClipIndex>(m_outDir);
 
-    m_armed = false;
+    Trace::setThreadName("detector");
     m_cameraReady = false;
     m_motionInProgress = false;
-    m_tStart = std::chrono::steady_clock::now();
-    m_ignoreMask.release();
+    MotionPipeline pipeline(m_params, captureTimeMs());
+    MotionPipeline::Result result;
 
     cv::Mat frame;
-    if (m_cap.read(frame) && !frame.empty()) {
+    QByteArray frameJpeg;
+    if (grabFrame(frame, frameJpeg)) {
+        m_stats.add(PipelineStats::FramesCaptured);
         m_cameraReady = true;
         m_fps = m_cap.get(cv::CAP_PROP_FPS);
         m_frameSize = frame.size();
-        emit frameReady(matToQImage(frame), 0.0);
+        emit frameReady(matToQImage(frame), 0.0, m_frameSeq + 1);
+        // frame 버퍼는 다음 read()에서 재사용되므로 첫 프레임만 복사해서 넘김
+        emit streamFrameReady(StreamFrame{++m_frameSeq, frame.clone(), frameJpeg, captureTimeMs()});
     } else {
         emit errorOccured(QStringLiteral("Camera opened but first frame read failed."));
         m_running = false;
+        m_index.reset();
         return;
     }
 
     while (m_running) {
-        if (!m_cap.read(frame) || frame.empty()) continue;
-
-        bool applyClaheThisFrame = m_useClahe;
-        double currentClipLimit = m_claheClipLimit;
-
-        if (m_autoClahe) {
-            cv::Mat gray;
-            cv::cvtColor(frame, gray, cv::COLOR_BGR2GRAY);
-            double brightness = cv::mean(gray)[0];
-            if (brightness < m_darknessThreshold) {
-                applyClaheThisFrame = true;
-                currentClipLimit = m_claheMaxClip - (m_claheMaxClip - 1.0) * (brightness / m_darknessThreshold);
-            } else {
-                applyClaheThisFrame = false;
-            }
-        }
-
-        cv::Mat processedFrame;
-        if (applyClaheThisFrame) {
-            clahe->setClipLimit(currentClipLimit);
-            cv::Mat lab_image;
-            cv::cvtColor(frame, lab_image, cv::COLOR_BGR2Lab);
-            std::vector<cv::Mat> lab_planes(3);
-            cv::split(lab_image, lab_planes);
-            clahe->apply(lab_planes[0], lab_planes[0]);
-            cv::merge(lab_planes, lab_image);
-            cv::cvtColor(lab_image, processedFrame, cv::COLOR_Lab2BGR);
-        } else {
-            frame.copyTo(processedFrame);
-        }
-
-        cv::Mat fg;
-        mog2->apply(processedFrame, fg, m_armed ? LR_ARMED : LR_WARMUP);
-        cv::threshold(fg, fg, THRESH_BIN, 255, cv::THRESH_BINARY);
-
-        if (!m_armed) {
-            if (m_ignoreMask.empty()) m_ignoreMask = cv::Mat::zeros(fg.size(), CV_8UC1);
-            cv::dilate(fg, fg, cv::getStructuringElement(cv::MORPH_ELLIPSE, {IGN_DILATE_K, IGN_DILATE_K}));
-            cv::bitwise_or(m_ignoreMask, fg, m_ignoreMask);
-            if (std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - m_tStart).count() >= WARMUP_MS) {
-                cv::erode(m_ignoreMask, m_ignoreMask, cv::getStructuringElement(cv::MORPH_ELLIPSE, {IGN_TRIM_K, IGN_TRIM_K}));
-                m_armed = true;
-                qDebug() << "[MotionDetector] armed. ignoreMask fixed.";
-            }
-        } else {
-            if(!m_ignoreMask.empty()) cv::bitwise_and(fg, m_ignoreMask, fg, cv::noArray());
+        // 추적 켜기/끄기는 프레임 경계에서만 반영 (한 프레임의 구간이 반쯤 빠지지 않도록)
+        const bool tracing = Trace::isEnabled();
+        const quint64 frameId = m_frameSeq + 1;
+        qint64 mark = PipelineStats::nowNs();
+        if (!grabFrame(frame, frameJpeg)) {
+            m_stats.add(PipelineStats::CaptureFailures);
+            continue;
         }
-
-        bool detectedNow = false;
-        if (m_armed) {
-            std::vector<std::vector<cv::Point>> contours;
-            cv::findContours(fg, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
-            for (const auto& c : contours) {
-                if (cv::contourArea(c) > MIN_AREA) {
-                    detectedNow = true;
-                    break;
-                }
-            }
+        const qint64 capturedAt = captureTimeMs();
+        const qint64 frameStart = PipelineStats::nowNs();
+        m_stats.add(PipelineStats::FramesCaptured);
+        m_stats.record(PipelineStats::Capture, frameStart - mark);
+        if (tracing) Trace::complete("capture", mark, frameStart, frameId);
+
+        // frame 버퍼는 다음 read()에서 재사용됨 (imdecode는 매번 새 버퍼를 만들므로 MJPEG 모드는 복사할 필요 없음)
+        pipeline.process(frame, capturedAt, m_params, !m_rawJpeg, result);
+        if (tracing) {
+            traceStages(frameStart, result.times, frameId);
+            Trace::complete("detect", frameStart, PipelineStats::nowNs(), frameId);
         }
+        // 실행하지 않은 단계(자동 CLAHE 꺼짐, 보정 안 함, 워밍업 중 윤곽선)는 0이므로 기록하지 않음
+        const MotionPipeline::StageTimes& times = result.times;
+        if (times.brightness > 0) m_stats.record(PipelineStats::Brightness, times.brightness);
+        if (times.clahe > 0) m_stats.record(PipelineStats::Clahe, times.clahe);
+        m_stats.record(PipelineStats::Mog2, times.mog2);
+        m_stats.record(PipelineStats::Mask, times.mask);
+        if (times.contours > 0) m_stats.record(PipelineStats::Contours, times.contours);
+        if (result.claheApplied) m_stats.add(PipelineStats::ClaheFrames);
+        m_stats.set(PipelineStats::Armed, pipeline.isArmed());
+        if (result.justArmed) qDebug() << "[MotionDetector] armed. ignoreMask fixed.";
+        const cv::Mat& processedFrame = result.processed;
+        const bool detectedNow = result.detected;
+        const double peakArea = result.peakArea;
+        const int blobs = result.blobs;
+        std::vector<std::pair<double, cv::Rect>>& blobBoxes = result.blobBoxes;   // 움직임 기록용 (면적, 박스)
 
         if (detectedNow && !m_motionInProgress) {
             m_motionInProgress = true;
@@ -239,9 +478,30 @@ void MotionDetector::runLoop()
             emit detectionCleared();
         }
         if(detectedNow) m_lastDetectTime = std::chrono::steady_clock::now();
+        m_stats.set(PipelineStats::MotionInProgress, m_motionInProgress);
 
         if (m_recording) {
+            mark = PipelineStats::nowNs();
+            m_recPeakArea = std::max(m_recPeakArea, peakArea);
             m_writer.write(processedFrame);
+            if (m_proxy) writeProxy(processedFrame, frameId);
+            capturePreview(processedFrame);
+            if (m_track) {
+                QList<QRect> boxes;
+                if (blobs > 0) {
+                    const size_t keep = std::min<size_t>(blobBoxes.size(), TRACK_MAX_BOXES);
+                    std::partial_sort(blobBoxes.begin(), blobBoxes.begin() + keep, blobBoxes.end(),
+                                      [](const auto& a, const auto& b) { return a.first > b.first; });
+                    for (size_t i = 0; i < keep; ++i) {
+                        const cv::Rect& r = blobBoxes[i].second;
+                        boxes.append(QRect(r.x, r.y, r.width, r.height));
+                    }
+                }
+                m_track->addFrame(blobs > 0 ? cv::countNonZero(result.fg) : 0, blobs, boxes);
+            }
+            const qint64 recordEnd = PipelineStats::nowNs();
+            m_stats.record(PipelineStats::Record, recordEnd - mark);
+            if (tracing) Trace::complete("record", mark, recordEnd, frameId);
             auto now = std::chrono::steady_clock::now();
             bool gracePeriodPassed = std::chrono::duration_cast<std::chrono::seconds>(now - m_lastDetectTime).count() >= REC_GRACE_PERIOD_S;
             bool minRecTimePassed = std::chrono::duration_cast<std::chrono::seconds>(now - m_recStarted).count() >= m_recSeconds;
@@ -249,11 +509,32 @@ void MotionDetector::runLoop()
                 stopRecording();
             }
         }
-
-        emit frameReady(matToQImage(processedFrame), applyClaheThisFrame ? currentClipLimit : 0.0);
+        m_stats.set(PipelineStats::Recording, m_recording);
+        m_stats.set(PipelineStats::RecordQueueDepth, m_proxy ? m_proxy->pending.load() : 0);
+
+        mark = PipelineStats::nowNs();
+        const QImage image = matToQImage(processedFrame);
+        const qint64 imageEnd = PipelineStats::nowNs();
+        m_stats.record(PipelineStats::ToImage, imageEnd - mark);
+        m_stats.add(PipelineStats::FramesProcessed);
+        if (tracing) {
+            Trace::complete("qimage", mark, imageEnd, frameId);
+            Trace::flow(Trace::Flow::Start, frameId);
+        }
+        emit frameReady(image, result.clipLimit, frameId);
+        // CLAHE를 적용하지 않은 프레임은 카메라 JPEG를 그대로 함께 넘겨 재인코딩을 피함
+        emit streamFrameReady(StreamFrame{++m_frameSeq, processedFrame,
+                                          result.claheApplied ? QByteArray() : frameJpeg, capturedAt});
+        if (tracing) {
+            // 캡처 대기는 빼고 처리에 걸린 시간만 (카메라가 느린 것은 급증으로 보지 않음)
+            const qint64 frameEnd = PipelineStats::nowNs();
+            Trace::complete("frame", frameStart, frameEnd, frameId);
+            Trace::reportFrame(frameEnd - frameStart);
+        }
     }
 
     stopRecording();
+    m_index.reset();
     if (m_cap.isOpened()) m_cap.release();
 }
 
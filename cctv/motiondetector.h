@@ -4,10 +4,20 @@
 #include <QObject>
 #include <QImage>
 #include <QThread>
+#include <QThreadPool>
 #include <QString>
+#include <QDateTime>
 #include <atomic>
 #include <opencv2/opencv.hpp>
 #include <chrono>
+#include <memory>
+#include <vector>
+#include "motionpipeline.h"
+#include "pipelinestats.h"
+#include "streamframe.h"
+
+class ClipIndex;
+class MotionTrackWriter;
 
 class MotionDetector : public QObject
 {
@@ -27,10 +37,24 @@ public:
     void setMog2Params(int history, double varThreshold);
     void setAutoClaheEnabled(bool enabled);
     void setAutoClaheParams(int darknessThreshold, double maxClip);
+    // 클립과 함께 저해상도 프록시(360p)도 녹화 (갤러리/원격 재생 기본값). 다음 녹화부터 적용
+    void setProxyEnabled(bool enabled);
+
+    // 단계별 지연 히스토그램과 프레임/드롭 카운터. 잠금 없이 어느 스레드에서나 snapshot() 가능
+    // (스트림 서버도 여기에 인코딩 시간을 기록)
+    PipelineStats& stats() { return m_stats; }
+
+    // 프록시 최대 크기 (360p, 화면비 유지)
+    static constexpr int PROXY_MAX_W = 640;
+    static constexpr int PROXY_MAX_H = 360;
+    // BGR → 표시/썸네일용 QImage (RGB888 복사본). tools/kernelbench도 이 함수를 잼
+    static QImage matToQImage(const cv::Mat& bgr);
 
 signals:
     // ✅ 이 줄을 수정하여 double 인자를 추가합니다.
-    void frameReady(const QImage& img, double clipLimit);
+    void frameReady(const QImage& img, double clipLimit, quint64 frameId);   // frameId = StreamFrame::seq
+    // 스트리밍용: 변환 없이 BGR 프레임을 그대로 전달
+    void streamFrameReady(const StreamFrame& frame);
 
     void detected();
     void detectionCleared();
@@ -43,9 +67,13 @@ public slots:
 private:
     void runLoop();
     bool openBestCamera();
+    bool grabFrame(cv::Mat& bgr, QByteArray& jpeg);
     void startRecording();
     void stopRecording();
-    QImage matToQImage(const cv::Mat& bgr);
+    void capturePreview(const cv::Mat& frame);
+    void startProxy(const QString& name);
+    void writeProxy(const cv::Mat& frame, quint64 frameId);
+    void finishProxy(bool keep);
 
 private:
     // (이하 멤버 변수들은 기존 코드와 동일)
@@ -55,28 +83,45 @@ private:
     QThread           m_worker;
     std::atomic_bool  m_running{false};
     cv::VideoCapture  m_cap;
+    std::string       m_streamUrl;
+    bool              m_rawJpeg = false;   // MJPEG 패킷을 직접 받아 디코딩하는 모드
+    size_t            m_lastPacketSize = 0;   // 중복 프레임 감지용 (원본 모드)
+    size_t            m_lastPacketHash = 0;
     cv::VideoWriter   m_writer;
     bool              m_recording = false;
+    QString           m_recPath;           // 녹화 중인 숨김 파일
+    QString           m_recFinalPath;      // 녹화가 끝나면 바뀔 이름
+    QDateTime         m_recStartedAt;      // 클립 색인용 벽시계 시각
+    double            m_recPeakArea = 0.0; // 이번 녹화에서 가장 큰 움직임 윤곽 면적
+    std::unique_ptr<ClipIndex> m_index;    // 감지 스레드 전용 연결 (runLoop 동안만)
+    cv::Mat           m_recThumb;          // 첫 감지 프레임 (썸네일 크기)
+    std::vector<cv::Mat> m_recSprite;      // 스크럽용 타일 (일정 프레임 간격)
+    int               m_recFrames = 0;     // 이번 녹화에 쓴 프레임 수
+    int               m_spriteStride = 1;  // 타일 간격 배수 (타일이 너무 많아지면 두 배로)
+    std::unique_ptr<MotionTrackWriter> m_track;   // 이번 녹화의 프레임별 움직임 기록
+    struct ProxyRecording;
+    bool              m_proxyEnabled = true;
+    std::shared_ptr<ProxyRecording> m_proxy;   // 녹화 중인 프록시 (writer는 m_proxyPool에서만 씀)
+    QThreadPool       m_proxyPool;         // 프록시 인코딩 (스레드 1개 → 프레임 순서대로)
     double            m_fps = 30.0;
     cv::Size          m_frameSize;
     bool m_cameraReady = false;
-    bool m_armed = false;
-    std::chrono::steady_clock::time_point m_tStart;
     std::chrono::steady_clock::time_point m_recStarted;
-    cv::Mat           m_ignoreMask;
     bool m_motionInProgress = false;
     std::chrono::steady_clock::time_point m_lastDetectTime;
     int               m_missCount = 0;
-    bool m_useClahe = false;
-    bool m_autoClahe = false;
-    int  m_darknessThreshold = 80;
-    double m_claheMaxClip = 8.0;
-    double m_claheClipLimit = 2.0;
-    cv::Size m_claheGridSize = cv::Size(8, 8);
-    int m_mog2History = 500;
-    double m_mog2VarThreshold = 16.0;
+    MotionParams      m_params;            // 감지 파라미터 (CLAHE/MOG2 설정 포함)
+    PipelineStats     m_stats;
+    quint64 m_frameSeq = 0;
 };
 
+inline QImage MotionDetector::matToQImage(const cv::Mat& bgr)
+{
+    cv::Mat rgb;
+    cv::cvtColor(bgr, rgb, cv::COLOR_BGR2RGB);
+    return QImage(rgb.data, rgb.cols, rgb.rows, static_cast<int>(rgb.step), QImage::Format_RGB888).copy();
+}
+
 #endif // MOTIONDETECTOR_H
 
 
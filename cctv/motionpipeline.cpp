@@ -0,0 +1,131 @@
+#include "motionpipeline.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+// 직전 측정 이후 경과 시간 (ns). 측정 시점을 now로 옮김
+qint64 lap(Clock::time_point& mark)
+{
+    const Clock::time_point now = Clock::now();
+    const qint64 ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now - mark).count();
+    mark = now;
+    return ns;
+}
+}
+
+MotionPipeline::MotionPipeline(const MotionParams& params, qint64 startMs)
+    : m_mog2(cv::createBackgroundSubtractorMOG2(params.mog2History, params.mog2VarThreshold, true)),
+      m_clahe(cv::createCLAHE()),
+      m_startMs(startMs)
+{
+    m_clahe->setTilesGridSize(params.claheGridSize);
+}
+
+void MotionPipeline::process(const cv::Mat& frame, qint64 timeMs, const MotionParams& params, bool copyInput, Result& out)
+{
+    out.times = StageTimes();
+    out.processed.release();   // 직전 결과는 다른 스레드로 넘어갔을 수 있으므로 버퍼를 재사용하지 않음
+    out.justArmed = false;
+    out.detected = false;
+    out.peakArea = 0.0;
+    out.blobs = 0;
+    out.blobBoxes.clear();
+    Clock::time_point mark = Clock::now();
+
+    bool applyClaheThisFrame = params.useClahe;
+    double currentClipLimit = params.claheClipLimit;
+
+    if (params.autoClahe) {
+        const double clipLimit = autoClipLimit(brightness(frame), params);
+        applyClaheThisFrame = clipLimit > 0.0;
+        if (applyClaheThisFrame) currentClipLimit = clipLimit;
+        out.times.brightness = lap(mark);
+    }
+
+    if (applyClaheThisFrame) {
+        m_clahe->setClipLimit(currentClipLimit);
+        applyClahe(*m_clahe, frame, out.processed);
+        out.times.clahe = lap(mark);
+    } else if (copyInput) {
+        frame.copyTo(out.processed);
+    } else {
+        out.processed = frame;
+    }
+    out.claheApplied = applyClaheThisFrame;
+    out.clipLimit = applyClaheThisFrame ? currentClipLimit : 0.0;
+
+    cv::Mat& fg = out.fg;
+    m_mog2->apply(out.processed, fg, m_armed ? params.lrArmed : params.lrWarmup);
+    out.times.mog2 = lap(mark);
+    cv::threshold(fg, fg, params.threshBin, 255, cv::THRESH_BINARY);
+
+    if (!m_armed) {
+        if (m_ignoreMask.empty()) m_ignoreMask = cv::Mat::zeros(fg.size(), CV_8UC1);
+        dilateIgnore(fg, fg, params.ignDilateK);
+        cv::bitwise_or(m_ignoreMask, fg, m_ignoreMask);
+        if (timeMs - m_startMs >= params.warmupMs) {
+            cv::erode(m_ignoreMask, m_ignoreMask, cv::getStructuringElement(cv::MORPH_ELLIPSE, {params.ignTrimK, params.ignTrimK}));
+            m_armed = true;
+            out.justArmed = true;
+        }
+    } else {
+        if(!m_ignoreMask.empty()) maskIgnored(fg, m_ignoreMask);
+    }
+    out.times.mask = lap(mark);
+
+    if (m_armed) {
+        findBlobs(fg, params, out);
+        out.detected = out.peakArea > params.minArea;
+        out.times.contours = lap(mark);
+    }
+}
+
+double MotionPipeline::brightness(const cv::Mat& bgr)
+{
+    cv::Mat gray;
+    cv::cvtColor(bgr, gray, cv::COLOR_BGR2GRAY);
+    return cv::mean(gray)[0];
+}
+
+double MotionPipeline::autoClipLimit(double brightness, const MotionParams& params)
+{
+    if (brightness >= params.darknessThreshold) return 0.0;
+    return params.claheMaxClip - (params.claheMaxClip - 1.0) * (brightness / params.darknessThreshold);
+}
+
+void MotionPipeline::applyClahe(cv::CLAHE& clahe, const cv::Mat& bgr, cv::Mat& out)
+{
+    cv::Mat lab_image;
+    cv::cvtColor(bgr, lab_image, cv::COLOR_BGR2Lab);
+    std::vector<cv::Mat> lab_planes(3);
+    cv::split(lab_image, lab_planes);
+    clahe.apply(lab_planes[0], lab_planes[0]);
+    cv::merge(lab_planes, lab_image);
+    cv::cvtColor(lab_image, out, cv::COLOR_Lab2BGR);
+}
+
+void MotionPipeline::dilateIgnore(const cv::Mat& fg, cv::Mat& out, int k)
+{
+    cv::dilate(fg, out, cv::getStructuringElement(cv::MORPH_ELLIPSE, {k, k}));
+}
+
+void MotionPipeline::maskIgnored(cv::Mat& fg, const cv::Mat& ignoreMask)
+{
+    cv::bitwise_and(fg, ignoreMask, fg, cv::noArray());
+}
+
+void MotionPipeline::findBlobs(const cv::Mat& fg, const MotionParams& params, Result& out)
+{
+    std::vector<std::vector<cv::Point>> contours;
+    cv::findContours(fg, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+    for (const auto& c : contours) {
+        const double area = cv::contourArea(c);
+        out.peakArea = std::max(out.peakArea, area);
+        if (area < params.minBlobArea) continue;
+        ++out.blobs;
+        out.blobBoxes.emplace_back(area, cv::boundingRect(c));
+    }
+}
@@ -0,0 +1,87 @@
+#ifndef MOTIONPIPELINE_H
+#define MOTIONPIPELINE_H
+
+#include <QtGlobal>
+#include <opencv2/opencv.hpp>
+#include <utility>
+#include <vector>
+
+// 감지 파라미터. 기본값이 MotionDetector가 쓰는 값
+struct MotionParams
+{
+    int      threshBin         = 150;    // Binarization threshold
+    int      minArea           = 1200;   // Minimum contour area
+    int      warmupMs          = 3000;   // 3-second warm-up
+    int      ignDilateK        = 21;     // Dilation kernel for ignore mask
+    int      ignTrimK          = 15;     // Erosion kernel for trimming mask
+    int      minBlobArea       = 100;    // 덩어리로 세는 최소 면적 (잡음 제외, 움직임 기록용)
+    double   lrArmed           = 0.002;  // Learning rate when armed
+    double   lrWarmup          = 0.01;   // Learning rate during warm-up
+    int      mog2History       = 500;    // history/varThreshold/gridSize는 파이프라인을 만들 때만 적용
+    double   mog2VarThreshold  = 16.0;
+    bool     useClahe          = false;
+    bool     autoClahe         = false;  // 켜면 밝기에 따라 useClahe/claheClipLimit 대신 자동으로
+    int      darknessThreshold = 80;
+    double   claheMaxClip      = 8.0;
+    double   claheClipLimit    = 2.0;
+    cv::Size claheGridSize     = cv::Size(8, 8);
+};
+
+// 프레임 한 장의 움직임 감지 (CLAHE → MOG2 → 이진화 → 워밍업 무시 마스크 → 윤곽선).
+// MotionDetector(실시간)와 tools/motionsweep(녹화 영상 재분석)이 같은 코드를 씁니다.
+// 시각은 호출자가 넘김: 실시간은 캡처 시각, 재분석은 영상 안의 위치 → 워밍업이 영상 시간 기준으로 동작
+class MotionPipeline
+{
+public:
+    // 단계별 소요 시간 (ns)
+    struct StageTimes {
+        qint64 brightness = 0;
+        qint64 clahe      = 0;
+        qint64 mog2       = 0;
+        qint64 mask       = 0;    // 이진화 + 무시 마스크
+        qint64 contours   = 0;
+    };
+
+    struct Result {
+        cv::Mat processed;        // 보정한 프레임 (보정하지 않았으면 입력 그대로)
+        cv::Mat fg;               // 최종 전경 마스크
+        bool    claheApplied = false;
+        double  clipLimit = 0.0;
+        bool    justArmed = false;     // 이 프레임에서 워밍업이 끝남
+        bool    detected = false;      // peakArea > minArea
+        double  peakArea = 0.0;
+        int     blobs = 0;
+        std::vector<std::pair<double, cv::Rect>> blobBoxes;   // (면적, 박스), minBlobArea 이상
+        StageTimes times;
+    };
+
+    // startMs: 워밍업 기준 시각 (process에 넘기는 시각과 같은 시계)
+    MotionPipeline(const MotionParams& params, qint64 startMs);
+
+    // copyInput: 보정하지 않을 때 호출자가 frame 버퍼를 다음 프레임에 재사용하면 true (processed에 복사)
+    void process(const cv::Mat& frame, qint64 timeMs, const MotionParams& params, bool copyInput, Result& out);
+
+    bool isArmed() const { return m_armed; }
+
+    // 단계별 커널. process()가 이 함수들로 이루어지며 tools/kernelbench가 같은 함수를 따로 잽니다
+    static double brightness(const cv::Mat& bgr);
+    // 자동 CLAHE 강도: darknessThreshold보다 어두울수록 claheMaxClip에 가깝게. 밝으면 0 (보정 안 함)
+    static double autoClipLimit(double brightness, const MotionParams& params);
+    // Lab의 L 채널에만 CLAHE
+    static void applyClahe(cv::CLAHE& clahe, const cv::Mat& bgr, cv::Mat& out);
+    // 워밍업 중 무시 마스크에 더할 영역 (전경을 k×k 타원으로 팽창). fg와 out은 같아도 됨
+    static void dilateIgnore(const cv::Mat& fg, cv::Mat& out, int k);
+    // 무시 마스크(0 = 무시) 밖의 전경만 남김
+    static void maskIgnored(cv::Mat& fg, const cv::Mat& ignoreMask);
+    // 윤곽선 → out.peakArea/blobs/blobBoxes (minBlobArea 이상만 덩어리로)
+    static void findBlobs(const cv::Mat& fg, const MotionParams& params, Result& out);
+
+private:
+    cv::Ptr<cv::BackgroundSubtractorMOG2> m_mog2;
+    cv::Ptr<cv::CLAHE> m_clahe;
+    cv::Mat            m_ignoreMask;
+    qint64             m_startMs = 0;
+    bool               m_armed = false;
+};
+
+#endif // MOTIONPIPELINE_H
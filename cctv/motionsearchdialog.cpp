@@ -0,0 +1,199 @@
+#include "motionsearchdialog.h"
+#include "motiontrack.h"
+
+#include <QDateTimeEdit>
+#include <QElapsedTimer>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QListWidget>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QPushButton>
+#include <QVBoxLayout>
+#include <opencv2/imgproc.hpp>
+
+namespace {
+constexpr int    SEARCH_LIMIT   = 200;     // 결과 최대 건수
+constexpr int    DEFAULT_DAYS   = 7;       // 기본 검색 기간 (최근 7일)
+constexpr qint64 PRE_ROLL_MS    = 1000;    // 결과 재생은 움직임 조금 앞에서부터
+const cv::Size   REFERENCE_SIZE(640, 360);
+
+// 배경으로 쓸 장면 한 장 (첫 키프레임)
+QImage referenceFrame(const QString& path)
+{
+    cv::Mat bgr;
+    if (path.isEmpty() || !ClipCatalog::thumbnailFrame(path, REFERENCE_SIZE, bgr)) return QImage();
+    cv::Mat rgb;
+    cv::cvtColor(bgr, rgb, cv::COLOR_BGR2RGB);
+    return QImage(rgb.data, rgb.cols, rgb.rows, static_cast<int>(rgb.step), QImage::Format_RGB888).copy();
+}
+}
+
+// 장면 위에 검색 영역을 끌어서 그리는 캔버스. 실제로 비교되는 칸(MotionCells)을 함께 칠해 보여 줌
+class RegionCanvas : public QWidget
+{
+public:
+    explicit RegionCanvas(const QImage& background, QWidget *parent = nullptr)
+        : QWidget(parent), m_background(background)
+    {
+        setMinimumSize(REFERENCE_SIZE.width, REFERENCE_SIZE.height);
+        setCursor(Qt::CrossCursor);
+    }
+
+    // 0~1로 정규화한 영역 (그리지 않았으면 빈 사각형)
+    QRectF region() const { return m_region; }
+
+protected:
+    void paintEvent(QPaintEvent *) override
+    {
+        QPainter p(this);
+        const QRect area = frameRect();
+        p.fillRect(rect(), Qt::black);
+        if (!m_background.isNull()) p.drawImage(area, m_background);
+
+        // 검색 단위 격자
+        p.setPen(QColor(255, 255, 255, 50));
+        for (int c = 1; c < MotionCells::COLS; ++c) {
+            const int x = area.left() + c * area.width() / MotionCells::COLS;
+            p.drawLine(x, area.top(), x, area.bottom());
+        }
+        for (int r = 1; r < MotionCells::ROWS; ++r) {
+            const int y = area.top() + r * area.height() / MotionCells::ROWS;
+            p.drawLine(area.left(), y, area.right(), y);
+        }
+
+        if (m_region.isEmpty()) {
+            p.setPen(Qt::white);
+            p.drawText(area, Qt::AlignCenter, QStringLiteral("검색할 영역을 끌어서 그리세요"));
+            return;
+        }
+        const MotionCells cells = MotionCells::fromNormalized(m_region);
+        for (int r = 0; r < MotionCells::ROWS; ++r) {
+            for (int c = 0; c < MotionCells::COLS; ++c) {
+                MotionCells one;
+                one.set(c, r);
+                if (!cells.intersects(one)) continue;
+                const QRect cell(area.left() + c * area.width() / MotionCells::COLS,
+                                 area.top() + r * area.height() / MotionCells::ROWS,
+                                 area.width() / MotionCells::COLS, area.height() / MotionCells::ROWS);
+                p.fillRect(cell, QColor(255, 160, 0, 70));
+            }
+        }
+        p.setPen(QPen(QColor("#ffa000"), 2));
+        p.drawRect(toWidget(m_region));
+    }
+
+    void mousePressEvent(QMouseEvent *event) override
+    {
+        m_anchor = toNormalized(event->position());
+        m_region = QRectF();
+        update();
+    }
+
+    void mouseMoveEvent(QMouseEvent *event) override
+    {
+        if (!(event->buttons() & Qt::LeftButton)) return;
+        m_region = QRectF(m_anchor, toNormalized(event->position())).normalized();
+        update();
+    }
+
+private:
+    // 화면비를 유지한 장면 영역
+    QRect frameRect() const
+    {
+        const QSize src = m_background.isNull() ? QSize(REFERENCE_SIZE.width, REFERENCE_SIZE.height)
+                                                : m_background.size();
+        const QSize fit = src.scaled(size(), Qt::KeepAspectRatio);
+        return QRect(QPoint((width() - fit.width()) / 2, (height() - fit.height()) / 2), fit);
+    }
+
+    QPointF toNormalized(const QPointF& pos) const
+    {
+        const QRect area = frameRect();
+        return QPointF(qBound(0.0, (pos.x() - area.left()) / area.width(), 1.0),
+                       qBound(0.0, (pos.y() - area.top()) / area.height(), 1.0));
+    }
+
+    QRect toWidget(const QRectF& r) const
+    {
+        const QRect area = frameRect();
+        return QRectF(area.left() + r.left() * area.width(), area.top() + r.top() * area.height(),
+                      r.width() * area.width(), r.height() * area.height()).toRect();
+    }
+
+    QImage  m_background;
+    QPointF m_anchor;
+    QRectF  m_region;
+};
+
+MotionSearchDialog::MotionSearchDialog(const ClipIndex* index, const QString& referenceClip, QWidget *parent)
+    : QDialog(parent), m_index(index)
+{
+    setWindowTitle(QStringLiteral("움직임 검색"));
+
+    m_canvas = new RegionCanvas(referenceFrame(referenceClip), this);
+
+    const QDateTime now = QDateTime::currentDateTime();
+    m_from = new QDateTimeEdit(now.addDays(-DEFAULT_DAYS), this);
+    m_to   = new QDateTimeEdit(now, this);
+    for (QDateTimeEdit *edit : { m_from, m_to }) {
+        edit->setCalendarPopup(true);
+        edit->setDisplayFormat("yyyy-MM-dd HH:mm");
+    }
+    auto *btnSearch = new QPushButton(QStringLiteral("검색"), this);
+    btnSearch->setDefault(true);
+
+    auto *range = new QHBoxLayout;
+    range->addWidget(new QLabel(QStringLiteral("기간"), this));
+    range->addWidget(m_from);
+    range->addWidget(new QLabel(QStringLiteral("~"), this));
+    range->addWidget(m_to);
+    range->addStretch();
+    range->addWidget(btnSearch);
+
+    m_results = new QListWidget(this);
+    m_status  = new QLabel(this);
+
+    auto *layout = new QVBoxLayout(this);
+    layout->addWidget(m_canvas, 3);
+    layout->addLayout(range);
+    layout->addWidget(m_results, 2);
+    layout->addWidget(m_status);
+
+    connect(btnSearch, &QPushButton::clicked, this, &MotionSearchDialog::search);
+    connect(m_results, &QListWidget::itemActivated, this, [this](QListWidgetItem *item) {
+        const int i = m_results->row(item);
+        if (i < 0 || i >= m_hits.size()) return;
+        const ClipIndex::MotionHit& hit = m_hits.at(i);
+        emit playRequested(hit.clip.path, qMax<qint64>(0, hit.startMs - PRE_ROLL_MS));
+    });
+}
+
+void MotionSearchDialog::search()
+{
+    m_results->clear();
+    m_hits.clear();
+    const MotionCells region = MotionCells::fromNormalized(m_canvas->region());
+    if (region.isEmpty()) {
+        m_status->setText(QStringLiteral("먼저 영역을 그리세요."));
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    m_hits = m_index->searchMotion(region, m_from->dateTime(), m_to->dateTime(), SEARCH_LIMIT);
+    const qint64 elapsed = timer.elapsed();
+
+    for (const ClipIndex::MotionHit& hit : std::as_const(m_hits)) {
+        const qint64 s = hit.startMs / 1000;
+        m_results->addItem(QStringLiteral("%1   %2  (+%3:%4, %5초, 점수 %6)")
+                               .arg(hit.at.toString("yyyy-MM-dd HH:mm:ss"), hit.clip.fileName)
+                               .arg(s / 60).arg(s % 60, 2, 10, QChar('0'))
+                               .arg(qMax<qint64>(1, (hit.endMs - hit.startMs) / 1000))
+                               .arg(hit.score));
+    }
+    m_status->setText(m_hits.isEmpty()
+                          ? QStringLiteral("결과 없음 (%1 ms). 녹화기가 움직임 기록을 남긴 클립만 검색됩니다.").arg(elapsed)
+                          : QStringLiteral("%1건 (%2 ms). 두 번 누르면 그 위치부터 재생합니다.")
+                                .arg(m_hits.size()).arg(elapsed));
+}
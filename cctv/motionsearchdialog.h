@@ -0,0 +1,38 @@
+#ifndef MOTIONSEARCHDIALOG_H
+#define MOTIONSEARCHDIALOG_H
+
+#include <QDialog>
+#include <QList>
+#include "clipindex.h"
+
+class QDateTimeEdit;
+class QLabel;
+class QListWidget;
+class RegionCanvas;
+
+// 움직임 검색 (Tab2 갤러리의 "움직임 검색").
+// 최근 클립의 한 장면 위에 영역을 그리고 기간을 고르면 그 영역을 지나간 움직임을 점수 순으로 보여 줍니다.
+// 결과를 두 번 누르면 playRequested로 그 클립의 해당 위치 재생을 요청.
+class MotionSearchDialog : public QDialog
+{
+    Q_OBJECT
+public:
+    // index는 호출자가 소유 (이 창보다 오래 살아야 함). referenceClip은 배경으로 쓸 클립 (없으면 빈 화면)
+    MotionSearchDialog(const ClipIndex* index, const QString& referenceClip, QWidget *parent = nullptr);
+
+signals:
+    void playRequested(const QString& path, qint64 positionMs);
+
+private:
+    void search();
+
+    const ClipIndex*            m_index;
+    RegionCanvas*               m_canvas  = nullptr;
+    QDateTimeEdit*              m_from    = nullptr;
+    QDateTimeEdit*              m_to      = nullptr;
+    QListWidget*                m_results = nullptr;
+    QLabel*                     m_status  = nullptr;
+    QList<ClipIndex::MotionHit> m_hits;
+};
+
+#endif // MOTIONSEARCHDIALOG_H
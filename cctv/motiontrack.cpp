@@ -0,0 +1,217 @@
+#include "motiontrack.h"
+
+#include <QDir>
+#include <QFile>
+#include <QtAlgorithms>
+#include <cmath>
+#include <limits>
+
+namespace {
+const char   MAGIC[] = "CMTK";
+constexpr quint8 FORMAT_VERSION = 1;
+constexpr int    MAX_BOXES = 64;            // 읽을 때 손상된 파일 방어
+
+void putVarint(QByteArray& out, quint64 v)
+{
+    while (v >= 0x80) {
+        out.append(char(v | 0x80));
+        v >>= 7;
+    }
+    out.append(char(v));
+}
+
+void putSigned(QByteArray& out, qint64 v)
+{
+    putVarint(out, (quint64(v) << 1) ^ quint64(v >> 63));   // zigzag
+}
+
+bool getVarint(const QByteArray& in, int& pos, quint64& v)
+{
+    v = 0;
+    for (int shift = 0; shift < 64 && pos < in.size(); shift += 7) {
+        const quint8 b = quint8(in.at(pos++));
+        v |= quint64(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+bool getSigned(const QByteArray& in, int& pos, qint64& v)
+{
+    quint64 u;
+    if (!getVarint(in, pos, u)) return false;
+    v = qint64(u >> 1) ^ -qint64(u & 1);
+    return true;
+}
+}
+
+int MotionCells::overlap(const MotionCells& o) const
+{
+    int n = 0;
+    for (int i = 0; i < WORDS; ++i) n += qPopulationCount(bits[i] & o.bits[i]);
+    return n;
+}
+
+void MotionCells::set(int col, int row)
+{
+    const int cell = row * COLS + col;
+    bits[cell / 64] |= quint64(1) << (cell % 64);
+}
+
+MotionCells& MotionCells::operator|=(const MotionCells& o)
+{
+    for (int i = 0; i < WORDS; ++i) bits[i] |= o.bits[i];
+    return *this;
+}
+
+MotionCells MotionCells::fromRect(const QRect& box, QSize frameSize)
+{
+    if (frameSize.isEmpty() || box.isEmpty()) return MotionCells();
+    return fromNormalized(QRectF(double(box.x()) / frameSize.width(), double(box.y()) / frameSize.height(),
+                                 double(box.width()) / frameSize.width(), double(box.height()) / frameSize.height()));
+}
+
+MotionCells MotionCells::fromNormalized(const QRectF& region)
+{
+    MotionCells out;
+    const QRectF r = region.normalized().intersected(QRectF(0, 0, 1, 1));
+    if (r.isEmpty()) return out;
+    // 오른쪽/아래 경계에 딱 맞닿은 칸은 넣지 않음
+    const int c0 = qBound(0, int(r.left() * COLS), COLS - 1);
+    const int r0 = qBound(0, int(r.top() * ROWS), ROWS - 1);
+    const int c1 = qBound(c0, int(std::ceil(r.right() * COLS)) - 1, COLS - 1);
+    const int r1 = qBound(r0, int(std::ceil(r.bottom() * ROWS)) - 1, ROWS - 1);
+    for (int row = r0; row <= r1; ++row) {
+        for (int col = c0; col <= c1; ++col) out.set(col, row);
+    }
+    return out;
+}
+
+QString MotionTrack::pathFor(const QString& clipDir, const QString& clipFileName)
+{
+    return QDir(clipDir).filePath(".tracks/" + clipFileName + ".track");
+}
+
+QList<QPair<qint64, qint64>> MotionTrack::segments(qint64 gapMs) const
+{
+    QList<QPair<qint64, qint64>> out;
+    for (const Frame& f : frames) {
+        const qint64 start = timeMs(f.index);
+        const qint64 end   = timeMs(f.index + 1);
+        if (!out.isEmpty() && start - out.last().second <= gapMs) out.last().second = end;
+        else out.append({start, end});
+    }
+    return out;
+}
+
+QList<QPair<int, MotionCells>> MotionTrack::cellsPerSecond() const
+{
+    QList<QPair<int, MotionCells>> out;
+    for (const Frame& f : frames) {
+        const int second = int(timeMs(f.index) / 1000);
+        if (out.isEmpty() || out.last().first != second) out.append({second, MotionCells()});
+        for (const QRect& box : f.boxes) out.last().second |= MotionCells::fromRect(box, frameSize);
+    }
+    out.removeIf([](const QPair<int, MotionCells>& s) { return s.second.isEmpty(); });
+    return out;
+}
+
+bool MotionTrack::load(const QString& path, MotionTrack& out)
+{
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) return false;
+    return decode(f.readAll(), out);
+}
+
+bool MotionTrack::decode(const QByteArray& data, MotionTrack& out)
+{
+    out = MotionTrack();
+    if (!data.startsWith(MAGIC) || data.size() < 5 || quint8(data.at(4)) != FORMAT_VERSION) return false;
+
+    int pos = 5;
+    quint64 width, height, milliFps;
+    if (!getVarint(data, pos, width) || !getVarint(data, pos, height) || !getVarint(data, pos, milliFps)) return false;
+    out.frameSize = QSize(int(width), int(height));
+    out.fps = milliFps / 1000.0;
+
+    qint64 area = 0;
+    QList<QRect> prevBoxes;
+    while (pos < data.size()) {
+        quint64 tag;
+        if (!getVarint(data, pos, tag)) return false;
+        if (!(tag & 1)) {
+            if ((tag >> 1) > quint64(std::numeric_limits<int>::max() - out.frameCount)) return false;
+            out.frameCount += int(tag >> 1);
+            continue;
+        }
+
+        Frame frame;
+        frame.index = out.frameCount++;
+        const quint64 boxes = tag >> 1;
+        qint64 dArea;
+        quint64 blobs;
+        if (boxes > MAX_BOXES || !getSigned(data, pos, dArea) || !getVarint(data, pos, blobs)) return false;
+        area += dArea;
+        frame.area  = int(area);
+        frame.blobs = int(blobs);
+        for (quint64 i = 0; i < boxes; ++i) {
+            const QRect prev = i < quint64(prevBoxes.size()) ? prevBoxes.at(int(i)) : QRect(0, 0, 0, 0);
+            qint64 dx, dy, dw, dh;
+            if (!getSigned(data, pos, dx) || !getSigned(data, pos, dy)
+                || !getSigned(data, pos, dw) || !getSigned(data, pos, dh)) {
+                return false;
+            }
+            frame.boxes.append(QRect(int(prev.x() + dx), int(prev.y() + dy),
+                                     int(prev.width() + dw), int(prev.height() + dh)));
+        }
+        prevBoxes = frame.boxes;
+        out.frames.append(frame);
+    }
+    return true;
+}
+
+MotionTrackWriter::MotionTrackWriter(QSize frameSize, double fps)
+{
+    m_data.append(MAGIC, 4);
+    m_data.append(char(FORMAT_VERSION));
+    putVarint(m_data, quint64(qMax(0, frameSize.width())));
+    putVarint(m_data, quint64(qMax(0, frameSize.height())));
+    putVarint(m_data, quint64(qMax(0.0, fps) * 1000.0 + 0.5));
+}
+
+void MotionTrackWriter::addFrame(int area, int blobs, const QList<QRect>& boxes)
+{
+    if (blobs == 0) {
+        ++m_idle;
+        return;
+    }
+    flushIdle();
+
+    const int count = qMin<int>(boxes.size(), MAX_BOXES);
+    putVarint(m_data, (quint64(count) << 1) | 1);
+    putSigned(m_data, area - m_prevArea);
+    putVarint(m_data, quint64(blobs));
+    for (int i = 0; i < count; ++i) {
+        const QRect prev = i < m_prevBoxes.size() ? m_prevBoxes.at(i) : QRect(0, 0, 0, 0);
+        const QRect& b = boxes.at(i);
+        putSigned(m_data, b.x() - prev.x());
+        putSigned(m_data, b.y() - prev.y());
+        putSigned(m_data, b.width() - prev.width());
+        putSigned(m_data, b.height() - prev.height());
+    }
+    m_prevArea  = area;
+    m_prevBoxes = boxes.mid(0, count);
+}
+
+QByteArray MotionTrackWriter::finish()
+{
+    flushIdle();
+    return m_data;
+}
+
+void MotionTrackWriter::flushIdle()
+{
+    if (m_idle == 0) return;
+    putVarint(m_data, quint64(m_idle) << 1);
+    m_idle = 0;
+}
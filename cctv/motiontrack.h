@@ -0,0 +1,94 @@
+#ifndef MOTIONTRACK_H
+#define MOTIONTRACK_H
+
+#include <QByteArray>
+#include <QList>
+#include <QPair>
+#include <QRect>
+#include <QRectF>
+#include <QSize>
+#include <QString>
+
+// 화면을 16×9 칸으로 나눈 비트맵 (144비트 = 64비트 정수 3개).
+// 움직임 검색 색인의 단위: 클립 전체/초마다 움직임이 지나간 칸을 기록하고, 검색 영역과 AND로 비교합니다.
+struct MotionCells
+{
+    static constexpr int COLS  = 16;
+    static constexpr int ROWS  = 9;
+    static constexpr int WORDS = 3;
+
+    quint64 bits[WORDS] = {};
+
+    bool isEmpty() const { return !(bits[0] | bits[1] | bits[2]); }
+    bool intersects(const MotionCells& o) const
+    {
+        return ((bits[0] & o.bits[0]) | (bits[1] & o.bits[1]) | (bits[2] & o.bits[2])) != 0;
+    }
+    int  overlap(const MotionCells& o) const;      // 겹치는 칸 수
+    void set(int col, int row);
+    MotionCells& operator|=(const MotionCells& o);
+
+    // 프레임 좌표의 박스가 걸치는 칸들
+    static MotionCells fromRect(const QRect& box, QSize frameSize);
+    // 0~1로 정규화한 영역 (검색 영역)
+    static MotionCells fromNormalized(const QRectF& region);
+};
+
+// 클립별 움직임 기록 (사이드카 파일 <녹화 폴더>/.tracks/<클립 이름>.track).
+// 녹화기가 프레임마다 전경 면적, 덩어리 수, 큰 덩어리의 바운딩 박스를 남기고
+// 플레이어는 활동 막대와 움직임 구간 이동에 씁니다.
+//
+// 형식 (정수는 모두 LEB128 varint, 부호 있는 값은 zigzag):
+//   "CMTK" 버전(1바이트) 폭 높이 fps×1000
+//   기록 = tag
+//     tag = 2n      움직임 없는 프레임 n개 (연속 구간을 한 번에)
+//     tag = 2k + 1  움직임 프레임 하나, 박스 k개:
+//                   Δ면적 덩어리수 (Δx Δy Δw Δh)×k   — Δ는 직전 움직임 프레임(같은 순번 박스)과의 차이
+// 프레임 시각은 쓰지 않고 프레임 번호 × 1000 / fps로 계산 (= 영상 안의 위치, 플레이어가 이동할 곳).
+struct MotionTrack
+{
+    struct Frame {
+        int         index = 0;      // 클립 안의 프레임 번호
+        int         area  = 0;      // 전경 픽셀 수
+        int         blobs = 0;      // 덩어리 수 (boxes는 그중 큰 것 몇 개)
+        QList<QRect> boxes;         // 원본 프레임 좌표
+    };
+
+    QSize        frameSize;
+    double       fps = 0.0;
+    int          frameCount = 0;    // 움직임 없는 프레임 포함
+    QList<Frame> frames;            // 움직임 프레임만 (index 오름차순)
+
+    bool    isEmpty() const { return frameCount == 0; }
+    qint64  timeMs(int frame) const { return fps > 0 ? qint64(frame * 1000.0 / fps) : 0; }
+    qint64  durationMs() const { return timeMs(frameCount); }
+    // 움직임 구간 [시작, 끝) ms. gapMs보다 짧게 끊긴 구간은 하나로
+    QList<QPair<qint64, qint64>> segments(qint64 gapMs) const;
+    // 움직임이 있는 초마다 (클립 안의 초, 그 1초 동안 박스가 지나간 칸)
+    QList<QPair<int, MotionCells>> cellsPerSecond() const;
+
+    static QString pathFor(const QString& clipDir, const QString& clipFileName);
+    static bool load(const QString& path, MotionTrack& out);
+    static bool decode(const QByteArray& data, MotionTrack& out);
+};
+
+// 녹화 중에 프레임을 하나씩 받아 인코딩 (메모리에 모았다가 finish에서 한 번에)
+class MotionTrackWriter
+{
+public:
+    MotionTrackWriter(QSize frameSize, double fps);
+
+    // 덩어리가 없으면(blobs == 0) 움직임 없는 프레임
+    void addFrame(int area, int blobs, const QList<QRect>& boxes);
+    QByteArray finish();
+
+private:
+    void flushIdle();
+
+    QByteArray   m_data;
+    int          m_idle = 0;        // 아직 쓰지 않은 움직임 없는 프레임 수
+    int          m_prevArea = 0;
+    QList<QRect> m_prevBoxes;
+};
+
+#endif // MOTIONTRACK_H
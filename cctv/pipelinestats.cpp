@@ -0,0 +1,194 @@
+#include "pipelinestats.h"
+
+#include <QtAlgorithms>
+#include <cmath>
+
+int LatencyHistogram::bucketOf(quint64 ns)
+{
+    if (ns < quint64(SUB)) return int(ns);
+    ns = qMin(ns, (quint64(1) << MAX_BITS) - 1);
+    const int msb = 63 - qCountLeadingZeroBits(ns);
+    const int shift = msb - SUB_BITS;
+    return (shift + 1) * SUB + int((ns >> shift) & (SUB - 1));
+}
+
+double LatencyHistogram::bucketLow(int bucket)
+{
+    if (bucket < SUB) return bucket;
+    const int shift = bucket / SUB - 1;
+    return double(quint64(SUB + bucket % SUB) << shift);
+}
+
+double LatencyHistogram::bucketValue(int bucket)
+{
+    return (bucketLow(bucket) + bucketLow(bucket + 1) - 1.0) / 2.0;
+}
+
+void LatencyHistogram::record(qint64 ns)
+{
+    const quint64 v = ns > 0 ? quint64(ns) : 0;
+    m_counts[bucketOf(v)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sumNs.fetch_add(v, std::memory_order_relaxed);
+    quint64 prev = m_maxNs.load(std::memory_order_relaxed);
+    while (v > prev && !m_maxNs.compare_exchange_weak(prev, v, std::memory_order_relaxed)) {}
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const
+{
+    Snapshot s;
+    for (int i = 0; i < BUCKETS; ++i) s.counts[i] = m_counts[i].load(std::memory_order_relaxed);
+    s.count = m_count.load(std::memory_order_relaxed);
+    s.sumNs = m_sumNs.load(std::memory_order_relaxed);
+    s.maxNs = m_maxNs.load(std::memory_order_relaxed);
+    return s;
+}
+
+quint64 LatencyHistogram::countAtOrBelow(const Snapshot& s, qint64 ns)
+{
+    quint64 n = 0;
+    for (int i = 0; i < BUCKETS && bucketLow(i + 1) - 1.0 <= double(ns); ++i) n += s.counts[i];
+    return n;
+}
+
+LatencyHistogram::Summary LatencyHistogram::summarize(const Snapshot& now, const Snapshot* since)
+{
+    // 칸 단위로 차이를 구함 (기록 도중에 뜬 스냅샷은 count와 칸 합이 조금 다를 수 있으므로 칸 합을 기준으로)
+    std::array<quint64, BUCKETS> counts;
+    quint64 total = 0;
+    int top = -1;
+    for (int i = 0; i < BUCKETS; ++i) {
+        const quint64 before = since ? since->counts[i] : 0;
+        counts[i] = now.counts[i] > before ? now.counts[i] - before : 0;
+        total += counts[i];
+        if (counts[i]) top = i;
+    }
+
+    Summary out;
+    out.count = total;
+    if (total == 0) return out;
+    const quint64 sum = since ? (now.sumNs > since->sumNs ? now.sumNs - since->sumNs : 0) : now.sumNs;
+    out.meanUs = sum / 1000.0 / total;
+
+    auto percentile = [&](double p) {
+        const quint64 rank = qMax<quint64>(1, quint64(std::ceil(p * total)));
+        quint64 seen = 0;
+        for (int i = 0; i < BUCKETS; ++i) {
+            seen += counts[i];
+            if (seen >= rank) return bucketValue(i) / 1000.0;
+        }
+        return bucketValue(top) / 1000.0;
+    };
+    out.p50Us = percentile(0.50);
+    out.p99Us = percentile(0.99);
+    // 전체 구간이면 정확한 최대값, 부분 구간이면 가장 높은 칸의 상한
+    out.maxUs = since ? (bucketLow(top + 1) - 1.0) / 1000.0 : now.maxNs / 1000.0;
+    return out;
+}
+
+const char* PipelineStats::stageName(Stage stage)
+{
+    switch (stage) {
+    case Capture:      return "capture";
+    case Brightness:   return "brightness";
+    case Clahe:        return "clahe";
+    case Mog2:         return "mog2";
+    case Mask:         return "mask";
+    case Contours:     return "contours";
+    case Record:       return "record";
+    case ToImage:      return "qimage";
+    case StreamEncode: return "stream_encode";
+    case STAGE_COUNT:  break;
+    }
+    return "?";
+}
+
+const char* PipelineStats::counterName(Counter counter)
+{
+    switch (counter) {
+    case FramesCaptured:      return "frames_captured";
+    case FramesProcessed:     return "frames_processed";
+    case CaptureFailures:     return "capture_failures";
+    case ProxyFramesDropped:  return "proxy_frames_dropped";
+    case StreamFramesSkipped: return "stream_frames_skipped";
+    case FramesDuplicated:    return "frames_duplicated";
+    case ClaheFrames:         return "clahe_frames";
+    case RecordBytesWritten:  return "record_bytes_written";
+    case COUNTER_COUNT:       break;
+    }
+    return "?";
+}
+
+PipelineStats::Snapshot PipelineStats::snapshot() const
+{
+    Snapshot s;
+    s.takenAtNs = nowNs();
+    for (int i = 0; i < STAGE_COUNT; ++i) s.stages[i] = m_stages[i].snapshot();
+    for (int i = 0; i < COUNTER_COUNT; ++i) s.counters[i] = m_counters[i].value.load(std::memory_order_relaxed);
+    for (int i = 0; i < GAUGE_COUNT; ++i) s.gauges[i] = m_gauges[i].value.load(std::memory_order_relaxed);
+    return s;
+}
+
+void PipelineStats::appendPrometheus(QByteArray& out, const QByteArray& labels) const
+{
+    const Snapshot s = snapshot();
+    auto family = [&out](const char* name, const char* type, const char* help) {
+        out += QByteArray("# HELP ") + name + ' ' + help + "\n# TYPE " + name + ' ' + type + '\n';
+    };
+    auto sample = [&out, &labels](const QByteArray& name, const QByteArray& extra, auto value) {
+        out += name + '{' + labels + (extra.isEmpty() ? QByteArray() : ',' + extra) + "} "
+             + QByteArray::number(value) + '\n';
+    };
+
+    const struct { Counter counter; const char* help; } counters[] = {
+        { FramesCaptured,     "Frames read from the camera." },
+        { FramesProcessed,    "Frames that went through motion detection." },
+        { FramesDuplicated,   "Frames identical to the previous one (raw MJPEG mode only)." },
+        { ClaheFrames,        "Frames enhanced with CLAHE." },
+        { RecordBytesWritten, "Bytes of finished clips and proxies." },
+    };
+    for (const auto& c : counters) {
+        const QByteArray name = QByteArray("cctv_") + counterName(c.counter) + "_total";
+        family(name.constData(), "counter", c.help);
+        sample(name, QByteArray(), s.counters[c.counter]);
+    }
+
+    family("cctv_frames_dropped_total", "counter", "Frames lost by reason: capture read failure, proxy encoder behind (previous frame repeated), stream encoder busy.");
+    sample("cctv_frames_dropped_total", "reason=\"capture\"", s.counters[CaptureFailures]);
+    sample("cctv_frames_dropped_total", "reason=\"proxy\"", s.counters[ProxyFramesDropped]);
+    sample("cctv_frames_dropped_total", "reason=\"stream\"", s.counters[StreamFramesSkipped]);
+
+    family("cctv_clahe_activation_ratio", "gauge", "Share of processed frames enhanced with CLAHE since start.");
+    sample("cctv_clahe_activation_ratio", QByteArray(),
+           s.counters[FramesProcessed] ? double(s.counters[ClaheFrames]) / s.counters[FramesProcessed] : 0.0);
+
+    const struct { Gauge gauge; const char* name; const char* help; } gauges[] = {
+        { Armed,            "cctv_armed",              "1 after the warm-up ignore mask is fixed." },
+        { MotionInProgress, "cctv_motion_in_progress", "1 while motion is detected." },
+        { Recording,        "cctv_recording",          "1 while a clip is being recorded." },
+        { RecordQueueDepth, "cctv_record_queue_depth", "Proxy frames waiting for the encoder." },
+    };
+    for (const auto& g : gauges) {
+        family(g.name, "gauge", g.help);
+        sample(g.name, QByteArray(), s.gauges[g.gauge]);
+    }
+
+    // 단계별 지연 (초). 버킷 경계는 HDR 칸 경계에 맞춰 근사
+    static const double bounds[] = { 0.00005, 0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005,
+                                     0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5 };
+    family("cctv_stage_latency_seconds", "histogram", "Time spent in each pipeline stage per frame.");
+    for (int i = 0; i < STAGE_COUNT; ++i) {
+        const LatencyHistogram::Snapshot& h = s.stages[i];
+        const QByteArray stage = QByteArray("stage=\"") + stageName(Stage(i)) + '"';
+        for (double le : bounds) {
+            sample("cctv_stage_latency_seconds_bucket", stage + ",le=\"" + QByteArray::number(le) + '"',
+                   LatencyHistogram::countAtOrBelow(h, qint64(le * 1e9)));
+        }
+        // 기록 도중에 뜬 스냅샷은 count가 칸 합과 조금 다를 수 있으므로 +Inf/_count도 칸 합으로 (버킷이 단조 증가하도록)
+        quint64 total = 0;
+        for (quint64 n : h.counts) total += n;
+        sample("cctv_stage_latency_seconds_bucket", stage + ",le=\"+Inf\"", total);
+        sample("cctv_stage_latency_seconds_sum", stage, h.sumNs / 1e9);
+        sample("cctv_stage_latency_seconds_count", stage, total);
+    }
+}
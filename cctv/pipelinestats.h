@@ -0,0 +1,131 @@
+#ifndef PIPELINESTATS_H
+#define PIPELINESTATS_H
+
+#include <QByteArray>
+#include <QtGlobal>
+#include <array>
+#include <atomic>
+#include <chrono>
+
+// 지연 시간 히스토그램 (HDR 방식: 2의 거듭제곱 구간마다 16칸 → 상대 오차 약 6%, 1 ns ~ 30분).
+// record는 relaxed 원자 연산 몇 개뿐이라 감지 루프에 항상 켜 둘 수 있고,
+// 다른 스레드가 잠금 없이 언제든 snapshot을 떠서 읽습니다 (두 스냅샷의 차이 = 그 사이 구간의 분포).
+class LatencyHistogram
+{
+public:
+    static constexpr int SUB_BITS = 4;
+    static constexpr int SUB      = 1 << SUB_BITS;
+    static constexpr int MAX_BITS = 41;                              // 2^41 ns ≈ 36분에서 자름
+    static constexpr int BUCKETS  = (MAX_BITS - SUB_BITS + 1) * SUB;
+
+    struct Snapshot {
+        std::array<quint64, BUCKETS> counts{};
+        quint64 count = 0;
+        quint64 sumNs = 0;
+        quint64 maxNs = 0;
+    };
+
+    struct Summary {
+        quint64 count = 0;
+        double  meanUs = 0.0;
+        double  p50Us = 0.0;
+        double  p99Us = 0.0;
+        double  maxUs = 0.0;
+    };
+
+    void record(qint64 ns);
+    Snapshot snapshot() const;
+
+    // ns 이하로 기록된 값 수 (칸 경계 기준이라 약 6% 오차, Prometheus 버킷용)
+    static quint64 countAtOrBelow(const Snapshot& s, qint64 ns);
+
+    // since가 있으면 그 이후에 기록된 값만 (이 경우 max는 가장 높은 칸의 상한)
+    static Summary summarize(const Snapshot& now, const Snapshot* since = nullptr);
+
+private:
+    static int    bucketOf(quint64 ns);
+    static double bucketLow(int bucket);     // 칸의 하한 (ns)
+    static double bucketValue(int bucket);   // 칸의 대표값 (가운데, ns)
+
+    std::array<std::atomic<quint64>, BUCKETS> m_counts{};
+    std::atomic<quint64> m_count{0};
+    std::atomic<quint64> m_sumNs{0};
+    std::atomic<quint64> m_maxNs{0};
+};
+
+// 감지 파이프라인 단계별 히스토그램과 프레임/드롭 카운터, 상태 값 (카메라 하나 = MotionDetector 하나).
+// 단계마다 기록하는 스레드가 정해져 있지만 여러 스레드가 같은 항목에 써도 안전합니다.
+// 읽는 쪽(오버레이, /metrics)은 relaxed load만 하므로 감지 루프를 멈추지 않습니다.
+class PipelineStats
+{
+public:
+    enum Stage {
+        Capture,        // 카메라 read (대기 포함)
+        Brightness,     // 자동 CLAHE 밝기 측정
+        Clahe,
+        Mog2,
+        Mask,           // 이진화 + 무시 마스크
+        Contours,
+        Record,         // 녹화 중 원본/프록시/미리보기/움직임 기록 쓰기
+        ToImage,        // 화면 표시용 QImage 변환
+        StreamEncode,   // 스트림 서버 JPEG/H.264 인코딩 (인코딩 스레드)
+        STAGE_COUNT
+    };
+
+    enum Counter {
+        FramesCaptured,
+        FramesProcessed,
+        CaptureFailures,      // read 실패 (끊김/손상된 패킷)
+        ProxyFramesDropped,   // 프록시 인코딩이 밀려 직전 프레임을 다시 쓴 프레임 (시간축은 유지)
+        StreamFramesSkipped,  // 인코더가 바빠 스트림 인코딩을 건너뛴 프레임
+        FramesDuplicated,     // 카메라가 직전과 같은 JPEG를 다시 보냄 (MJPEG 원본 모드에서만 셈)
+        ClaheFrames,          // CLAHE를 적용한 프레임
+        RecordBytesWritten,   // 마무리된 클립 + 프록시 크기
+        COUNTER_COUNT
+    };
+
+    // 현재 상태 (마지막으로 쓴 값)
+    enum Gauge {
+        Armed,                // 워밍업이 끝나 감시 중
+        MotionInProgress,
+        Recording,
+        RecordQueueDepth,     // 프록시 인코딩 대기 프레임
+        GAUGE_COUNT
+    };
+
+    struct Snapshot {
+        std::array<LatencyHistogram::Snapshot, STAGE_COUNT> stages;
+        std::array<quint64, COUNTER_COUNT> counters{};
+        std::array<qint64, GAUGE_COUNT> gauges{};
+        qint64 takenAtNs = 0;
+    };
+
+    static const char* stageName(Stage stage);
+    static const char* counterName(Counter counter);
+    static qint64 nowNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void record(Stage stage, qint64 ns) { m_stages[stage].record(ns); }
+    void add(Counter counter, quint64 n = 1) { m_counters[counter].value.fetch_add(n, std::memory_order_relaxed); }
+    quint64 counter(Counter counter) const { return m_counters[counter].value.load(std::memory_order_relaxed); }
+    void set(Gauge gauge, qint64 value) { m_gauges[gauge].value.store(value, std::memory_order_relaxed); }
+
+    Snapshot snapshot() const;
+
+    // Prometheus 텍스트 형식 (/metrics). labels는 모든 줄에 붙일 라벨, 예: camera="0"
+    void appendPrometheus(QByteArray& out, const QByteArray& labels) const;
+
+private:
+    // 항목마다 캐시 줄을 따로 써서 다른 스레드가 쓰는 카운터끼리 캐시 줄을 주고받지 않도록
+    template <typename T>
+    struct alignas(64) Slot { std::atomic<T> value{0}; };
+
+    std::array<LatencyHistogram, STAGE_COUNT> m_stages;
+    std::array<Slot<quint64>, COUNTER_COUNT> m_counters;
+    std::array<Slot<qint64>, GAUGE_COUNT> m_gauges;
+};
+
+#endif // PIPELINESTATS_H
@@ -0,0 +1,22 @@
+#ifndef STREAMFRAME_H
+#define STREAMFRAME_H
+
+#include <QMetaType>
+#include <QByteArray>
+#include <opencv2/core.hpp>
+
+// 감지 스레드 → 스트림 서버로 넘기는 프레임.
+// bgr은 감지 루프가 더 이상 수정하지 않는 버퍼이므로 복사 없이 참조만 공유합니다.
+struct StreamFrame
+{
+    quint64 seq = 0;
+    cv::Mat bgr;    // 처리가 끝난 BGR(CV_8UC3) 프레임
+    // 보정 없이 카메라 원본과 픽셀이 같은 프레임이면 카메라가 보낸 JPEG 그대로.
+    // 비어 있지 않으면 스트림 서버는 다시 인코딩하지 않고 이 바이트를 전달합니다.
+    QByteArray sourceJpeg;
+    qint64 timestampMs = 0;   // 캡처 시각 (단조 시계). H.264 스트림의 PTS로 사용
+};
+
+Q_DECLARE_METATYPE(StreamFrame)
+
+#endif // STREAMFRAME_H
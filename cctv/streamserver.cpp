@@ -1,58 +1,918 @@
 #include "streamserver.h"
-#include <QWebSocketServer>
-#include <QWebSocket>
-#include <QBuffer>
+#include "httprequest.h"
+#include "wsprotocol.h"
+#include "clipserver.h"
+#include "pipelinestats.h"
+#include "trace.h"
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QCoreApplication>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QUrlQuery>
+#include <QTimer>
 #include <QDebug>
+#include <opencv2/imgproc.hpp>
 
-StreamServer::StreamServer(quint16 port, QObject *parent) : QObject(parent)
+namespace {
+constexpr int CLIENT_STALL_TIMEOUT_MS = 30000;  // 이 시간 동안 전송이 전혀 진척되지 않으면 연결 종료
+constexpr int STATS_INTERVAL_MS       = 1000;
+constexpr double AUTO_DOWN_DROP_RATIO = 0.25;   // 1초 동안 드롭 비율이 이보다 크면 한 단계 낮춤
+constexpr int    AUTO_UP_CALM_TICKS   = 10;     // 이만큼 연속으로 드롭이 없으면 한 단계 높임
+constexpr int    MAX_HTTP_HEADER      = 8192;
+constexpr int    SNAPSHOT_TIMEOUT_MS  = 3000;   // 새 프레임이 이 시간 안에 안 오면 캐시(또는 503)로 응답
+constexpr char   MJPEG_BOUNDARY[]     = "cctvframe";
+constexpr qint64 MAX_WS_MESSAGE       = 64 * 1024;  // 클라이언트 → 서버 메시지는 화질 선택 정도라 작음
+constexpr int    TRACE_WINDOW_S       = 10;     // /trace.json 기본 구간 (?s=초, 0이면 버퍼 전체)
+
+QByteArray jsonTextFrame(const QJsonObject &obj)
 {
-    m_server = new QWebSocketServer("CCTV Stream Server", QWebSocketServer::NonSecureMode, this);
-    if (m_server->listen(QHostAddress::Any, port)) {
-        qDebug() << "Stream server listening on port" << port;
-        connect(m_server, &QWebSocketServer::newConnection, this, &StreamServer::onNewConnection);
-    } else {
-        qWarning() << "Failed to start stream server on port" << port;
+    return Ws::frame(Ws::Opcode::Text, QJsonDocument(obj).toJson(QJsonDocument::Compact));
+}
+
+// multipart 파트 헤더 + JPEG 본문 + 구분 줄바꿈을 한 덩어리로
+QByteArray mjpegPart(const QByteArray &jpeg)
+{
+    const QByteArray head = QByteArray("--") + MJPEG_BOUNDARY + "\r\nContent-Type: image/jpeg\r\nContent-Length: "
+                            + QByteArray::number(jpeg.size()) + "\r\n\r\n";
+    QByteArray part;
+    part.reserve(head.size() + jpeg.size() + 2);
+    part.append(head).append(jpeg).append("\r\n");
+    return part;
+}
+}
+
+StreamServer::StreamServer(quint16 port, QObject *parent)
+    : QObject(parent), m_port(port)
+{
+    m_thread.setObjectName(QStringLiteral("StreamServer"));
+    m_encodePool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() / 2));
+
+    m_renditions = jpegRenditions();
+    m_jpegRenditions = m_renditions.size();
+    // H.264는 자동 모드 대상이 아니므로 맨 뒤에 둠 (명시적으로 선택한 클라이언트만)
+    if (Fmp4Encoder::isAvailable()) {
+        m_renditions.append({ QStringLiteral("h264"), 0, {}, Codec::H264 });
     }
+    m_renditionState.resize(m_renditions.size());
+    m_videoPool.setMaxThreadCount(1);
+
+    connect(&m_thread, &QThread::started, this, &StreamServer::startListening);
 }
 
 StreamServer::~StreamServer()
 {
-    m_server->close();
-    qDeleteAll(m_clients.begin(), m_clients.end());
+    stop();
+}
+
+void StreamServer::start()
+{
+    if (m_thread.isRunning()) return;
+    if (parent() != nullptr) {
+        qWarning() << "[StreamServer] WARNING: parent is set. moveToThread may fail.";
+    }
+    moveToThread(&m_thread);
+    m_thread.start();
+}
+
+void StreamServer::stop()
+{
+    if (!m_thread.isRunning()) return;
+    QMetaObject::invokeMethod(this, &StreamServer::shutdown, Qt::BlockingQueuedConnection);
+    m_thread.quit();
+    m_thread.wait();
+}
+
+void StreamServer::setMaxInFlightBytes(qint64 bytes)
+{
+    if (bytes > 0) m_maxInFlight = bytes;
+}
+
+void StreamServer::setH264Options(const Fmp4Encoder::Options &opt)
+{
+    m_h264Options = opt;
+}
+
+void StreamServer::setClipDirectory(const QString &dir)
+{
+    m_clipDir = dir;
+}
+
+void StreamServer::setPipelineStats(PipelineStats *stats, const QString &camera)
+{
+    m_stats = stats;
+    m_statsCamera = camera.toUtf8();
+}
+
+void StreamServer::startListening()
+{
+    m_statsTimer = new QTimer(this);
+    connect(m_statsTimer, &QTimer::timeout, this, &StreamServer::onStatsTick);
+    m_statsTimer->start(STATS_INTERVAL_MS);
+    m_statsClock.start();
+    if (Fmp4Encoder::isAvailable()) m_h264 = new Fmp4Encoder(m_h264Options);
+    if (!m_clipDir.isEmpty()) {
+        m_clips = new ClipServer(m_clipDir, this);
+        connect(m_clips, &ClipServer::responseFinished, this, &StreamServer::onHttpResponseFinished);
+    }
+
+    // 같은 포트에서 HTTP와 WebSocket을 모두 받기 위해 TCP로 직접 listen 하고,
+    // 업그레이드 요청은 이 스레드에서 직접 핸드셰이크/프레이밍합니다.
+    m_tcpServer = new QTcpServer(this);
+    if (m_tcpServer->listen(QHostAddress::Any, m_port)) {
+        qDebug() << "Stream server listening on port" << m_port;
+        connect(m_tcpServer, &QTcpServer::newConnection, this, &StreamServer::onTcpConnection);
+        m_running = true;
+    } else {
+        qWarning() << "Failed to start stream server on port" << m_port;
+    }
+}
+
+void StreamServer::shutdown()
+{
+    m_running = false;
+    // 워커가 보내는 onFrameEncoded 콜백이 끝난 뒤 정리하도록 먼저 풀을 비움
+    m_encodePool.waitForDone();
+    m_videoPool.waitForDone();
+    if (m_tcpServer) m_tcpServer->close();
+    delete m_statsTimer;
+    m_statsTimer = nullptr;
+    // 진행 중인 파일 전송/썸네일 작업을 소켓보다 먼저 정리
+    delete m_clips;
+    m_clips = nullptr;
+
+    const QList<QTcpSocket*> clientSockets = m_clients.keys();
+    m_clients.clear();
+    for (QTcpSocket *socket : clientSockets) {
+        socket->disconnect(this);
+        delete socket;
+    }
+    const QSet<QTcpSocket*> httpSockets = m_httpSockets;
+    m_httpSockets.clear();
+    m_responsePending.clear();
+    for (QTcpSocket *socket : httpSockets) {
+        socket->disconnect(this);
+        delete socket;
+    }
+    delete m_tcpServer;
+    m_tcpServer = nullptr;
+    for (RenditionState &st : m_renditionState) st = RenditionState();
+    m_latestFrame = StreamFrame();
+    delete m_h264;
+    m_h264 = nullptr;
+    m_videoBusy = false;
+    m_videoPending = StreamFrame();
+    m_videoInit.clear();
+    m_videoInitFrames.clear();
+    m_videoGop.clear();
+
+    // 스레드 종료 후 메인 스레드에서 안전하게 delete 할 수 있도록 되돌려 놓음
+    moveToThread(QCoreApplication::instance()->thread());
+}
+
+void StreamServer::onNewFrame(const StreamFrame &frame)
+{
+    if (!m_running) return;
+    Trace::Scope scope("stream_dispatch", frame.seq);
+    Trace::flow(Trace::Flow::Step, frame.seq);
+    // 스냅샷 요청이 오면 바로 인코딩할 수 있도록 최신 프레임은 참조만 보관
+    m_latestSeq = frame.seq;
+    m_latestFrame = frame;
+
+    // 구독자(스트리밍 클라이언트 또는 대기 중인 스냅샷)가 있는 단계만 인코딩
+    for (int r = 0; r < m_renditions.size(); ++r) {
+        const bool wanted = m_renditionState.at(r).wanted();
+        if (isVideo(r)) {
+            if (wanted) requestVideoEncode(frame);
+            else m_videoGop.clear();   // 시청자가 없으면 인코딩을 멈추므로 캐시도 더 이상 이어지지 않음
+        } else if (wanted) {
+            requestEncode(r, frame);
+        }
+    }
+}
+
+void StreamServer::requestEncode(int rendition, const StreamFrame &frame)
+{
+    // 보정하지 않은 프레임이고 축소가 필요 없는 단계면 카메라 JPEG를 그대로 전달 (디코딩/인코딩 없음)
+    const int maxHeight = m_renditions.at(rendition).maxHeight;
+    if (!frame.sourceJpeg.isEmpty() && (maxHeight == 0 || frame.bgr.rows <= maxHeight)) {
+        publish(rendition, frame.seq, frame.sourceJpeg);
+        return;
+    }
+    if (m_encodesInFlight >= m_encodePool.maxThreadCount()) {
+        // 워커가 모두 바쁘면 대기열을 쌓지 않고 가장 최신 프레임 하나만 남김
+        if (m_stats && !m_renditionState.at(rendition).pending.bgr.empty()) m_stats->add(PipelineStats::StreamFramesSkipped);
+        m_renditionState[rendition].pending = frame;
+        return;
+    }
+    submitEncode(rendition, frame);
+}
+
+void StreamServer::submitEncode(int rendition, const StreamFrame &frame)
+{
+    ++m_encodesInFlight;
+    const Rendition rd = m_renditions.at(rendition);
+    m_encodePool.start([this, rendition, rd, frame]() {
+        Trace::setThreadName("stream-encode");
+        Trace::Scope scope("jpeg_encode", frame.seq);
+        Trace::flow(Trace::Flow::Step, frame.seq);
+        const qint64 startNs = PipelineStats::nowNs();
+        cv::Mat src = frame.bgr;
+        const cv::Size size = renditionSize(src.size(), rd.maxHeight);
+        if (size != src.size()) {
+            cv::Mat scaled;
+            cv::resize(src, scaled, size, 0, 0, cv::INTER_AREA);
+            src = scaled;
+        }
+        // 워커 스레드마다 TurboJPEG 핸들과 출력 버퍼를 재사용
+        QByteArray jpeg;
+        JpegEncoder::threadLocal().encode(src, rd.jpeg, jpeg);
+        if (m_stats) m_stats->record(PipelineStats::StreamEncode, PipelineStats::nowNs() - startNs);
+
+        const quint64 seq = frame.seq;
+        QMetaObject::invokeMethod(this, [this, rendition, seq, jpeg]() {
+            onFrameEncoded(rendition, seq, jpeg);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void StreamServer::onFrameEncoded(int rendition, quint64 seq, const QByteArray &jpeg)
+{
+    --m_encodesInFlight;
+    if (!m_running) return;
+    publish(rendition, seq, jpeg);
+    drainPendingEncodes();
+}
+
+void StreamServer::publish(int rendition, quint64 seq, const QByteArray &jpeg)
+{
+    // 여러 워커가 병렬로 인코딩하므로 이미 더 최신 프레임을 보냈다면 버림
+    RenditionState &st = m_renditionState[rendition];
+    if (seq > st.lastSentSeq && !jpeg.isEmpty()) {
+        Trace::Scope scope("stream_send", seq);
+        Trace::flow(Trace::Flow::Step, seq);
+        st.lastSentSeq = seq;
+        // 전송 형식별로 한 번만 프레이밍해서 같은 단계의 모든 클라이언트가 같은 바이트를 공유
+        QByteArray wsFrame, mjpegFrame;
+        for (auto it = m_clients.begin(); it != m_clients.end(); ++it) {
+            Client &c = it.value();
+            if (c.rendition != rendition) continue;
+            if (c.transport == Transport::WebSocket) {
+                if (wsFrame.isEmpty()) wsFrame = Ws::frame(Ws::Opcode::Binary, jpeg);
+                deliver(c, wsFrame);
+            } else {
+                if (mjpegFrame.isEmpty()) mjpegFrame = mjpegPart(jpeg);
+                deliver(c, mjpegFrame);
+            }
+        }
+        st.lastJpeg = jpeg;
+        st.lastJpegSeq = seq;
+        const QList<SnapshotWaiter> waiters = st.snapshotWaiters;
+        st.snapshotWaiters.clear();
+        for (const SnapshotWaiter &w : waiters) answerSnapshot(w, jpeg);
+    }
+}
+
+void StreamServer::drainPendingEncodes()
+{
+    for (int r = 0; r < m_renditionState.size(); ++r) {
+        if (m_encodesInFlight >= m_encodePool.maxThreadCount()) return;
+        RenditionState &st = m_renditionState[r];
+        if (st.pending.bgr.empty()) continue;
+        const StreamFrame next = st.pending;
+        st.pending = StreamFrame();
+        if (st.wanted()) submitEncode(r, next);
+    }
+}
+
+bool StreamServer::fitsBudget(const Client &c, qsizetype size) const
+{
+    // 아무것도 대기 중이 아니면 예산보다 큰 프레임이라도 한 장은 보냄
+    return c.inFlight == 0 || c.inFlight + size <= m_maxInFlight.load(std::memory_order_relaxed);
+}
+
+void StreamServer::deliver(Client &c, const QByteArray &bytes)
+{
+    if (fitsBudget(c, bytes.size())) {
+        ++c.sent;
+        send(c, bytes);
+        return;
+    }
+    // 느린 클라이언트: 아직 못 보낸 이전 프레임은 버리고 최신 프레임 하나만 보관
+    if (!c.pending.isEmpty()) ++c.dropped;
+    c.pending = bytes;
+}
+
+void StreamServer::send(Client &c, const QByteArray &bytes)
+{
+    if (c.inFlight == 0) c.lastProgress.restart();
+    // 4 KiB 이상이면 QTcpSocket 쓰기 버퍼가 QByteArray를 복사하지 않고 공유하므로
+    // 시청자가 수백 명이어도 프레임 바이트는 메모리에 하나뿐
+    c.tcp->write(bytes);
+    c.inFlight = c.tcp->bytesToWrite();
+    m_streamBytesSent += bytes.size();
+    ++m_streamFramesSent;
+}
+
+// ---- H.264 (fMP4) ----
+
+void StreamServer::requestVideoEncode(const StreamFrame &frame)
+{
+    if (!m_h264) return;
+    if (m_videoBusy) {
+        // 인코더는 하나뿐이므로 밀리면 최신 프레임 하나만 남기고 건너뜀
+        if (m_stats && !m_videoPending.bgr.empty()) m_stats->add(PipelineStats::StreamFramesSkipped);
+        m_videoPending = frame;
+        return;
+    }
+    submitVideoEncode(frame);
+}
+
+void StreamServer::submitVideoEncode(const StreamFrame &frame)
+{
+    m_videoBusy = true;
+    Fmp4Encoder *encoder = m_h264;
+    m_videoPool.start([this, encoder, frame]() {
+        Trace::setThreadName("h264-encode");
+        Trace::Scope scope("h264_encode", frame.seq);
+        Trace::flow(Trace::Flow::Step, frame.seq);
+        QList<Fmp4Encoder::Fragment> fragments;
+        const qint64 startNs = PipelineStats::nowNs();
+        encoder->encode(frame.bgr, frame.timestampMs, fragments);
+        if (m_stats) m_stats->record(PipelineStats::StreamEncode, PipelineStats::nowNs() - startNs);
+        const QByteArray init = encoder->initSegment();
+        const QString mime = encoder->mimeType();
+        QMetaObject::invokeMethod(this, [this, init, mime, fragments]() {
+            onVideoEncoded(init, mime, fragments);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void StreamServer::onVideoEncoded(const QByteArray &init, const QString &mime,
+                                  const QList<Fmp4Encoder::Fragment> &fragments)
+{
+    m_videoBusy = false;
+    if (!m_running) return;
+
+    if (!init.isEmpty() && init != m_videoInit) {
+        // 첫 인코딩이거나 해상도가 바뀌어 인코더가 다시 열림 → 모든 시청자가 init부터 다시 받음
+        m_videoInit = init;
+        m_videoInitFrames = jsonTextFrame({ { "type", "init" }, { "mime", mime } })
+                            + Ws::frame(Ws::Opcode::Binary, init);
+        m_videoGop.clear();
+        for (Client &c : m_clients) c.videoInitSent = false;
+    }
+    // fragment마다 WebSocket 프레임을 한 번만 만들어 GOP 캐시와 모든 시청자가 공유
+    QList<QByteArray> framed;
+    framed.reserve(fragments.size());
+    for (const Fmp4Encoder::Fragment &f : fragments) {
+        framed << Ws::frame(Ws::Opcode::Binary, f.data);
+        if (f.keyframe) m_videoGop.clear();
+        if (f.keyframe || !m_videoGop.isEmpty()) m_videoGop << framed.last();
+    }
+
+    for (auto it = m_clients.begin(); it != m_clients.end(); ++it) {
+        Client &c = it.value();
+        if (!isVideo(c.rendition)) continue;
+        if (!c.videoInitSent) {
+            sendVideoInit(c);   // GOP 캐시에 방금 나온 fragment까지 들어 있음
+            continue;
+        }
+        for (int i = 0; i < fragments.size(); ++i) deliverVideo(c, framed.at(i), fragments.at(i).keyframe);
+    }
+
+    if (!m_videoPending.bgr.empty()) {
+        const StreamFrame next = m_videoPending;
+        m_videoPending = StreamFrame();
+        if (m_renditionState.at(m_jpegRenditions).wanted()) submitVideoEncode(next);
+    }
+}
+
+void StreamServer::startVideoClient(Client &c)
+{
+    c.videoInitSent = false;
+    c.needKeyframe = true;
+    c.pending.clear();
+    // 캐시된 GOP가 없으면(인코딩을 막 시작) 다음 프레임을 키프레임으로 만들어 첫 화면 대기를 줄임
+    if (m_videoGop.isEmpty() && m_h264) m_h264->requestKeyframe();
+    sendVideoInit(c);
+}
+
+void StreamServer::sendVideoInit(Client &c)
+{
+    if (m_videoInit.isEmpty()) return;   // 첫 인코딩 결과가 나오면 onVideoEncoded에서 다시 호출됨
+    send(c, m_videoInitFrames);
+    c.videoInitSent = true;
+
+    // 가장 최근 키프레임부터 지금까지를 보내 바로 재생 (혼잡 예산과 무관하게 GOP 하나는 보냄)
+    for (const QByteArray &f : std::as_const(m_videoGop)) {
+        ++c.sent;
+        send(c, f);
+    }
+    c.needKeyframe = m_videoGop.isEmpty();
+}
+
+void StreamServer::deliverVideo(Client &c, const QByteArray &fragment, bool keyframe)
+{
+    if (c.needKeyframe && !keyframe) {
+        ++c.dropped;
+        return;
+    }
+    if (!fitsBudget(c, fragment.size())) {
+        // 중간 fragment를 빼면 디코딩이 깨지므로 혼잡하면 다음 키프레임까지 통째로 건너뜀
+        ++c.dropped;
+        c.needKeyframe = true;
+        return;
+    }
+    c.needKeyframe = false;
+    ++c.sent;
+    send(c, fragment);
 }
 
-void StreamServer::onNewFrame(const QImage &frame)
+void StreamServer::onBytesWritten()
 {
-    if (m_clients.isEmpty()) return; // 접속한 클라이언트가 없으면 아무것도 안 함
+    auto it = m_clients.find(qobject_cast<QTcpSocket *>(sender()));
+    if (it == m_clients.end()) return;
 
-    QByteArray byteArray;
-    QBuffer buffer(&byteArray);
-    buffer.open(QIODevice::WriteOnly);
-    // 프레임을 JPEG 형식, 70% 품질로 압축하여 용량 줄이기
-    frame.save(&buffer, "JPEG", 70);
+    Client &c = it.value();
+    c.inFlight = c.tcp->bytesToWrite();
+    c.lastProgress.restart();
+    if (!c.pending.isEmpty() && fitsBudget(c, c.pending.size())) {
+        const QByteArray next = c.pending;
+        c.pending.clear();
+        ++c.sent;
+        send(c, next);
+    }
+}
 
-    // 연결된 모든 클라이언트에게 압축된 이미지 데이터 전송
-    for (QWebSocket *client : m_clients) {
-        client->sendBinaryMessage(byteArray);
+int StreamServer::renditionIndex(const QString &name) const
+{
+    for (int r = 0; r < m_renditions.size(); ++r) {
+        if (m_renditions.at(r).name.compare(name, Qt::CaseInsensitive) == 0) return r;
     }
+    return -1;
 }
 
-void StreamServer::onNewConnection()
+void StreamServer::setClientRendition(Client &c, int rendition, bool autoMode)
 {
-    QWebSocket *client = m_server->nextPendingConnection();
-    if (client) {
-        qDebug() << "New client connected:" << client->peerAddress().toString();
-        connect(client, &QWebSocket::disconnected, this, &StreamServer::onSocketDisconnected);
-        m_clients << client;
+    c.autoRendition = autoMode;
+    c.calmTicks = 0;
+    if (rendition != c.rendition) {
+        --m_renditionState[c.rendition].subscribers;
+        ++m_renditionState[rendition].subscribers;
+        c.rendition = rendition;
+        c.pending.clear();  // 다른 해상도의 대기 프레임은 의미 없음
+        announceRendition(c);
+        if (isVideo(rendition)) startVideoClient(c);
+        return;
     }
+    announceRendition(c);
+}
+
+void StreamServer::announceRendition(Client &c)
+{
+    if (c.transport != Transport::WebSocket) return;
+    QJsonArray names;
+    for (const Rendition &rd : m_renditions) names << rd.name;
+    const QJsonObject msg {
+        { "type", "rendition" },
+        { "current", m_renditions.at(c.rendition).name },
+        { "auto", c.autoRendition },
+        { "available", names },
+    };
+    send(c, jsonTextFrame(msg));
 }
 
-void StreamServer::onSocketDisconnected()
+void StreamServer::onTextMessage(Client &c, const QString &message)
 {
-    QWebSocket *client = qobject_cast<QWebSocket *>(sender());
-    if (client) {
-        qDebug() << "Client disconnected:" << client->peerAddress().toString();
-        m_clients.removeAll(client);
-        client->deleteLater();
+    // {"rendition":"360p"} 또는 {"rendition":"auto"}
+    const QString name = QJsonDocument::fromJson(message.toUtf8()).object().value("rendition").toString();
+    if (name.compare("auto", Qt::CaseInsensitive) == 0) {
+        // 자동 모드는 JPEG 단계 안에서만 움직임
+        setClientRendition(c, isVideo(c.rendition) ? 0 : c.rendition, true);
+    } else if (int r = renditionIndex(name); r >= 0) {
+        setClientRendition(c, r, false);
     }
 }
+
+void StreamServer::abortClient(const Client &c)
+{
+    c.tcp->abort();
+}
+
+void StreamServer::onStatsTick()
+{
+    const double sec = qMax<qint64>(1, m_statsClock.restart()) / 1000.0;
+
+    QList<QTcpSocket*> stalled;
+    for (auto it = m_clients.begin(); it != m_clients.end(); ++it) {
+        Client &c = it.value();
+        const quint64 sentDelta = c.sent - c.sentAtLastTick;
+        const quint64 droppedDelta = c.dropped - c.droppedAtLastTick;
+        c.fps = sentDelta / sec;
+        c.sentAtLastTick = c.sent;
+        c.droppedAtLastTick = c.dropped;
+
+        // 자동 모드: 측정된 처리량(드롭 비율)에 따라 한 단계씩 조정
+        if (c.autoRendition && !isVideo(c.rendition)) {
+            const quint64 offered = sentDelta + droppedDelta;
+            if (droppedDelta >= 2 && droppedDelta > offered * AUTO_DOWN_DROP_RATIO
+                && c.rendition + 1 < m_jpegRenditions) {
+                setClientRendition(c, c.rendition + 1, true);
+            } else if (droppedDelta == 0 && ++c.calmTicks >= AUTO_UP_CALM_TICKS && c.rendition > 0) {
+                setClientRendition(c, c.rendition - 1, true);
+            } else if (droppedDelta > 0) {
+                c.calmTicks = 0;
+            }
+        }
+
+        if (c.inFlight > 0 && c.lastProgress.isValid() && c.lastProgress.elapsed() > CLIENT_STALL_TIMEOUT_MS) {
+            stalled << it.key();
+        }
+    }
+    // 전송이 멈춘 클라이언트는 끊어서 버퍼가 계속 붙잡혀 있지 않게 함
+    for (QTcpSocket *key : stalled) {
+        const Client c = m_clients.value(key);
+        qWarning() << "[StreamServer] Client stalled, closing:" << c.peer;
+        abortClient(c);
+    }
+
+    // 새 프레임이 오지 않아 오래 기다린 스냅샷 요청은 캐시로 응답
+    for (RenditionState &st : m_renditionState) {
+        for (int i = st.snapshotWaiters.size() - 1; i >= 0; --i) {
+            const SnapshotWaiter w = st.snapshotWaiters.at(i);
+            if (w.since.elapsed() < SNAPSHOT_TIMEOUT_MS) continue;
+            st.snapshotWaiters.removeAt(i);
+            if (!st.lastJpeg.isEmpty()) answerSnapshot(w, st.lastJpeg);
+            else if (w.socket) {
+                sendHttpError(w.socket, 503, w.keepAlive);
+                resumeHttpRequests(w.socket, w.keepAlive);
+            }
+        }
+    }
+}
+
+// ---- WebSocket ----
+
+void StreamServer::acceptWebSocket(QTcpSocket *socket, const HttpRequest &req)
+{
+    const QByteArray response = Ws::handshakeResponse(req);
+    if (response.isEmpty()) {
+        sendHttpError(socket, 400, false);
+        return;
+    }
+    m_httpSockets.remove(socket);
+    socket->write(response);
+    socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+    connect(socket, &QTcpSocket::bytesWritten, this, &StreamServer::onBytesWritten);
+
+    Client c;
+    c.transport = Transport::WebSocket;
+    c.tcp = socket;
+    c.peer = socket->peerAddress().toString();
+
+    // 접속 시 단계 선택: ws://host:8080/?q=360p  (없거나 auto면 원본에서 시작해 자동 조정)
+    const int r = renditionIndex(req.query.queryItemValue("q"));
+    c.rendition = r >= 0 ? r : 0;
+    c.autoRendition = r < 0;
+    ++m_renditionState[c.rendition].subscribers;
+    qDebug() << "New client connected:" << c.peer;
+
+    auto it = m_clients.insert(socket, c);
+    announceRendition(it.value());
+    if (isVideo(c.rendition)) startVideoClient(it.value());
+    // 핸드셰이크와 같은 패킷으로 이미 도착한 프레임이 있으면 바로 처리
+    if (socket->bytesAvailable() > 0) readWebSocket(it.value());
+}
+
+void StreamServer::readWebSocket(Client &c)
+{
+    c.wsIn.append(c.tcp->readAll());
+    Ws::Frame f;
+    for (;;) {
+        const Ws::ParseResult res = Ws::takeFrame(c.wsIn, f, MAX_WS_MESSAGE);
+        if (res == Ws::ParseResult::Incomplete) return;
+        if (res == Ws::ParseResult::Error) {
+            closeWebSocket(c, 1002);   // protocol error
+            return;
+        }
+        // closeWebSocket()은 연결을 바로 끊을 수 있으므로(c가 사라짐) 호출 뒤에는 c를 쓰지 않음
+        switch (f.opcode) {
+        case Ws::Opcode::Ping:
+            send(c, Ws::frame(Ws::Opcode::Pong, f.payload));
+            break;
+        case Ws::Opcode::Pong:
+            break;
+        case Ws::Opcode::Close:
+            closeWebSocket(c, 1000);
+            return;
+        case Ws::Opcode::Text:
+        case Ws::Opcode::Binary:
+        case Ws::Opcode::Continuation:
+            if (f.opcode != Ws::Opcode::Continuation) {
+                c.wsMessage.clear();
+                c.wsMessageText = (f.opcode == Ws::Opcode::Text);
+            }
+            if (c.wsMessage.size() + f.payload.size() > MAX_WS_MESSAGE) {
+                closeWebSocket(c, 1009);   // message too big
+                return;
+            }
+            c.wsMessage += f.payload;
+            if (f.fin) {
+                const QByteArray message = c.wsMessage;
+                c.wsMessage.clear();
+                if (c.wsMessageText) onTextMessage(c, QString::fromUtf8(message));
+            }
+            break;
+        default:
+            closeWebSocket(c, 1002);
+            return;
+        }
+    }
+}
+
+void StreamServer::closeWebSocket(Client &c, quint16 code)
+{
+    QTcpSocket *socket = c.tcp;
+    if (!c.closing) {
+        c.closing = true;
+        send(c, Ws::closeFrame(code));
+    }
+    socket->disconnectFromHost();   // 남은 데이터를 모두 보낸 뒤 닫힘 (바로 disconnected가 올 수도 있음)
+}
+
+// ---- HTTP ----
+
+void StreamServer::onTcpConnection()
+{
+    while (QTcpSocket *socket = m_tcpServer->nextPendingConnection()) {
+        socket->setParent(this);
+        m_httpSockets.insert(socket);
+        connect(socket, &QTcpSocket::readyRead, this, &StreamServer::onReadyRead);
+        connect(socket, &QTcpSocket::disconnected, this, &StreamServer::onDisconnected);
+    }
+}
+
+void StreamServer::onReadyRead()
+{
+    QTcpSocket *socket = qobject_cast<QTcpSocket *>(sender());
+    if (!socket) return;
+    auto it = m_clients.find(socket);
+    if (it != m_clients.end()) {
+        if (it.value().transport == Transport::WebSocket) readWebSocket(it.value());
+        else socket->readAll();  // MJPEG 스트리밍 중인 연결로 들어오는 데이터는 버림
+        return;
+    }
+    if (!m_httpSockets.contains(socket)) {
+        socket->readAll();
+        return;
+    }
+    processHttpRequests(socket);
+}
+
+void StreamServer::processHttpRequests(QTcpSocket *socket)
+{
+    // 비동기 응답(파일 전송/썸네일/스냅샷 대기) 중에는 다음 요청을 읽지 않음 (응답 순서가 바뀌지 않도록).
+    // 응답이 끝나면 resumeHttpRequests에서 이어서 처리
+    while (m_httpSockets.contains(socket) && socket->bytesAvailable() > 0 && !isResponsePending(socket)) {
+        // 헤더가 다 올 때까지는 소비하지 않도록 peek으로 파싱
+        const QByteArray head = socket->peek(MAX_HTTP_HEADER);
+        HttpRequest req;
+        bool incomplete = false;
+        if (!HttpRequest::parse(head, req, &incomplete)) {
+            if (incomplete && head.size() < MAX_HTTP_HEADER) return;  // 헤더가 더 오기를 기다림
+            sendHttpError(socket, 400, false);
+            return;
+        }
+        socket->read(req.headerLength);
+        if (req.isWebSocketUpgrade()) {
+            acceptWebSocket(socket, req);
+            return;
+        }
+        handleHttpRequest(socket, req);
+    }
+}
+
+bool StreamServer::isResponsePending(QTcpSocket *socket) const
+{
+    return m_responsePending.contains(socket) || (m_clips && m_clips->isBusy(socket));
+}
+
+void StreamServer::onHttpResponseFinished(QTcpSocket *socket, bool keepAlive)
+{
+    finishHttpResponse(socket, keepAlive);
+    resumeHttpRequests(socket, keepAlive);
+}
+
+void StreamServer::resumeHttpRequests(QTcpSocket *socket, bool keepAlive)
+{
+    m_responsePending.remove(socket);
+    if (keepAlive && socket->bytesAvailable() > 0) {
+        // 비동기로 끝난 응답 뒤에 파이프라이닝된 요청이 남아 있으면 이어서
+        QPointer<QTcpSocket> guard(socket);
+        QMetaObject::invokeMethod(this, [this, guard]() {
+            if (guard) processHttpRequests(guard);
+        }, Qt::QueuedConnection);
+    }
+}
+
+void StreamServer::onDisconnected()
+{
+    QTcpSocket *socket = qobject_cast<QTcpSocket *>(sender());
+    if (!socket) return;
+    m_httpSockets.remove(socket);
+    m_responsePending.remove(socket);
+    if (m_clips) m_clips->socketClosed(socket);
+    auto it = m_clients.find(socket);
+    if (it != m_clients.end()) {
+        --m_renditionState[it.value().rendition].subscribers;
+        qDebug() << (it.value().transport == Transport::WebSocket ? "Client disconnected:" : "MJPEG client disconnected:")
+                 << it.value().peer << "sent" << it.value().sent << "dropped" << it.value().dropped;
+        m_clients.erase(it);
+    }
+    socket->deleteLater();
+}
+
+void StreamServer::handleHttpRequest(QTcpSocket *socket, const HttpRequest &req)
+{
+    if (req.method != "GET" && req.method != "HEAD") {
+        sendHttpError(socket, 405, false);
+        return;
+    }
+
+    // 녹화 클립 (/api/clips, /clips/...)
+    if (m_clips && m_clips->handle(socket, req)) return;
+
+    const QString q = req.query.queryItemValue("q");
+    int r = renditionIndex(q);
+    if (r >= 0 && isVideo(r)) r = 0;   // H.264는 WebSocket 전용 → HTTP는 원본 JPEG
+
+    if (req.path == "/stream.mjpg" || req.path == "/mjpeg") {
+        startMjpeg(socket, r);
+    } else if (req.path == "/metrics") {
+        answerMetrics(socket, req);
+    } else if (req.path == "/trace.json") {
+        answerTrace(socket, req);
+    } else if (req.path == "/snapshot.jpg") {
+        SnapshotWaiter w;
+        w.socket = socket;
+        w.keepAlive = req.keepAlive();
+        w.headOnly = (req.method == "HEAD");
+        w.since.start();
+
+        const int rendition = r >= 0 ? r : 0;
+        RenditionState &st = m_renditionState[rendition];
+        if (!st.lastJpeg.isEmpty() && st.lastJpegSeq >= m_latestSeq) {
+            // 마지막으로 받은 프레임이 이미 인코딩돼 있으면 캐시로 바로 응답 (추가 인코딩 없음)
+            answerSnapshot(w, st.lastJpeg);
+            return;
+        }
+        // 다음 인코딩 결과를 기다리는 요청들은 모두 같은 JPEG 하나로 응답.
+        // 응답할 때까지 이 연결의 다음 요청은 읽지 않음
+        const bool encodeScheduled = st.wanted();
+        st.snapshotWaiters << w;
+        m_responsePending.insert(socket);
+        if (!encodeScheduled && !m_latestFrame.bgr.empty()) requestEncode(rendition, m_latestFrame);
+    } else {
+        sendHttpError(socket, 404, req.keepAlive());
+    }
+}
+
+void StreamServer::startMjpeg(QTcpSocket *socket, int rendition)
+{
+    m_httpSockets.remove(socket);
+    socket->write(Http::responseHead(200, {
+        { "Content-Type", QByteArray("multipart/x-mixed-replace; boundary=") + MJPEG_BOUNDARY },
+        { "Cache-Control", "no-cache, no-store" },
+        { "Pragma", "no-cache" },
+        { "Connection", "close" },
+    }));
+
+    socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+
+    Client c;
+    c.transport = Transport::Mjpeg;
+    c.tcp = socket;
+    c.peer = socket->peerAddress().toString();
+    c.rendition = rendition >= 0 ? rendition : 0;
+    c.autoRendition = rendition < 0;
+    ++m_renditionState[c.rendition].subscribers;
+    connect(socket, &QTcpSocket::bytesWritten, this, &StreamServer::onBytesWritten);
+    m_clients.insert(socket, c);
+    qDebug() << "MJPEG client connected:" << c.peer;
+}
+
+void StreamServer::answerSnapshot(const SnapshotWaiter &w, const QByteArray &jpeg)
+{
+    if (!w.socket) return;
+    w.socket->write(Http::responseHead(200, {
+        { "Content-Type", "image/jpeg" },
+        { "Content-Length", QByteArray::number(jpeg.size()) },
+        { "Cache-Control", "no-cache, no-store" },
+        { "Connection", w.keepAlive ? "keep-alive" : "close" },
+    }));
+    if (!w.headOnly) w.socket->write(jpeg);
+    onHttpResponseFinished(w.socket, w.keepAlive);
+}
+
+// Prometheus 텍스트 형식. 감지 파이프라인 값은 원자 카운터를 읽기만 하므로 감지 루프에 영향 없음
+void StreamServer::answerMetrics(QTcpSocket *socket, const HttpRequest &req)
+{
+    QByteArray body;
+    const QByteArray camera = "camera=\"" + m_statsCamera + '"';
+    if (m_stats) m_stats->appendPrometheus(body, camera);
+
+    int wsClients = 0, mjpegClients = 0;
+    for (const Client &c : std::as_const(m_clients)) {
+        if (c.transport == Transport::WebSocket) ++wsClients;
+        else ++mjpegClients;
+    }
+    body += "# HELP cctv_stream_clients Connected streaming clients.\n"
+            "# TYPE cctv_stream_clients gauge\n"
+            "cctv_stream_clients{" + camera + ",transport=\"websocket\"} " + QByteArray::number(wsClients) + "\n"
+            "cctv_stream_clients{" + camera + ",transport=\"mjpeg\"} " + QByteArray::number(mjpegClients) + "\n"
+            "# HELP cctv_stream_bytes_sent_total Bytes queued to streaming clients.\n"
+            "# TYPE cctv_stream_bytes_sent_total counter\n"
+            "cctv_stream_bytes_sent_total{" + camera + "} " + QByteArray::number(m_streamBytesSent) + "\n"
+            "# HELP cctv_stream_frames_sent_total Frames queued to streaming clients (one per client).\n"
+            "# TYPE cctv_stream_frames_sent_total counter\n"
+            "cctv_stream_frames_sent_total{" + camera + "} " + QByteArray::number(m_streamFramesSent) + "\n";
+
+    // 클라이언트별 (연결마다 한 시리즈, 끊기면 사라짐). 자동 모드는 단계가 바뀌므로 단계는 info 시리즈로 따로
+    QByteArray sent, dropped, fps, inFlight, rendition;
+    for (const Client &c : std::as_const(m_clients)) {
+        const QByteArray labels = '{' + camera + ",peer=\"" + c.peer.toUtf8() + ':'
+                                  + QByteArray::number(c.tcp->peerPort()) + "\",transport=\""
+                                  + (c.transport == Transport::WebSocket ? "websocket" : "mjpeg") + '"';
+        sent += "cctv_stream_client_frames_sent_total" + labels + "} " + QByteArray::number(c.sent) + '\n';
+        dropped += "cctv_stream_client_frames_dropped_total" + labels + "} " + QByteArray::number(c.dropped) + '\n';
+        fps += "cctv_stream_client_fps" + labels + "} " + QByteArray::number(c.fps, 'f', 1) + '\n';
+        inFlight += "cctv_stream_client_bytes_in_flight" + labels + "} " + QByteArray::number(c.inFlight) + '\n';
+        rendition += "cctv_stream_client_rendition_info" + labels + ",rendition=\"" + m_renditions.at(c.rendition).name.toUtf8()
+                     + "\",auto=\"" + (c.autoRendition ? "true" : "false") + "\"} 1\n";
+    }
+    body += "# HELP cctv_stream_client_frames_sent_total Frames queued to this client.\n"
+            "# TYPE cctv_stream_client_frames_sent_total counter\n" + sent
+          + "# HELP cctv_stream_client_frames_dropped_total Frames skipped for this client because it was congested.\n"
+            "# TYPE cctv_stream_client_frames_dropped_total counter\n" + dropped
+          + "# HELP cctv_stream_client_fps Frames per second actually sent to this client over the last stats interval.\n"
+            "# TYPE cctv_stream_client_fps gauge\n" + fps
+          + "# HELP cctv_stream_client_bytes_in_flight Bytes waiting in this client's socket buffer.\n"
+            "# TYPE cctv_stream_client_bytes_in_flight gauge\n" + inFlight
+          + "# HELP cctv_stream_client_rendition_info Rendition this client currently receives.\n"
+            "# TYPE cctv_stream_client_rendition_info gauge\n" + rendition;
+
+    const bool keepAlive = req.keepAlive();
+    socket->write(Http::responseHead(200, {
+        { "Content-Type", "text/plain; version=0.0.4; charset=utf-8" },
+        { "Content-Length", QByteArray::number(body.size()) },
+        { "Cache-Control", "no-cache, no-store" },
+        { "Connection", keepAlive ? "keep-alive" : "close" },
+    }));
+    if (req.method != "HEAD") socket->write(body);
+    finishHttpResponse(socket, keepAlive);
+}
+
+// 최근 추적 기록 (Chrome trace JSON). 추적이 꺼져 있으면 503 (CCTV_TRACE=1 또는 Tab1의 T 키로 켬)
+void StreamServer::answerTrace(QTcpSocket *socket, const HttpRequest &req)
+{
+    if (!Trace::isEnabled()) {
+        sendHttpError(socket, 503, req.keepAlive());
+        return;
+    }
+    bool ok = false;
+    int seconds = req.query.queryItemValue("s").toInt(&ok);
+    if (!ok || seconds < 0) seconds = TRACE_WINDOW_S;
+    const QByteArray body = Trace::toJson(qint64(seconds) * 1'000'000'000);
+
+    const bool keepAlive = req.keepAlive();
+    socket->write(Http::responseHead(200, {
+        { "Content-Type", "application/json" },
+        { "Content-Length", QByteArray::number(body.size()) },
+        { "Content-Disposition", "attachment; filename=\"cctv-trace.json\"" },
+        { "Cache-Control", "no-cache, no-store" },
+        { "Connection", keepAlive ? "keep-alive" : "close" },
+    }));
+    if (req.method != "HEAD") socket->write(body);
+    finishHttpResponse(socket, keepAlive);
+}
+
+void StreamServer::sendHttpError(QTcpSocket *socket, int status, bool keepAlive)
+{
+    const QByteArray body = Http::reasonPhrase(status) + "\n";
+    socket->write(Http::responseHead(status, {
+        { "Content-Type", "text/plain; charset=utf-8" },
+        { "Content-Length", QByteArray::number(body.size()) },
+        { "Connection", keepAlive ? "keep-alive" : "close" },
+    }));
+    socket->write(body);
+    finishHttpResponse(socket, keepAlive);
+}
+
+void StreamServer::finishHttpResponse(QTcpSocket *socket, bool keepAlive)
+{
+    if (keepAlive) return;
+    m_httpSockets.remove(socket);
+    socket->disconnectFromHost();   // 남은 데이터를 모두 보낸 뒤 닫힘
+}
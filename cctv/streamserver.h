@@ -3,31 +3,228 @@
 
 #include <QObject>
 #include <QList>
-#include <QImage>
+#include <QHash>
+#include <QSet>
+#include <QVector>
+#include <QPointer>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QThreadPool>
+#include <atomic>
+#include "streamframe.h"
+#include "jpegencoder.h"
+#include "fmp4encoder.h"
 
-class QWebSocketServer;
-class QWebSocket;
+class QTcpServer;
+class QTcpSocket;
+class QTimer;
+class ClipServer;
+class PipelineStats;
+struct HttpRequest;
 
+// 한 포트(8080)에서 다음을 모두 제공합니다.
+//   ws://host:8080/?q=720p        WebSocket JPEG 스트림
+//   http://host:8080/stream.mjpg  multipart/x-mixed-replace (VLC, ffmpeg, <img src>)
+//   http://host:8080/snapshot.jpg 현재 프레임 한 장
+//   http://host:8080/api/clips    녹화 클립 목록/썸네일/재생 (ClipServer)
+// 모든 경로가 단계(rendition)별로 한 번 인코딩된 같은 JPEG를 공유하며,
+// 보정하지 않은 프레임은 카메라가 보낸 JPEG를 인코딩 없이 그대로 전달합니다.
+// FFmpeg(libx264)가 있으면 ws://host:8080/?q=h264 로 fMP4(MSE) H.264 스트림도 제공합니다.
+//
+// 모든 소켓은 전용 네트워크 스레드의 이벤트 루프에서 처리합니다. WebSocket도 직접 프레이밍하므로
+// 프레임마다 전송 바이트(WebSocket 프레임 / MJPEG 파트)를 한 번만 만들고 모든 시청자가 공유합니다.
 class StreamServer : public QObject
 {
     Q_OBJECT
 public:
+    // 해상도/화질 단계. 구독 중인 클라이언트가 있는 단계만 인코딩합니다.
+    enum class Codec { Jpeg, H264 };
+
+    struct Rendition {
+        QString name;
+        int     maxHeight = 0;       // 0 = 원본 해상도
+        JpegEncoder::Options jpeg;
+        Codec   codec = Codec::Jpeg; // H264는 WebSocket 전용, 해상도/비트레이트는 H.264 옵션을 따름
+    };
+
+    // 기본 JPEG 단계. 인덱스가 작을수록 고화질이고 자동 모드는 이 순서대로 한 단계씩 오르내립니다
+    static QVector<Rendition> jpegRenditions();
+    // maxHeight 단계로 보낼 크기 (4:2:0 서브샘플링에 맞게 짝수 폭). 원본이 더 작거나 0이면 그대로
+    static cv::Size renditionSize(cv::Size source, int maxHeight);
+
+    // parent를 지정하지 않아야 start()에서 전용 네트워크 스레드로 옮길 수 있음
     explicit StreamServer(quint16 port, QObject *parent = nullptr);
     ~StreamServer();
 
+    void start();
+    void stop();
+
+    // 클라이언트 하나가 전송 완료를 기다리며 쌓아 둘 수 있는 최대 바이트.
+    // 이를 넘으면 그 클라이언트만 프레임을 건너뛰고 항상 최신 프레임을 받습니다.
+    void setMaxInFlightBytes(qint64 bytes);
+
+    // H.264 스트림의 GOP/비트레이트/해상도. start() 전에 호출해야 적용됩니다.
+    void setH264Options(const Fmp4Encoder::Options &opt);
+
+    // /api/clips, /clips/...로 제공할 녹화 폴더. start() 전에 호출해야 적용됩니다.
+    void setClipDirectory(const QString &dir);
+
+    // 인코딩 시간/건너뛴 프레임을 기록할 감지 파이프라인 통계 (서버보다 오래 살아야 함). start() 전에 호출.
+    // /metrics에서 camera 라벨로 함께 내보냄 (클라이언트별 전송 통계도 /metrics에 있음)
+    void setPipelineStats(PipelineStats *stats, const QString &camera = QStringLiteral("0"));
+
 public slots:
-    // MotionDetector로부터 새로운 프레임을 받을 슬롯
-    void onNewFrame(const QImage &frame);
+    // MotionDetector로부터 새로운 프레임을 받을 슬롯 (네트워크 스레드에서 실행)
+    void onNewFrame(const StreamFrame &frame);
 
 private slots:
-    // 새로운 웹 클라이언트가 접속했을 때
-    void onNewConnection();
-    // 웹 클라이언트의 연결이 끊어졌을 때
-    void onSocketDisconnected();
+    void startListening();
+    void onTcpConnection();
+    void onReadyRead();
+    // 클라이언트(HTTP/WebSocket/MJPEG)의 연결이 끊어졌을 때
+    void onDisconnected();
+    void onBytesWritten();
+    void onHttpResponseFinished(QTcpSocket *socket, bool keepAlive);
+    void onStatsTick();
 
 private:
-    QWebSocketServer* m_server;
-    QList<QWebSocket*> m_clients;
+    enum class Transport { WebSocket, Mjpeg };
+
+    struct Client {
+        Transport     transport = Transport::WebSocket;
+        QTcpSocket*   tcp      = nullptr;
+        QString       peer;
+        int           rendition = 0;    // m_renditions 인덱스
+        bool          autoRendition = true;
+        qint64        inFlight = 0;     // 소켓 쓰기 버퍼에 남은 바이트 (bytesToWrite)
+        QByteArray    pending;          // 혼잡할 때 보관하는 최신 프레임 1장 (전송 형식으로 프레이밍된 바이트)
+        bool          videoInitSent = false; // H.264: init segment를 보냈는지
+        bool          needKeyframe  = true;  // H.264: 다음 키프레임까지 fragment를 건너뜀
+        quint64       sent     = 0;
+        quint64       dropped  = 0;
+        quint64       sentAtLastTick = 0;
+        quint64       droppedAtLastTick = 0;
+        int           calmTicks = 0;    // 드롭 없이 지나간 통계 주기 수 (자동 화질 상향용)
+        double        fps      = 0.0;   // 최근 통계 주기 동안 실제로 보낸 프레임 수/초
+        QElapsedTimer lastProgress;     // 마지막으로 전송이 진척된 시각 (정체 감지용)
+        QByteArray    wsIn;             // 아직 완성되지 않은 수신 프레임
+        QByteArray    wsMessage;        // 조각난(continuation) 메시지 누적
+        bool          wsMessageText = false;
+        bool          closing  = false; // Close 프레임을 보냈음
+    };
+
+    struct SnapshotWaiter {
+        QPointer<QTcpSocket> socket;
+        bool          keepAlive = false;
+        bool          headOnly  = false;
+        QElapsedTimer since;
+    };
+
+    struct RenditionState {
+        int         subscribers = 0;
+        quint64     lastSentSeq = 0;
+        StreamFrame pending;            // 워커가 모두 바쁠 때 보관하는 최신 프레임
+        QByteArray  lastJpeg;           // 가장 최근에 인코딩된 프레임 (스냅샷 캐시)
+        quint64     lastJpegSeq = 0;
+        QList<SnapshotWaiter> snapshotWaiters;
+
+        bool wanted() const { return subscribers > 0 || !snapshotWaiters.isEmpty(); }
+    };
+
+    void requestEncode(int rendition, const StreamFrame &frame);
+    void submitEncode(int rendition, const StreamFrame &frame);
+    void onFrameEncoded(int rendition, quint64 seq, const QByteArray &jpeg);
+    void publish(int rendition, quint64 seq, const QByteArray &jpeg);
+    void drainPendingEncodes();
+    void deliver(Client &c, const QByteArray &bytes);
+    void send(Client &c, const QByteArray &bytes);
+    bool fitsBudget(const Client &c, qsizetype size) const;
+    void setClientRendition(Client &c, int rendition, bool autoMode);
+    void announceRendition(Client &c);
+    int  renditionIndex(const QString &name) const;
+    void abortClient(const Client &c);
+
+    // WebSocket
+    void acceptWebSocket(QTcpSocket *socket, const HttpRequest &req);
+    void readWebSocket(Client &c);
+    void onTextMessage(Client &c, const QString &message);
+    void closeWebSocket(Client &c, quint16 code);
+    bool isVideo(int rendition) const { return m_renditions.at(rendition).codec == Codec::H264; }
+
+    // H.264 (fMP4)
+    void requestVideoEncode(const StreamFrame &frame);
+    void submitVideoEncode(const StreamFrame &frame);
+    void onVideoEncoded(const QByteArray &init, const QString &mime, const QList<Fmp4Encoder::Fragment> &fragments);
+    void startVideoClient(Client &c);
+    void sendVideoInit(Client &c);
+    void deliverVideo(Client &c, const QByteArray &fragment, bool keyframe);
+
+    // HTTP
+    void processHttpRequests(QTcpSocket *socket);
+    bool isResponsePending(QTcpSocket *socket) const;
+    void resumeHttpRequests(QTcpSocket *socket, bool keepAlive);
+    void handleHttpRequest(QTcpSocket *socket, const HttpRequest &req);
+    void startMjpeg(QTcpSocket *socket, int rendition);
+    void answerSnapshot(const SnapshotWaiter &w, const QByteArray &jpeg);
+    void answerMetrics(QTcpSocket *socket, const HttpRequest &req);
+    void answerTrace(QTcpSocket *socket, const HttpRequest &req);
+    void sendHttpError(QTcpSocket *socket, int status, bool keepAlive);
+    void finishHttpResponse(QTcpSocket *socket, bool keepAlive);
+
+    void shutdown();
+
+private:
+    quint16            m_port;
+    QThread            m_thread;        // 소켓 송수신 전용 스레드
+    QThreadPool        m_encodePool;    // JPEG 인코딩 워커 풀
+    QThreadPool        m_videoPool;     // H.264 인코딩 (상태가 있는 인코더라 스레드 1개로 순서대로)
+    QTcpServer*        m_tcpServer = nullptr;
+    QTimer*            m_statsTimer = nullptr;
+    ClipServer*        m_clips = nullptr;
+    QString            m_clipDir;
+    PipelineStats*     m_stats = nullptr;   // 인코딩 워커에서도 씀 (start 후에는 바뀌지 않음)
+    QByteArray         m_statsCamera = "0";   // /metrics의 camera 라벨
+    quint64            m_streamBytesSent = 0;    // 스트리밍 클라이언트에 보낸 바이트 (네트워크 스레드)
+    quint64            m_streamFramesSent = 0;
+    QHash<QTcpSocket*, Client> m_clients;   // WebSocket/MJPEG 스트리밍 클라이언트
+    QSet<QTcpSocket*>  m_httpSockets;       // 아직 요청을 처리 중인 HTTP 연결
+    QSet<QTcpSocket*>  m_responsePending;   // 스냅샷 인코딩을 기다리는 HTTP 연결 (응답 전까지 다음 요청을 읽지 않음)
+    bool               m_running = false;
+    std::atomic<qint64> m_maxInFlight{1024 * 1024};
+    QElapsedTimer      m_statsClock;
+
+    // 인코딩 파이프라인 상태 (네트워크 스레드에서만 접근)
+    QVector<Rendition>      m_renditions;
+    QVector<RenditionState> m_renditionState;
+    int     m_encodesInFlight = 0;
+    quint64 m_latestSeq = 0;                // 마지막으로 받은 프레임 번호
+    StreamFrame m_latestFrame;
+    int     m_jpegRenditions = 0;           // m_renditions 앞쪽의 JPEG 단계 수 (자동 모드 범위)
+
+    // H.264 상태. m_h264는 m_videoPool 안에서만 사용
+    Fmp4Encoder::Options m_h264Options;
+    Fmp4Encoder*      m_h264 = nullptr;
+    bool              m_videoBusy = false;
+    StreamFrame       m_videoPending;       // 인코딩 중에 들어온 최신 프레임 1장
+    QByteArray        m_videoInit;          // 현재 init segment (ftyp+moov)
+    QByteArray        m_videoInitFrames;    // {"type":"init"} 텍스트 + init segment, WebSocket 프레임으로
+    QList<QByteArray> m_videoGop;           // 최근 키프레임부터의 fragment (WebSocket 프레임, 새 시청자 즉시 재생용)
 };
 
+// tools/kernelbench가 서버를 링크하지 않고 같은 표/크기로 잴 수 있도록 헤더에 둠
+inline QVector<StreamServer::Rendition> StreamServer::jpegRenditions()
+{
+    return {
+        { QStringLiteral("full"), 0,   { 70, JpegEncoder::Subsampling::S420, true } },
+        { QStringLiteral("720p"), 720, { 60, JpegEncoder::Subsampling::S420, true } },
+        { QStringLiteral("360p"), 360, { 50, JpegEncoder::Subsampling::S420, true } },
+    };
+}
+
+inline cv::Size StreamServer::renditionSize(cv::Size source, int maxHeight)
+{
+    if (maxHeight <= 0 || source.height <= maxHeight) return source;
+    return cv::Size((source.width * maxHeight / source.height) & ~1, maxHeight);
+}
+
 #endif // STREAMSERVER_H
@@ -1,11 +1,17 @@
 #include "tab1_camera.h"
 #include "ui_tab1_camera.h"
+#include "trace.h"
 #include <QDir>
 #include <QDebug>
 #include <QMessageBox>
 #include <QTimer>
+#include <QToolTip>
 #include <QVBoxLayout> // ensureCamLabel 폴백을 위해 추가
 
+namespace {
+constexpr int STATS_INTERVAL_MS = 1000;   // 통계 오버레이 갱신 주기 (= 표시 구간)
+}
+
 Tab1_camera::Tab1_camera(QWidget *parent)
     : QWidget(parent)
     , ui(new Ui::Tab1_camera)
@@ -37,9 +43,22 @@ Tab1_camera::~Tab1_camera() {
     delete ui;
 }
 
-// ✅ 스페이스 바를 누르면 자동 CLAHE 모드를 켜고 끄는 로직
+// ✅ 스페이스 바를 누르면 자동 CLAHE 모드를 켜고 끄는 로직 (S 키는 통계 오버레이, T 키는 추적)
 void Tab1_camera::keyPressEvent(QKeyEvent *event) {
-    if (event->key() == Qt::Key_Space) {
+    if (event->key() == Qt::Key_S) {
+        setStatsOverlayVisible(!(m_statsOverlay && m_statsOverlay->isVisible()));
+    } else if (event->key() == Qt::Key_T) {
+        // 꺼져 있으면 켜고, 켜져 있으면 지금까지의 기록을 파일로 저장
+        if (!Trace::isEnabled()) {
+            Trace::setEnabled(true);
+            QToolTip::showText(mapToGlobal(QPoint(10, 10)), QStringLiteral("추적 시작 (T: 저장)"), this);
+            return;
+        }
+        const QString path = Trace::dump("manual");
+        qDebug() << "[UI] trace saved:" << path;
+        QToolTip::showText(mapToGlobal(QPoint(10, 10)),
+                           path.isEmpty() ? QStringLiteral("추적 저장 실패") : QStringLiteral("추적 저장: ") + path, this);
+    } else if (event->key() == Qt::Key_Space) {
         m_autoClaheEnabled = !m_autoClaheEnabled; // 상태 뒤집기
         QMetaObject::invokeMethod(m_detector, "setAutoClaheEnabled", Q_ARG(bool, m_autoClaheEnabled));
         qDebug() << "[UI] Auto-CLAHE Mode Toggled:" << m_autoClaheEnabled;
@@ -57,7 +76,9 @@ void Tab1_camera::keyPressEvent(QKeyEvent *event) {
 }
 
 // ✅ [최종] UI를 업데이트하는 슬롯 구현
-void Tab1_camera::onFrameReady(const QImage &img, double clipLimit) {
+void Tab1_camera::onFrameReady(const QImage &img, double clipLimit, quint64 frameId) {
+    Trace::Scope scope("display", frameId);
+    Trace::flow(Trace::Flow::End, frameId);
     m_lastFrame = img;
     if (!m_showing) return;
 
@@ -139,3 +160,54 @@ void Tab1_camera::closePopup() {
     if (m_alertBox) m_alertBox->close();
 }
 
+void Tab1_camera::setStatsOverlayVisible(bool visible) {
+    if (!m_statsOverlay) {
+        m_statsOverlay = new QLabel(m_camLabel);
+        m_statsOverlay->setStyleSheet("background:rgba(0,0,0,160);color:#e0e0e0;padding:6px;"
+                                      "font-family:monospace;font-size:11px;");
+        m_statsOverlay->setAttribute(Qt::WA_TransparentForMouseEvents);
+        m_statsOverlay->move(10, 10);
+        m_statsTimer = new QTimer(this);
+        m_statsTimer->setInterval(STATS_INTERVAL_MS);
+        connect(m_statsTimer, &QTimer::timeout, this, &Tab1_camera::updateStatsOverlay);
+    }
+    if (!visible) {
+        m_statsTimer->stop();
+        m_statsOverlay->hide();
+        return;
+    }
+    m_lastStats = m_detector->stats().snapshot();
+    m_statsOverlay->setText(QStringLiteral("통계 수집 중..."));
+    m_statsOverlay->adjustSize();
+    m_statsOverlay->show();
+    m_statsOverlay->raise();
+    m_statsTimer->start();
+}
+
+// 직전 갱신 이후(최근 1초)의 단계별 p50/p99/max와 프레임/드롭 수
+void Tab1_camera::updateStatsOverlay() {
+    const PipelineStats::Snapshot now = m_detector->stats().snapshot();
+    const double sec = qMax(1e-3, (now.takenAtNs - m_lastStats.takenAtNs) / 1e9);
+    auto delta = [&](PipelineStats::Counter c) { return now.counters[c] - m_lastStats.counters[c]; };
+    auto ms = [](double us) { return QString::number(us / 1000.0, 'f', 2).rightJustified(8); };
+
+    QString text = QString("%1 fps processed, %2 fps captured\n")
+                       .arg(delta(PipelineStats::FramesProcessed) / sec, 0, 'f', 1)
+                       .arg(delta(PipelineStats::FramesCaptured) / sec, 0, 'f', 1);
+    text += QString("drops: read %1  proxy %2  stream %3\n\n")
+                .arg(delta(PipelineStats::CaptureFailures))
+                .arg(delta(PipelineStats::ProxyFramesDropped))
+                .arg(delta(PipelineStats::StreamFramesSkipped));
+    text += QString("stage").leftJustified(14) + "     p50     p99     max  (ms)\n";
+    for (int i = 0; i < PipelineStats::STAGE_COUNT; ++i) {
+        const auto stage = PipelineStats::Stage(i);
+        const LatencyHistogram::Summary sum = LatencyHistogram::summarize(now.stages[i], &m_lastStats.stages[i]);
+        text += QString(PipelineStats::stageName(stage)).leftJustified(14);
+        if (sum.count == 0) text += QString("-").rightJustified(8) + "\n";
+        else text += ms(sum.p50Us) + ms(sum.p99Us) + ms(sum.maxUs) + "\n";
+    }
+    m_lastStats = now;
+
+    m_statsOverlay->setText(text.trimmed());
+    m_statsOverlay->adjustSize();
+}
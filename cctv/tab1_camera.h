@@ -28,7 +28,7 @@ protected:
 
 private slots:
     void onToggleDisplay();
-    void onFrameReady(const QImage& img, double clipLimit);
+    void onFrameReady(const QImage& img, double clipLimit, quint64 frameId);
     void onDetected();
     void onDetectionCleared();
 
@@ -37,6 +37,8 @@ private:
     void setDisplayEnabled(bool enable);
     void showPopup();
     void closePopup();
+    void setStatsOverlayVisible(bool visible);
+    void updateStatsOverlay();
 
 private:
     Ui::Tab1_camera *ui;
@@ -48,6 +50,9 @@ private:
     QImage m_lastFrame;
     bool m_isAlertActive = false;
     bool m_autoClaheEnabled = true;
+    class QLabel *m_statsOverlay = nullptr;   // S 키: 단계별 지연/프레임 통계
+    class QTimer *m_statsTimer = nullptr;
+    PipelineStats::Snapshot m_lastStats;      // 직전 갱신 시점 (차이 = 최근 1초)
 };
 
 #endif // TAB1_CAMERA_H
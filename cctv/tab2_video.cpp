@@ -1,8 +1,18 @@
 #include "tab2_video.h"
 #include "ui_tab2_video.h"
-
-#include <QListWidget>
-#include <QListWidgetItem>
+#include "activitybar.h"
+#include "clipcatalog.h"
+#include "clipindex.h"
+#include "clipwatcher.h"
+#include "gallerymodel.h"
+#include "motionsearchdialog.h"
+#include "motiontrack.h"
+
+#include <QListView>
+#include <QCheckBox>
+#include <QMouseEvent>
+#include <QScrollBar>
+#include <QFile>
 #include <QFileInfo>
 #include <QDir>
 #include <QTimer>
@@ -13,21 +23,12 @@
 
 #include <QMediaPlayer>
 #include <QVideoWidget>
-#include <QPainter>
-#include <QPixmap>
-#include <QImage>
-#include <opencv2/opencv.hpp>
-#include <QMap>
-#include <QDate>
 #include <QDebug>
-#include <QFuture>
-#include <QtConcurrent>
-
-// 유틸
-static bool isVideoFile(const QString& fn) {
-    const QString ext = QFileInfo(fn).suffix().toLower();
-    static const QStringList ok = {"mp4","mov","m4v","avi","mkv","wmv"};
-    return ok.contains(ext);
+
+namespace {
+constexpr int SCROLL_SETTLE_MS = 50;      // 스크롤이 이만큼 멈추면 화면 밖 썸네일 요청을 버림
+constexpr int ROW_UPDATE_MAX   = 32;      // 차이가 이보다 많으면(처음 훑기, 폴더 복사) 행 단위 대신 한 번에 다시 읽음
+const QSize THUMB_SIZE(240, 135);
 }
 
 Tab2_video::Tab2_video(const QString& mediaDir, QWidget *parent)
@@ -44,11 +45,50 @@ Tab2_video::Tab2_video(const QString& mediaDir, QWidget *parent)
 
     setupVideoOutput();
 
+    m_model = new GalleryModel(THUMB_SIZE, this);
+    ui->list->setModel(m_model);
+
+    // 빠르게 스크롤하며 지나간 클립의 썸네일까지 만들지 않도록
+    m_scrollTimer = new QTimer(this);
+    m_scrollTimer->setSingleShot(true);
+    m_scrollTimer->setInterval(SCROLL_SETTLE_MS);
+    connect(m_scrollTimer, &QTimer::timeout, m_model, &GalleryModel::dropStaleThumbnails);
+    connect(ui->list->verticalScrollBar(), &QScrollBar::valueChanged,
+            m_scrollTimer, qOverload<>(&QTimer::start));
+
+    // 썸네일 위에서 마우스를 가로로 움직이면 클립 안의 장면을 훑어봄
+    ui->list->setMouseTracking(true);
+    ui->list->viewport()->installEventFilter(this);
+
+    // 새 녹화가 끝나거나 파일이 지워지면 새로고침 없이 그 행만 넣고 뺌 (색인도 함께)
+    m_watcher = new ClipWatcher(this);
+    connect(m_watcher, &ClipWatcher::clipsChanged, this,
+            [this](const QList<ClipInfo>& added, const QList<ClipInfo>& removed) {
+        for (const ClipInfo& clip : removed) {
+            ClipInfo proxy;
+            if (ClipCatalog::findProxy(clip, proxy)) QFile::remove(proxy.path);   // 원본이 지워지면 프록시/움직임 기록도
+            QFile::remove(MotionTrack::pathFor(m_mediaDir, clip.fileName));
+        }
+        const bool indexed = m_index && m_index->isOpen() && m_index->update(added, removed);
+        if (indexed && added.size() + removed.size() > ROW_UPDATE_MAX) {
+            m_model->reload(m_index.get());
+            return;
+        }
+        for (const ClipInfo& clip : removed) m_model->removeClip(clip);
+        for (const ClipInfo& clip : added) m_model->insertClip(clip);
+    });
+
     connect(ui->btnRefresh, &QPushButton::clicked, this, &Tab2_video::refreshGallery);
     connect(ui->btnPlay,    &QPushButton::clicked, this, &Tab2_video::playSelected);
-    connect(ui->list,       &QListWidget::itemDoubleClicked, this, [this](QListWidgetItem*){ playSelected(); });
+    connect(ui->btnSearch,  &QPushButton::clicked, this, &Tab2_video::openMotionSearch);
+    connect(ui->list,       &QListView::doubleClicked, this, [this](const QModelIndex&){ playSelected(); });
     connect(ui->btnBack,    &QPushButton::clicked, this, &Tab2_video::backToGallery);
-    connect(this, &Tab2_video::thumbnailReady, this, &Tab2_video::onThumbnailReady);
+    connect(ui->btnPrevMotion, &QPushButton::clicked, this, [this]() { jumpToMotion(false); });
+    connect(ui->btnNextMotion, &QPushButton::clicked, this, [this]() { jumpToMotion(true); });
+    // 재생 중에 화질을 바꾸면 같은 위치에서 이어서
+    connect(ui->chkFullQuality, &QCheckBox::toggled, this, [this]() {
+        if (ui->stack->currentIndex() == 1 && !m_playingPath.isEmpty()) playCurrent(m_player->position());
+    });
 
     refreshGallery();
     ui->stack->setCurrentIndex(0);
@@ -63,16 +103,29 @@ Tab2_video::Tab2_video(QWidget *parent, const QString& mediaDir)
 Tab2_video::~Tab2_video()
 {
     if (m_player) m_player->stop();
-    if (m_thumbFuture.isRunning()) {
-        m_thumbFuture.cancel();
-        m_thumbFuture.waitForFinished();
-    }
+    ui->list->viewport()->removeEventFilter(this);   // ui를 지운 뒤 들어오는 이벤트 방지
+    delete m_model;         // 색인을 쓰므로 m_index보다 먼저
+    m_model = nullptr;
     delete ui;
 }
 
 void Tab2_video::setupVideoOutput()
 {
     m_player = new QMediaPlayer(this);
+    // 위치는 미디어를 읽은 뒤에야 옮길 수 있음
+    connect(m_player, &QMediaPlayer::mediaStatusChanged, this, [this](QMediaPlayer::MediaStatus status) {
+        if (status == QMediaPlayer::LoadedMedia && m_resumeAt > 0) {
+            m_player->setPosition(m_resumeAt);
+            m_resumeAt = 0;
+        }
+    });
+
+    // 움직임 활동 막대: 재생 위치 표시 + 누르면 이동
+    m_activity = new ActivityBar(ui->playerPage);
+    ui->playerLayout->addWidget(m_activity);
+    connect(m_player, &QMediaPlayer::positionChanged, m_activity, &ActivityBar::setPosition);
+    connect(m_activity, &ActivityBar::seekRequested, m_player, &QMediaPlayer::setPosition);
+
     m_video  = new QVideoWidget(ui->videoHost);
     m_video->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
 
@@ -92,114 +145,126 @@ void Tab2_video::setMediaDirectory(const QString& dir)
 
 void Tab2_video::refreshGallery()
 {
-    if (m_thumbFuture.isRunning()) {
-        m_thumbFuture.cancel();
-        m_thumbFuture.waitForFinished();
-    }
-
-    ui->list->clear();
     ui->title->setText(QStringLiteral("영상 갤러리 — %1").arg(m_mediaDir));
 
-    QDir dir(m_mediaDir);
-    const auto entries = dir.entryInfoList(QDir::Files | QDir::NoDotAndDotDot, QDir::Name | QDir::Reversed);
-
-    QMap<QDate, QList<QFileInfo>> groupedByDate;
-    for (const QFileInfo& fi : entries) {
-        if (!isVideoFile(fi.fileName())) continue;
-        QStringList parts = fi.baseName().split('_');
-        if (parts.size() < 2) continue;
-        QDate date = QDate::fromString(parts.at(1), "yyyyMMdd");
-        if (date.isValid()) {
-            groupedByDate[date].append(fi);
-        }
+    if (!m_index || m_index->directory() != m_mediaDir) {
+        delete m_search;
+        m_index = std::make_unique<ClipIndex>(m_mediaDir);
     }
 
-    QMapIterator<QDate, QList<QFileInfo>> it(groupedByDate);
-    it.toBack();
-
-    while (it.hasPrevious()) {
-        it.previous();
-        const QDate& date = it.key();
-        const QList<QFileInfo>& filesOnDate = it.value();
-
-        auto *headerItem = new QListWidgetItem();
-        headerItem->setText(date.toString("yyyy년 M월 d일 (dddd)"));
-        headerItem->setFlags(headerItem->flags() & ~Qt::ItemIsSelectable);
-        QFont font = headerItem->font();
-        font.setBold(true); font.setPointSize(14);
-        headerItem->setFont(font);
-        headerItem->setBackground(QColor("#f0f0f0"));
-        ui->list->addItem(headerItem);
-
-        for (const QFileInfo& fi : filesOnDate) {
-            auto *item = new QListWidgetItem();
-            item->setText(fi.fileName());
-            item->setToolTip(fi.absoluteFilePath());
-            ui->list->addItem(item);
-        }
+    // 남은 썸네일 작업과 아직 도착하지 않은 결과는 모델이 모두 버림 (기다리지 않음)
+    if (m_index->isOpen()) {
+        // 색인에서 날짜별 개수와 첫 페이지만 읽음 (클립 수와 무관하게 바로 표시)
+        m_model->reload(m_index.get());
+        // 색인과 폴더가 다를 수 있으므로(앱이 꺼져 있을 때 생긴/지운 파일) 감시자를 색인 목록에서 시작해
+        // 한 번 훑게 함 → 차이만 clipsChanged로 색인과 모델에 반영 (많으면 한 트랜잭션 + reload 한 번)
+        QTimer::singleShot(0, this, [this]() {
+            if (!m_index) return;
+            m_watcher->setDirectory(m_mediaDir, m_index->all(m_model->query()));
+            m_watcher->rescanSoon();
+        });
+        return;
     }
 
-    // ✅ 람다 함수로 수정된 부분
-    m_thumbFuture = QtConcurrent::run([this]() {
-        this->loadThumbnailsInBackground();
-    });
+    // 색인을 쓸 수 없으면 예전처럼 폴더를 훑음. 날짜별 묶음 규칙은 스트림 서버의 /api/clips와 공유
+    const QMap<QDate, QList<ClipInfo>> byDate = ClipCatalog::scan(m_mediaDir);
+    m_model->setClips(byDate);
+    QList<ClipInfo> known;
+    for (const QList<ClipInfo>& clips : byDate) known.append(clips);
+    m_watcher->setDirectory(m_mediaDir, known);   // 이후 변경은 감시로 (같은 목록에서 시작)
 }
 
-QIcon Tab2_video::makeThumbFor(const QString& filePath, QSize target)
+bool Tab2_video::eventFilter(QObject *watched, QEvent *event)
 {
-    try {
-        cv::VideoCapture cap(filePath.toStdString());
-        if (!cap.isOpened()) {
-            throw std::runtime_error("VideoCapture open failed.");
+    if (watched == ui->list->viewport()) {
+        if (event->type() == QEvent::MouseMove) {
+            const QPoint pos = static_cast<QMouseEvent*>(event)->position().toPoint();
+            const QModelIndex idx = ui->list->indexAt(pos);
+            const QRect rect = ui->list->visualRect(idx);
+            m_model->scrub(idx, rect.width() > 0 ? double(pos.x() - rect.left()) / rect.width() : 0.0);
+        } else if (event->type() == QEvent::Leave) {
+            m_model->scrub(QModelIndex(), 0.0);
         }
-        cv::Mat frame;
-        for (int i=0; i<10; ++i) cap.read(frame);
-        if (frame.empty()) cap.read(frame);
-        cap.release();
-
-        if (frame.empty()) {
-            throw std::runtime_error("Failed to grab a frame.");
-        }
-
-        cv::Mat rgb;
-        cv::cvtColor(frame, rgb, cv::COLOR_BGR2RGB);
-        QImage qimg(rgb.data, rgb.cols, rgb.rows, (int)rgb.step, QImage::Format_RGB888);
-        QImage scaled = qimg.scaled(target, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-        return QIcon(QPixmap::fromImage(scaled));
-
-    } catch (const std::exception& e) {
-        qWarning() << "[Thumb Error] for" << filePath << ":" << e.what();
-        QPixmap px(target);
-        px.fill(Qt::black);
-        QPainter p(&px);
-        p.setPen(Qt::white);
-        p.drawText(px.rect(), Qt::AlignCenter, "NO PREVIEW");
-        p.end();
-        return QIcon(px);
     }
+    return QWidget::eventFilter(watched, event);
 }
 
 void Tab2_video::playSelected()
 {
-    auto *item = ui->list->currentItem();
-    if (!item || item->toolTip().isEmpty()) return; // 헤더 아이템은 재생 안 함
+    const QString path = ui->list->currentIndex().data(GalleryModel::PathRole).toString();
+    if (path.isEmpty()) return; // 헤더 아이템은 재생 안 함
+    playClip(path, 0);
+}
 
-    const QString path = item->toolTip();
+void Tab2_video::playClip(const QString& path, qint64 positionMs)
+{
     if (!QFileInfo::exists(path)) {
         QMessageBox::warning(this, QStringLiteral("오류"),
                              QStringLiteral("파일을 찾을 수 없습니다:\n%1").arg(path));
         return;
     }
 
-    ui->nowPlaying->setText(path);
-    m_player->stop();
-    m_player->setSource(QUrl::fromLocalFile(path));
-    m_player->play();
+    m_playingPath = path;
+    // 녹화기가 남긴 움직임 기록 (예전 클립에는 없음). 프록시도 프레임 수가 같으므로 같은 시각을 씀
+    MotionTrack track;
+    const QFileInfo fi(path);
+    if (MotionTrack::load(MotionTrack::pathFor(fi.absolutePath(), fi.fileName()), track) && !track.isEmpty()) {
+        m_activity->setTrack(track);
+    } else {
+        m_activity->clear();
+    }
+    ui->btnPrevMotion->setEnabled(m_activity->hasTrack());
+    ui->btnNextMotion->setEnabled(m_activity->hasTrack());
+    playCurrent(positionMs);
 
     ui->stack->setCurrentIndex(1);
     ui->title->setText(QStringLiteral("재생 중"));
 }
 
+void Tab2_video::playCurrent(qint64 position)
+{
+    // 기본은 프록시 (저사양 재생 PC에서도 끊기지 않도록). 없거나 원본 화질을 고르면 원본
+    QString source = m_playingPath;
+    if (!ui->chkFullQuality->isChecked()) {
+        const QFileInfo fi(m_playingPath);
+        ClipInfo clip, proxy;
+        if (ClipCatalog::find(fi.absolutePath(), fi.fileName(), clip) && ClipCatalog::findProxy(clip, proxy)) {
+            source = proxy.path;
+        }
+    }
+
+    ui->nowPlaying->setText(source == m_playingPath ? m_playingPath
+                                                    : QStringLiteral("%1 (미리보기 화질)").arg(m_playingPath));
+    m_player->stop();
+    m_resumeAt = position;
+    m_player->setSource(QUrl::fromLocalFile(source));
+    m_player->play();
+}
+
+void Tab2_video::openMotionSearch()
+{
+    if (!m_index || !m_index->isOpen()) {
+        QMessageBox::information(this, QStringLiteral("움직임 검색"),
+                                 QStringLiteral("클립 색인을 열 수 없어 움직임 검색을 사용할 수 없습니다."));
+        return;
+    }
+    if (!m_search) {
+        // 배경은 가장 최근 클립의 장면 (영역을 고를 때 위치를 알아보도록)
+        const QList<ClipInfo> latest = m_index->page(ClipIndex::Query(), nullptr, 1);
+        m_search = new MotionSearchDialog(m_index.get(), latest.isEmpty() ? QString() : latest.first().path, this);
+        connect(m_search, &MotionSearchDialog::playRequested, this, &Tab2_video::playClip);
+    }
+    m_search->show();
+    centerAndRaise(m_search);
+}
+
+void Tab2_video::jumpToMotion(bool forward)
+{
+    const qint64 pos = m_player->position();
+    const qint64 target = forward ? m_activity->nextMotion(pos) : m_activity->previousMotion(pos);
+    if (target >= 0) m_player->setPosition(target);
+}
+
 void Tab2_video::backToGallery()
 {
     if (m_player) m_player->pause();
@@ -224,23 +289,3 @@ void Tab2_video::centerAndRaise(QWidget *dlg)
     dlg->raise();
     dlg->activateWindow();
 }
-
-void Tab2_video::loadThumbnailsInBackground()
-{
-    for (int i = 0; i < ui->list->count(); ++i) {
-        if (m_thumbFuture.isCanceled()) break;
-
-        QListWidgetItem* item = ui->list->item(i);
-        if (!item || item->toolTip().isEmpty()) continue;
-
-        QIcon icon = makeThumbFor(item->toolTip());
-        emit thumbnailReady(item, icon);
-    }
-}
-
-void Tab2_video::onThumbnailReady(QListWidgetItem* item, const QIcon& icon)
-{
-    if (item) {
-        item->setIcon(icon);
-    }
-}
@@ -3,14 +3,17 @@
 
 #include <QWidget>
 #include <QPointer>
-#include <QIcon>
-#include <QFuture>
-#include <QtConcurrent>
+#include <memory>
 
 
-class QListWidgetItem;
+class ActivityBar;
+class ClipIndex;
+class ClipWatcher;
+class MotionSearchDialog;
+class GalleryModel;
 class QMediaPlayer;
 class QVideoWidget;
+class QTimer;
 
 namespace Ui { class Tab2_video; }
 
@@ -26,16 +29,17 @@ public:
     void setMediaDirectory(const QString& dir);
     QString mediaDirectory() const { return m_mediaDir; }
 
-signals:
-    // [파일안정화] 썸네일 하나가 완성될 때마다 보낼 신호
-    void thumbnailReady(QListWidgetItem* item, const QIcon& icon);
-
 public slots:
     void refreshGallery();
     void playSelected();
+    void playClip(const QString& path, qint64 positionMs);
+    void openMotionSearch();
     void backToGallery();
     void onDetected();               // (선택) 감지 팝업
 
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;   // 갤러리 마우스 스크럽
+
 private:
     // UI
     Ui::Tab2_video *ui = nullptr;
@@ -43,18 +47,23 @@ private:
     // 미디어
     QMediaPlayer  *m_player = nullptr;
     QVideoWidget  *m_video  = nullptr;
+    ActivityBar   *m_activity = nullptr;  // 재생 중인 클립의 움직임 기록 (영상 아래)
     QString        m_mediaDir;
+    QString        m_playingPath;    // 재생 중인 클립 (원본 경로)
+    qint64         m_resumeAt = 0;   // 화질을 바꿀 때 이어 볼 위치 (ms)
+
+    // 갤러리 (행/썸네일은 모델이 필요할 때 만듦)
+    GalleryModel  *m_model = nullptr;
+    ClipWatcher   *m_watcher = nullptr;     // 새/삭제된 클립을 행 단위로 반영
+    std::unique_ptr<ClipIndex> m_index;    // 클립 색인 (GUI 스레드 연결). 열지 못하면 폴더를 직접 훑음
+    QTimer        *m_scrollTimer = nullptr;   // 스크롤이 멈추면 화면 밖 썸네일 요청 정리
+    QPointer<MotionSearchDialog> m_search;  // 색인을 쓰므로 색인을 바꿀 때 함께 닫음
 
     // 내부 유틸
-    QIcon makeThumbFor(const QString& filePath, QSize target = QSize(240, 135));
     void  setupVideoOutput();    // videoHost에 QVideoWidget 주입
+    void  playCurrent(qint64 position);   // m_playingPath를 화질 설정에 맞는 파일로 재생
+    void  jumpToMotion(bool forward);
     void  centerAndRaise(QWidget *dlg);
-    // [파일안정화] 백그라운드에서 썸네일을 로딩할 함수
-    void loadThumbnailsInBackground();
-    QFuture<void> m_thumbFuture; // 스레드 상태 관리를 위해 추가
-private slots:
-    // [파일안정화] 완성된 썸네일을 리스트 위젯에 적용할 슬롯
-    void onThumbnailReady(QListWidgetItem* item, const QIcon& icon);
 };
 
 #endif // TAB2_VIDEO_H
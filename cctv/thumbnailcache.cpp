@@ -0,0 +1,101 @@
+#include "thumbnailcache.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <algorithm>
+
+namespace {
+constexpr int THUMB_JPEG_QUALITY = 85;
+// 썸네일 크기/형식을 바꾸면 올려서 예전 캐시를 무효화
+constexpr char CACHE_VERSION[] = "v1-240x135";
+}
+
+ThumbnailCache::ThumbnailCache(const QString& dir)
+    : m_dir(dir)
+{
+    QDir().mkpath(m_dir);
+}
+
+QString ThumbnailCache::defaultDirectory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/thumbs";
+}
+
+QByteArray ThumbnailCache::key(const QString& path, qint64 size, const QDateTime& modified)
+{
+    QCryptographicHash h(QCryptographicHash::Sha1);
+    h.addData(QByteArrayView(CACHE_VERSION));
+    h.addData(QFileInfo(path).absoluteFilePath().toUtf8());
+    h.addData(QByteArray::number(size));
+    h.addData(QByteArray::number(modified.toMSecsSinceEpoch()));
+    return h.result().toHex();
+}
+
+QString ThumbnailCache::pathFor(const QByteArray& key) const
+{
+    // 한 폴더에 파일이 너무 많아지지 않도록 앞 두 글자로 나눔
+    return m_dir + '/' + QString::fromLatin1(key.left(2)) + '/' + QString::fromLatin1(key) + ".jpg";
+}
+
+bool ThumbnailCache::load(const QByteArray& key, QImage& out) const
+{
+    return out.load(pathFor(key), "JPG");
+}
+
+bool ThumbnailCache::loadJpeg(const QByteArray& key, QByteArray& out) const
+{
+    QFile f(pathFor(key));
+    if (!f.open(QIODevice::ReadOnly)) return false;
+    out = f.readAll();
+    return !out.isEmpty();
+}
+
+bool ThumbnailCache::store(const QByteArray& key, const QImage& image) const
+{
+    const QString path = pathFor(key);
+    QDir().mkpath(QFileInfo(path).path());
+    QSaveFile f(path);
+    if (!f.open(QIODevice::WriteOnly)) return false;
+    if (!image.save(&f, "JPG", THUMB_JPEG_QUALITY)) {
+        f.cancelWriting();
+        return false;
+    }
+    return f.commit();
+}
+
+bool ThumbnailCache::storeJpeg(const QByteArray& key, const QByteArray& jpeg) const
+{
+    const QString path = pathFor(key);
+    QDir().mkpath(QFileInfo(path).path());
+    QSaveFile f(path);
+    if (!f.open(QIODevice::WriteOnly)) return false;
+    f.write(jpeg);
+    return f.commit();
+}
+
+void ThumbnailCache::trim(qint64 maxBytes) const
+{
+    QFileInfoList files;
+    qint64 total = 0;
+    const QFileInfoList subdirs = QDir(m_dir).entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QFileInfo& d : subdirs) {
+        const QFileInfoList entries = QDir(d.absoluteFilePath()).entryInfoList({"*.jpg"}, QDir::Files);
+        for (const QFileInfo& fi : entries) {
+            total += fi.size();
+            files << fi;
+        }
+    }
+    if (total <= maxBytes) return;
+
+    std::sort(files.begin(), files.end(), [](const QFileInfo& a, const QFileInfo& b) {
+        return a.lastRead() < b.lastRead();
+    });
+    for (const QFileInfo& fi : files) {
+        if (total <= maxBytes) break;
+        if (QFile::remove(fi.absoluteFilePath())) total -= fi.size();
+    }
+}
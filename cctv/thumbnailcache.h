@@ -0,0 +1,43 @@
+#ifndef THUMBNAILCACHE_H
+#define THUMBNAILCACHE_H
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QImage>
+#include <QString>
+
+// 디스크 썸네일 캐시 (작은 JPEG 파일들).
+// 키는 경로 + 크기 + 수정 시각의 해시라서 파일이 바뀌면 자동으로 새 썸네일을 만들고,
+// 갤러리(Tab2)와 스트림 서버(/clips/.../thumb.jpg)가 같은 캐시를 공유합니다.
+// 상태가 없고 쓰기는 QSaveFile로 원자적이므로 여러 스레드에서 동시에 사용해도 됩니다.
+// 녹화기는 클립을 마칠 때 썸네일과 스크럽 스프라이트를 미리 넣어 두므로 갤러리가 새 클립을 디코딩하지 않습니다.
+class ThumbnailCache
+{
+public:
+    // 스크럽 스프라이트: 일정 간격의 장면을 이 크기로 줄여 가로로 이어 붙인 한 장 (타일 수 = 너비 / 타일 너비)
+    static constexpr int SPRITE_TILE_WIDTH  = 160;
+    static constexpr int SPRITE_TILE_HEIGHT = 90;
+
+    explicit ThumbnailCache(const QString& dir = defaultDirectory());
+
+    // <CacheLocation>/thumbs
+    static QString defaultDirectory();
+    static QByteArray key(const QString& path, qint64 size, const QDateTime& modified);
+    // 같은 클립의 스프라이트 키
+    static QByteArray spriteKey(const QByteArray& thumbKey) { return thumbKey + "-sprite"; }
+
+    bool load(const QByteArray& key, QImage& out) const;
+    bool loadJpeg(const QByteArray& key, QByteArray& out) const;
+    bool store(const QByteArray& key, const QImage& image) const;
+    bool storeJpeg(const QByteArray& key, const QByteArray& jpeg) const;
+
+    // 캐시 폴더가 maxBytes를 넘으면 오래 쓰지 않은 파일부터 지움
+    void trim(qint64 maxBytes) const;
+
+private:
+    QString pathFor(const QByteArray& key) const;
+
+    QString m_dir;
+};
+
+#endif // THUMBNAILCACHE_H
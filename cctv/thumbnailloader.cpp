@@ -0,0 +1,152 @@
+#include "thumbnailloader.h"
+#include "clipcatalog.h"
+
+#include <QDebug>
+#include <QThread>
+#include <stdexcept>
+#include <opencv2/imgproc.hpp>
+
+namespace {
+constexpr qint64 THUMB_CACHE_MAX_BYTES = 256LL * 1024 * 1024;   // [썸네일 캐시] 디스크 사용 상한
+}
+
+ThumbnailLoader::ThumbnailLoader(QSize thumbSize, QObject *parent)
+    : QObject(parent)
+    , m_thumbSize(thumbSize)
+{
+    // 디코딩은 클립당 단일 스레드이므로 코어 수만큼 동시에
+    m_pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount()));
+}
+
+ThumbnailLoader::~ThumbnailLoader()
+{
+    cancel();
+    m_pool.waitForDone();   // 워커가 m_mutex/m_cache를 쓰므로 멤버가 지워지기 전에 기다림
+}
+
+void ThumbnailLoader::enqueue(const QList<Request>& requests)
+{
+    if (requests.isEmpty()) return;
+    {
+        QMutexLocker lock(&m_mutex);
+        m_lookups = requests + m_lookups;
+    }
+    startWorkers();
+}
+
+void ThumbnailLoader::discardPending(const QSet<int>& ids)
+{
+    auto drop = [&ids](const Request& r) { return ids.contains(r.id); };
+    QMutexLocker lock(&m_mutex);
+    m_lookups.removeIf(drop);
+    m_decodes.removeIf(drop);
+}
+
+void ThumbnailLoader::cancel()
+{
+    QMutexLocker lock(&m_mutex);
+    ++m_generation;
+    m_lookups.clear();
+    m_decodes.clear();
+}
+
+void ThumbnailLoader::startWorkers()
+{
+    QMutexLocker lock(&m_mutex);
+    const int want = qMin<qsizetype>(m_pool.maxThreadCount(), m_lookups.size() + m_decodes.size());
+    for (; m_running < want; ++m_running) {
+        m_pool.start([this]() { work(); });
+    }
+}
+
+// 워커: 대기열이 빌 때까지 하나씩 처리
+void ThumbnailLoader::work()
+{
+    Request req;
+    bool decode = false;
+    quint64 generation = 0;
+    while (takeNext(req, decode, generation)) {
+        if (!decode) {
+            QImage img;
+            if (m_cache.load(req.key, img)) {
+                deliver(generation, req.id, img);
+            } else {
+                QMutexLocker lock(&m_mutex);
+                if (generation == m_generation) m_decodes.append(req);   // 캐시 확인이 모두 끝난 뒤 디코딩
+            }
+            continue;
+        }
+
+        const QImage img = decodeThumbnail(req.path);
+        if (!img.isNull()) {   // 실패는 녹화 중인 파일일 수 있으므로 캐시하지 않음
+            m_cache.store(req.key, img);
+            QMutexLocker lock(&m_mutex);
+            m_stored = true;
+        }
+        deliver(generation, req.id, img);
+    }
+
+    // 마지막 워커가 끝날 때 한 번만 캐시 정리
+    bool trim = false;
+    {
+        QMutexLocker lock(&m_mutex);
+        if (m_running == 0 && m_stored) {
+            m_stored = false;
+            trim = true;
+        }
+    }
+    if (trim) m_cache.trim(THUMB_CACHE_MAX_BYTES);
+}
+
+bool ThumbnailLoader::takeNext(Request& out, bool& decode, quint64& generation)
+{
+    QMutexLocker lock(&m_mutex);
+    if (!m_lookups.isEmpty()) {
+        out = m_lookups.takeFirst();
+        decode = false;
+    } else if (!m_decodes.isEmpty()) {
+        out = m_decodes.takeFirst();
+        decode = true;
+    } else {
+        --m_running;
+        return false;
+    }
+    generation = m_generation;
+    return true;
+}
+
+QImage ThumbnailLoader::decodeThumbnail(const QString& path) const
+{
+    try {
+        cv::Mat frame;
+        if (!ClipCatalog::thumbnailFrame(path, cv::Size(m_thumbSize.width(), m_thumbSize.height()), frame)) {
+            throw std::runtime_error("Failed to grab a frame.");
+        }
+
+        cv::Mat rgb;
+        cv::cvtColor(frame, rgb, cv::COLOR_BGR2RGB);
+        QImage qimg(rgb.data, rgb.cols, rgb.rows, (int)rgb.step, QImage::Format_RGB888);
+        return qimg.copy();
+
+    } catch (const std::exception& e) {
+        qWarning() << "[Thumb Error] for" << path << ":" << e.what();
+        return QImage();
+    }
+}
+
+void ThumbnailLoader::deliver(quint64 generation, int id, const QImage& image)
+{
+    {
+        QMutexLocker lock(&m_mutex);
+        if (generation != m_generation) return;   // 이미 취소된 세대
+    }
+    // 큐에 쌓여 있는 동안 다시 취소될 수 있으므로 GUI 스레드에서 한 번 더 확인
+    QMetaObject::invokeMethod(this, [this, generation, id, image]() {
+        bool current;
+        {
+            QMutexLocker lock(&m_mutex);
+            current = generation == m_generation;
+        }
+        if (current) emit thumbnailReady(id, image);
+    }, Qt::QueuedConnection);
+}
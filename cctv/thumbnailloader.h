@@ -0,0 +1,62 @@
+#ifndef THUMBNAILLOADER_H
+#define THUMBNAILLOADER_H
+
+#include <QObject>
+#include <QImage>
+#include <QList>
+#include <QMutex>
+#include <QSet>
+#include <QSize>
+#include <QThreadPool>
+#include "thumbnailcache.h"
+
+// 갤러리 썸네일 작업 시스템.
+// 클립 하나가 작업 하나이고, 코어 수만큼의 전용 스레드 풀이 대기열 앞에서부터 가져갑니다.
+//  - 디스크 캐시 확인(가벼움)을 대기 중인 모든 클립에 먼저 하고, 캐시에 없는 클립만 나중에 디코딩
+//  - enqueue()는 새 요청을 기존 대기열 앞에 넣음 (방금 화면에 보인 클립이 먼저)
+//  - discardPending()으로 화면에서 벗어난 클립의 대기 작업을 버림
+//  - cancel()은 세대 번호를 올려 남은 작업을 버리고, 이미 돌고 있는 작업의 결과도 버림
+// 결과(QImage)는 이 객체의 스레드(GUI)에서 thumbnailReady로 전달됩니다. QPixmap/QIcon은 받는 쪽에서 만듦.
+class ThumbnailLoader : public QObject
+{
+    Q_OBJECT
+public:
+    struct Request {
+        int        id = -1;      // 호출자가 정한 번호 (결과에 그대로 돌아옴)
+        QString    path;
+        QByteArray key;          // ThumbnailCache 키
+    };
+
+    explicit ThumbnailLoader(QSize thumbSize, QObject *parent = nullptr);
+    ~ThumbnailLoader();
+
+    // requests를 (그 순서대로) 대기 중인 작업보다 먼저 처리
+    void enqueue(const QList<Request>& requests);
+    // 아직 시작하지 않은 작업 중 ids를 버림 (결과가 오지 않음)
+    void discardPending(const QSet<int>& ids);
+    void cancel();
+
+signals:
+    // image가 null이면 썸네일을 만들지 못한 것 (녹화 중이거나 손상된 파일)
+    void thumbnailReady(int id, const QImage& image);
+
+private:
+    void startWorkers();
+    void work();
+    bool takeNext(Request& out, bool& decode, quint64& generation);
+    QImage decodeThumbnail(const QString& path) const;
+    void deliver(quint64 generation, int id, const QImage& image);
+
+    const QSize    m_thumbSize;
+    ThumbnailCache m_cache;                 // [썸네일 캐시] 디스크 캐시 (스트림 서버와 공유)
+    QThreadPool    m_pool;
+
+    mutable QMutex m_mutex;                 // 아래 대기열/상태 보호
+    QList<Request> m_lookups;               // 캐시 확인 대기
+    QList<Request> m_decodes;               // 캐시에 없어 디코딩 대기
+    quint64        m_generation = 0;
+    int            m_running = 0;           // 돌고 있는 워커 수
+    bool           m_stored = false;        // 이번 세대에 캐시에 새로 쓴 것이 있음 (끝나면 trim)
+};
+
+#endif // THUMBNAILLOADER_H
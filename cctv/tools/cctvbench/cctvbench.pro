@@ -0,0 +1,28 @@
+# 감지 파이프라인 전체 벤치마크: UI/카메라 없이 영상 파일이나 합성 영상을 최대 속도로 처리하고 결과를 JSON으로
+QT       += core gui
+
+CONFIG += c++17 console link_pkgconfig
+CONFIG -= app_bundle
+
+TARGET = cctvbench
+PKGCONFIG += opencv4
+
+packagesExist(libturbojpeg) {
+    PKGCONFIG += libturbojpeg
+    DEFINES += CCTV_HAVE_TURBOJPEG
+}
+
+CCTV_SRC = $$PWD/../..
+INCLUDEPATH += $$CCTV_SRC
+
+SOURCES += \
+    main.cpp \
+    $$CCTV_SRC/jpegencoder.cpp \
+    $$CCTV_SRC/motionpipeline.cpp \
+    $$CCTV_SRC/pipelinestats.cpp
+
+HEADERS += \
+    $$CCTV_SRC/jpegencoder.h \
+    $$CCTV_SRC/motionpipeline.h \
+    $$CCTV_SRC/pipelinestats.h \
+    $$CCTV_SRC/tools/common/syntheticframe.h
@@ -0,0 +1,398 @@
+// 감지 파이프라인 전체 벤치마크 (UI, 카메라 없이)
+//
+//   ./cctvbench                                  합성 1280x720 영상, 측정 600프레임
+//   ./cctvbench -s 1920x1080 -n 900              합성 영상 크기/측정 프레임 수
+//   ./cctvbench clip.mp4                         녹화 영상 (끝까지, 또는 -n 프레임)
+//   ./cctvbench --clahe on --no-record clip.mp4 -o result.json
+//
+// 캡처(디코딩 또는 합성) → 밝기 측정/CLAHE → MOG2 → 마스크 → 윤곽선 → 녹화(H.264 파일) → QImage 변환 → 스트림 JPEG 인코딩을
+// 한 스레드에서 차례로 최대 속도로 돌리고, fps와 단계별 지연, 최대 RSS, 프레임당 할당 수를 JSON으로 출력합니다.
+// 앱에서는 프록시 녹화와 스트림 인코딩이 다른 스레드에서 돌지만 여기서는 모두 직렬이라 fps = 한 프레임을 끝까지 처리하는 처리량.
+// 측정은 감지 워밍업(MOG2 학습, 무시 마스크 확정)이 끝난 다음 프레임부터라 할당 수는 정상 상태의 값입니다.
+// 할당 수는 C++ new와 cv::Mat 버퍼만 셉니다 (FFmpeg/TurboJPEG 내부의 malloc은 빠짐).
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QImage>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSysInfo>
+#include <QTemporaryDir>
+#include <QThread>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <new>
+#include <opencv2/opencv.hpp>
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#endif
+
+#include "jpegencoder.h"
+#include "motionpipeline.h"
+#include "pipelinestats.h"
+#include "tools/common/syntheticframe.h"
+
+// ---- 할당 계수 (전역 operator new 교체: 이 프로세스의 Qt/OpenCV 코드까지 모두 셈) ----
+namespace {
+std::atomic<quint64> g_heapAllocs{0};
+std::atomic<quint64> g_heapBytes{0};
+}
+
+void* operator new(std::size_t size)
+{
+    g_heapAllocs.fetch_add(1, std::memory_order_relaxed);
+    g_heapBytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+
+constexpr double FALLBACK_FPS    = 30.0;   // 컨테이너에 fps가 없을 때
+constexpr int    DEFAULT_FRAMES  = 600;
+constexpr double MOVER_PERIOD_S  = 10.0;   // 합성 영상: 이 주기마다
+constexpr double MOVER_START_S   = 4.0;    //   이 시각부터
+constexpr double MOVER_LENGTH_S  = 4.0;    //   이만큼 물체가 화면을 가로지름
+
+// cv::Mat 버퍼 할당 계수. 할당은 OpenCV 기본 할당자에 맡기므로(해제도 그쪽으로 감) 동작은 그대로
+class CountingMatAllocator : public cv::MatAllocator
+{
+public:
+    explicit CountingMatAllocator(cv::MatAllocator* base) : m_base(base) {}
+
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                           cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const override
+    {
+        cv::UMatData* u = m_base->allocate(dims, sizes, type, data, step, flags, usageFlags);
+        if (u && !data) {
+            allocs.fetch_add(1, std::memory_order_relaxed);
+            bytes.fetch_add(u->size, std::memory_order_relaxed);
+        }
+        return u;
+    }
+    bool allocate(cv::UMatData* u, cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const override
+    {
+        return m_base->allocate(u, flags, usageFlags);
+    }
+    void deallocate(cv::UMatData* u) const override { m_base->deallocate(u); }
+
+    mutable std::atomic<quint64> allocs{0};
+    mutable std::atomic<quint64> bytes{0};
+
+private:
+    cv::MatAllocator* m_base;
+};
+
+// 영상 파일 또는 합성 영상 (정지한 배경 + 주기적으로 지나가는 물체 → 감지/윤곽선/녹화 경로가 모두 돎)
+class FrameSource
+{
+public:
+    bool openFile(const QString& path)
+    {
+        if (!m_cap.open(path.toStdString())) return false;
+        m_fps = m_cap.get(cv::CAP_PROP_FPS);
+        if (m_fps < 1.0) m_fps = FALLBACK_FPS;
+        m_size = cv::Size(int(m_cap.get(cv::CAP_PROP_FRAME_WIDTH)), int(m_cap.get(cv::CAP_PROP_FRAME_HEIGHT)));
+        return true;
+    }
+
+    void openSynthetic(cv::Size size, double fps)
+    {
+        m_size = size;
+        m_fps = fps;
+        m_background = Synthetic::frame(size);
+    }
+
+    bool synthetic() const { return !m_background.empty(); }
+    double fps() const { return m_fps; }
+    cv::Size size() const { return m_size; }
+
+    // 카메라처럼 frame 버퍼를 매번 재사용
+    bool read(cv::Mat& frame)
+    {
+        if (!synthetic()) return m_cap.read(frame);
+        m_background.copyTo(frame);
+        const double t = std::fmod(m_index++ / m_fps, MOVER_PERIOD_S) - MOVER_START_S;
+        if (t >= 0.0 && t < MOVER_LENGTH_S) {
+            const int h = m_size.height / 5, w = h / 2;
+            const int x = int(t / MOVER_LENGTH_S * (m_size.width + w)) - w;
+            cv::rectangle(frame, cv::Rect(x, m_size.height / 2 - h / 2, w, h), Synthetic::MOVER_COLOR, cv::FILLED);
+        }
+        return true;
+    }
+
+private:
+    cv::VideoCapture m_cap;
+    cv::Mat          m_background;
+    cv::Size         m_size;
+    double           m_fps = FALLBACK_FPS;
+    qint64           m_index = 0;
+};
+
+QJsonObject summaryJson(const LatencyHistogram::Snapshot& s)
+{
+    const LatencyHistogram::Summary sum = LatencyHistogram::summarize(s);
+    return {
+        { "frames", double(sum.count) },
+        { "mean_ms", sum.meanUs / 1000.0 },
+        { "p50_ms", sum.p50Us / 1000.0 },
+        { "p99_ms", sum.p99Us / 1000.0 },
+        { "max_ms", sum.maxUs / 1000.0 },
+        { "total_s", s.sumNs / 1e9 },
+    };
+}
+
+// 최대 RSS (KiB). 구할 수 없으면 -1
+qint64 peakRssKiB()
+{
+#ifdef Q_OS_UNIX
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return -1;
+#ifdef Q_OS_DARWIN
+    return usage.ru_maxrss / 1024;   // macOS는 바이트
+#else
+    return usage.ru_maxrss;
+#endif
+#else
+    return -1;
+#endif
+}
+
+QJsonObject allocJson(quint64 count, quint64 bytes, qint64 frames)
+{
+    return {
+        { "count", double(count) },
+        { "bytes", double(bytes) },
+        { "per_frame", frames > 0 ? double(count) / frames : 0.0 },
+        { "bytes_per_frame", frames > 0 ? double(bytes) / frames : 0.0 },
+    };
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Run the full motion detection pipeline headless at maximum speed and report JSON");
+    parser.addHelpOption();
+    parser.addOption({{"n", "frames"}, "Measured frames after warm-up (default 600 synthetic, whole file otherwise).", "n"});
+    parser.addOption({{"s", "size"}, "Synthetic frame size WxH (default 1280x720).", "WxH", "1280x720"});
+    parser.addOption({"fps", "Synthetic frame rate (default 30).", "fps", QString::number(FALLBACK_FPS)});
+    parser.addOption({"clahe", "off | on | auto (default auto, as the app).", "mode", "auto"});
+    parser.addOption({"no-record", "Skip writing the H.264 clip."});
+    parser.addOption({"no-encode", "Skip the QImage conversion and stream JPEG encode."});
+    parser.addOption({{"t", "threads"}, "OpenCV worker threads (default: OpenCV's choice).", "n"});
+    parser.addOption({{"o", "output"}, "Write the JSON report to a file instead of stdout.", "file"});
+    parser.addPositionalArgument("source", "Optional video file (default: synthetic).", "[source]");
+    parser.process(app);
+
+    if (parser.isSet("threads")) cv::setNumThreads(qMax(1, parser.value("threads").toInt()));
+
+    MotionParams params;
+    const QString clahe = parser.value("clahe");
+    if (clahe == "on") params.useClahe = true;
+    else if (clahe == "auto") params.autoClahe = true;
+    else if (clahe != "off") {
+        qCritical("Unknown --clahe mode: %s", qPrintable(clahe));
+        return 1;
+    }
+    // 앱(Tab1_camera)의 자동 CLAHE 설정과 같게
+    params.darknessThreshold = 80;
+    params.claheMaxClip = 8.0;
+
+    FrameSource source;
+    const QString path = parser.positionalArguments().value(0);
+    if (!path.isEmpty()) {
+        if (!source.openFile(path)) {
+            qCritical("Cannot open %s", qPrintable(path));
+            return 1;
+        }
+    } else {
+        const QStringList wh = parser.value("size").split('x');
+        const int w = wh.value(0).toInt(), h = wh.value(1).toInt();
+        const double fps = parser.value("fps").toDouble();
+        source.openSynthetic(cv::Size(w > 0 ? w : 1280, h > 0 ? h : 720), fps >= 1.0 ? fps : FALLBACK_FPS);
+    }
+    const qint64 maxFrames = parser.isSet("frames") ? qMax(1, parser.value("frames").toInt())
+                             : source.synthetic() ? DEFAULT_FRAMES : -1;
+
+    // 녹화: 감지기와 같은 코덱/컨테이너로 임시 폴더에 씀
+    const bool record = !parser.isSet("no-record");
+    const bool encode = !parser.isSet("no-encode");
+    QTemporaryDir tempDir;
+    cv::VideoWriter writer;
+    QString recordCodec;
+    if (record) {
+        const std::string clipPath = (tempDir.path() + "/bench.mp4").toStdString();
+        if (writer.open(clipPath, cv::VideoWriter::fourcc('a','v','c','1'), source.fps(), source.size(), true)) {
+            recordCodec = "avc1";
+        } else if (writer.open(clipPath, cv::VideoWriter::fourcc('m','p','4','v'), source.fps(), source.size(), true)) {
+            recordCodec = "mp4v";   // H.264 인코더가 없는 OpenCV 빌드
+        } else {
+            qCritical("VideoWriter open failed (no usable encoder)");
+            return 1;
+        }
+    }
+    // 스트림 서버의 원본(full) 화질과 같은 설정
+    const JpegEncoder::Options jpegOptions{ 70, JpegEncoder::Subsampling::S420, true };
+    JpegEncoder jpeg;
+
+    CountingMatAllocator matAllocator(cv::Mat::getStdAllocator());
+    cv::Mat::setDefaultAllocator(&matAllocator);
+
+    MotionPipeline pipeline(params, 0);
+    MotionPipeline::Result result;
+    PipelineStats stats;
+    LatencyHistogram frameLatency;
+    cv::Mat frame;
+    QByteArray jpegBytes;
+
+    qint64 index = 0, warmupFrames = 0, measured = 0, detectedFrames = 0, claheFrames = 0;
+    quint64 heapAllocs0 = 0, heapBytes0 = 0, matAllocs0 = 0, matBytes0 = 0;
+    QElapsedTimer wall;
+    while (maxFrames < 0 || measured < maxFrames) {
+        // 워밍업이 끝난 뒤 첫 프레임부터 측정 (MOG2/인코더 초기화 같은 1회성 비용 제외)
+        const bool measuring = pipeline.isArmed();
+        if (measuring && measured == 0) {
+            warmupFrames = index;
+            heapAllocs0 = g_heapAllocs.load();
+            heapBytes0 = g_heapBytes.load();
+            matAllocs0 = matAllocator.allocs.load();
+            matBytes0 = matAllocator.bytes.load();
+            wall.start();
+        }
+
+        const qint64 start = PipelineStats::nowNs();
+        if (!source.read(frame)) break;
+        qint64 mark = PipelineStats::nowNs();
+        const qint64 captureNs = mark - start;
+
+        pipeline.process(frame, qint64(index * 1000.0 / source.fps()), params, true, result);
+        ++index;
+
+        qint64 recordNs = 0, imageNs = 0, encodeNs = 0;
+        if (record) {
+            mark = PipelineStats::nowNs();
+            writer.write(result.processed);
+            recordNs = PipelineStats::nowNs() - mark;
+        }
+        if (encode) {
+            // MotionDetector::matToQImage와 같은 변환
+            mark = PipelineStats::nowNs();
+            cv::Mat rgb;
+            cv::cvtColor(result.processed, rgb, cv::COLOR_BGR2RGB);
+            const QImage image = QImage(rgb.data, rgb.cols, rgb.rows, int(rgb.step), QImage::Format_RGB888).copy();
+            imageNs = PipelineStats::nowNs() - mark;
+
+            mark = PipelineStats::nowNs();
+            jpeg.encode(result.processed, jpegOptions, jpegBytes);
+            encodeNs = PipelineStats::nowNs() - mark;
+        }
+        const qint64 frameNs = PipelineStats::nowNs() - start;
+        if (!measuring) continue;
+
+        ++measured;
+        const MotionPipeline::StageTimes& times = result.times;
+        stats.record(PipelineStats::Capture, captureNs);
+        if (times.brightness > 0) stats.record(PipelineStats::Brightness, times.brightness);
+        if (times.clahe > 0) stats.record(PipelineStats::Clahe, times.clahe);
+        stats.record(PipelineStats::Mog2, times.mog2);
+        stats.record(PipelineStats::Mask, times.mask);
+        if (times.contours > 0) stats.record(PipelineStats::Contours, times.contours);
+        if (record) stats.record(PipelineStats::Record, recordNs);
+        if (encode) {
+            stats.record(PipelineStats::ToImage, imageNs);
+            stats.record(PipelineStats::StreamEncode, encodeNs);
+        }
+        frameLatency.record(frameNs);
+        if (result.detected) ++detectedFrames;
+        if (result.claheApplied) ++claheFrames;
+    }
+    const double wallS = measured > 0 ? wall.nsecsElapsed() / 1e9 : 0.0;
+    const quint64 heapAllocs = g_heapAllocs.load() - heapAllocs0, heapBytes = g_heapBytes.load() - heapBytes0;
+    const quint64 matAllocs = matAllocator.allocs.load() - matAllocs0, matBytes = matAllocator.bytes.load() - matBytes0;
+    writer.release();
+    cv::Mat::setDefaultAllocator(nullptr);
+
+    if (measured == 0) {
+        qCritical("No frames measured (source ended after %lld frames, before the %d ms warm-up finished)",
+                  index, params.warmupMs);
+        return 1;
+    }
+
+    const PipelineStats::Snapshot snap = stats.snapshot();
+    QJsonObject stages;
+    for (int i = 0; i < PipelineStats::STAGE_COUNT; ++i) {
+        if (snap.stages[i].count == 0) continue;   // 실행하지 않은 단계 (CLAHE 꺼짐 등)
+        QJsonObject stage = summaryJson(snap.stages[i]);
+        stage["share"] = snap.stages[i].sumNs / 1e9 / wallS;
+        stages[PipelineStats::stageName(PipelineStats::Stage(i))] = stage;
+    }
+
+    const QJsonObject report {
+        { "tool", "cctvbench" },
+        { "opencv", CV_VERSION },
+        { "host", QJsonObject {
+              { "cpu_arch", QSysInfo::currentCpuArchitecture() },
+              { "os", QSysInfo::prettyProductName() },
+              { "logical_cpus", QThread::idealThreadCount() },
+              { "cv_threads", cv::getNumThreads() },
+#ifdef CCTV_HAVE_TURBOJPEG
+              { "jpeg", "turbojpeg" },
+#else
+              { "jpeg", "imencode" },
+#endif
+          } },
+        { "source", QJsonObject {
+              { "kind", source.synthetic() ? "synthetic" : "file" },
+              { "path", path },
+              { "width", source.size().width },
+              { "height", source.size().height },
+              { "fps", source.fps() },
+          } },
+        { "config", QJsonObject {
+              { "clahe", clahe },
+              { "record", record ? recordCodec : QString("off") },
+              { "encode", encode },
+              { "jpeg_quality", jpegOptions.quality },
+          } },
+        { "warmup_frames", double(warmupFrames) },
+        { "frames", double(measured) },
+        { "wall_s", wallS },
+        { "fps", measured / wallS },
+        { "realtime_factor", measured / wallS / source.fps() },
+        { "frame", summaryJson(frameLatency.snapshot()) },
+        { "stages", stages },
+        { "motion", QJsonObject {
+              { "detected_frames", double(detectedFrames) },
+              { "clahe_frames", double(claheFrames) },
+          } },
+        { "memory", QJsonObject { { "peak_rss_kib", double(peakRssKiB()) } } },
+        { "allocations", QJsonObject {
+              { "heap", allocJson(heapAllocs, heapBytes, measured) },
+              { "mat", allocJson(matAllocs, matBytes, measured) },
+          } },
+    };
+
+    const QByteArray json = QJsonDocument(report).toJson(QJsonDocument::Indented);
+    if (parser.isSet("output")) {
+        QFile f(parser.value("output"));
+        if (!f.open(QIODevice::WriteOnly) || f.write(json) != json.size()) {
+            qCritical("Cannot write %s", qPrintable(parser.value("output")));
+            return 1;
+        }
+    } else {
+        QFile out;
+        out.open(stdout, QIODevice::WriteOnly);
+        out.write(json);
+    }
+    return 0;
+}
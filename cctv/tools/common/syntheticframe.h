@@ -0,0 +1,47 @@
+#ifndef SYNTHETICFRAME_H
+#define SYNTHETICFRAME_H
+
+#include <cstdint>
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+// 벤치마크 도구(jpegbench, cctvbench, kernelbench)가 함께 쓰는 고정 시드의 합성 장면.
+// 완전한 노이즈/단색은 JPEG/MOG2 특성이 실제 영상과 너무 달라서 그라디언트 + 도형 + 약한 노이즈로 구성하고,
+// 시드가 고정이라 어느 장비에서나 같은 픽셀이 나옵니다.
+namespace Synthetic {
+
+constexpr int           SHAPES      = 40;
+constexpr std::uint64_t SHAPE_SEED  = 12345;
+constexpr std::uint64_t NOISE_SEED  = 777;
+constexpr double        NOISE_SIGMA = 6.0;
+const cv::Scalar        MOVER_COLOR(30, 30, 200);   // 움직이는 물체 (빨간 사각형)
+
+// mover가 비어 있지 않으면 노이즈를 넣기 전에 그 자리에 움직이는 물체를 그림
+inline cv::Mat frame(cv::Size size, const cv::Rect& mover = cv::Rect())
+{
+    cv::Mat bgr(size, CV_8UC3);
+    for (int y = 0; y < size.height; ++y) {
+        auto* row = bgr.ptr<cv::Vec3b>(y);
+        for (int x = 0; x < size.width; ++x) {
+            row[x] = cv::Vec3b(uchar(x * 255 / size.width), uchar(y * 255 / size.height), uchar(128));
+        }
+    }
+    cv::RNG rng(SHAPE_SEED);
+    for (int i = 0; i < SHAPES; ++i) {
+        cv::Point p1(rng.uniform(0, size.width), rng.uniform(0, size.height));
+        cv::Point p2(rng.uniform(0, size.width), rng.uniform(0, size.height));
+        cv::rectangle(bgr, p1, p2, cv::Scalar(rng.uniform(0, 255), rng.uniform(0, 255), rng.uniform(0, 255)), cv::FILLED);
+    }
+    if (!mover.empty()) cv::rectangle(bgr, mover, MOVER_COLOR, cv::FILLED);
+
+    // 전역 theRNG를 건드리지 않도록 노이즈도 자체 시드로
+    cv::Mat noise(size, CV_8UC3);
+    cv::RNG noiseRng(NOISE_SEED);
+    noiseRng.fill(noise, cv::RNG::NORMAL, cv::Scalar::all(0), cv::Scalar::all(NOISE_SIGMA));
+    cv::add(bgr, noise, bgr);
+    return bgr;
+}
+
+} // namespace Synthetic
+
+#endif // SYNTHETICFRAME_H
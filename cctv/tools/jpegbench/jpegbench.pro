@@ -0,0 +1,25 @@
+# 스트리밍 JPEG 인코딩 경로 마이크로 벤치마크
+#   QImage::save(QBuffer) (기존 경로)  vs  JpegEncoder (TurboJPEG, BGR 직접 입력)
+QT       += core gui
+
+CONFIG += c++17 console link_pkgconfig
+CONFIG -= app_bundle
+
+TARGET = jpegbench
+PKGCONFIG += opencv4
+
+packagesExist(libturbojpeg) {
+    PKGCONFIG += libturbojpeg
+    DEFINES += CCTV_HAVE_TURBOJPEG
+}
+
+CCTV_SRC = $$PWD/../..
+INCLUDEPATH += $$CCTV_SRC
+
+SOURCES += \
+    main.cpp \
+    $$CCTV_SRC/jpegencoder.cpp
+
+HEADERS += \
+    $$CCTV_SRC/jpegencoder.h \
+    $$CCTV_SRC/tools/common/syntheticframe.h
@@ -0,0 +1,148 @@
+// 스트리밍 JPEG 인코딩 마이크로 벤치마크
+//
+//   ./jpegbench                      합성 1280x720 프레임
+//   ./jpegbench -s 1920x1080 -n 300  해상도/반복 횟수 지정
+//   ./jpegbench sample.mp4           실제 영상의 첫 프레임 사용 (이미지 파일도 가능)
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QBuffer>
+#include <QImage>
+#include <QTextStream>
+#include <functional>
+#include <opencv2/opencv.hpp>
+
+#include "jpegencoder.h"
+#include "tools/common/syntheticframe.h"
+
+namespace {
+
+cv::Mat loadFrame(const QString& path)
+{
+    cv::Mat frame = cv::imread(path.toStdString(), cv::IMREAD_COLOR);
+    if (!frame.empty()) return frame;
+    cv::VideoCapture cap(path.toStdString());
+    if (cap.isOpened()) cap.read(frame);
+    return frame;
+}
+
+struct Result { double msPerFrame; double avgBytes; };
+
+Result run(int iterations, const std::function<qsizetype()>& body)
+{
+    // 워밍업 (플러그인 로드, 버퍼 할당 등 1회성 비용 제외)
+    for (int i = 0; i < 5; ++i) body();
+
+    qint64 totalBytes = 0;
+    QElapsedTimer t;
+    t.start();
+    for (int i = 0; i < iterations; ++i) totalBytes += body();
+    const double ms = t.nsecsElapsed() / 1e6;
+    return { ms / iterations, double(totalBytes) / iterations };
+}
+
+const char* sampName(JpegEncoder::Subsampling s)
+{
+    switch (s) {
+    case JpegEncoder::Subsampling::S444: return "4:4:4";
+    case JpegEncoder::Subsampling::S422: return "4:2:2";
+    case JpegEncoder::Subsampling::S420: return "4:2:0";
+    case JpegEncoder::Subsampling::Gray: return "gray";
+    }
+    return "?";
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Streaming JPEG encode micro-benchmark");
+    parser.addHelpOption();
+    parser.addOption({{"n", "iterations"}, "Frames per case (default 200).", "n", "200"});
+    parser.addOption({{"s", "size"}, "Synthetic frame size WxH (default 1280x720).", "WxH", "1280x720"});
+    parser.addOption({{"q", "quality"}, "JPEG quality (default 70).", "q", "70"});
+    parser.addPositionalArgument("source", "Optional image or video file to take the frame from.");
+    parser.process(app);
+
+    const int iterations = qMax(1, parser.value("iterations").toInt());
+    const int quality = qBound(1, parser.value("quality").toInt(), 100);
+
+    cv::Mat bgr;
+    if (!parser.positionalArguments().isEmpty()) {
+        bgr = loadFrame(parser.positionalArguments().first());
+        if (bgr.empty()) {
+            qCritical("Cannot read a frame from %s", qPrintable(parser.positionalArguments().first()));
+            return 1;
+        }
+    } else {
+        const QStringList wh = parser.value("size").split('x');
+        const int w = wh.value(0).toInt(), h = wh.value(1).toInt();
+        bgr = Synthetic::frame(cv::Size(w > 0 ? w : 1280, h > 0 ? h : 720));
+    }
+
+    QTextStream out(stdout);
+    out << "frame " << bgr.cols << "x" << bgr.rows << ", quality " << quality
+        << ", " << iterations << " iterations"
+#ifdef CCTV_HAVE_TURBOJPEG
+        << ", TurboJPEG\n\n";
+#else
+        << ", cv::imencode fallback (no libturbojpeg)\n\n";
+#endif
+
+    auto report = [&out](const QString& name, const Result& r) {
+        out << name.leftJustified(40) << QString::number(r.msPerFrame, 'f', 3).rightJustified(9) << " ms"
+            << QString::number(1000.0 / r.msPerFrame, 'f', 1).rightJustified(9) << " fps"
+            << QString::number(r.avgBytes / 1024.0, 'f', 1).rightJustified(9) << " KiB\n";
+        out.flush();
+    };
+
+    // 1) 기존 경로: matToQImage(BGR2RGB + copy) → QImage::save(QBuffer)
+    report("cvtColor+QImage::save", run(iterations, [&]() {
+        cv::Mat rgb;
+        cv::cvtColor(bgr, rgb, cv::COLOR_BGR2RGB);
+        const QImage img = QImage(rgb.data, rgb.cols, rgb.rows, int(rgb.step), QImage::Format_RGB888).copy();
+        QByteArray ba;
+        QBuffer buffer(&ba);
+        buffer.open(QIODevice::WriteOnly);
+        img.save(&buffer, "JPEG", quality);
+        return ba.size();
+    }));
+
+    // 2) QImage::save만 (변환 비용 제외)
+    {
+        cv::Mat rgb;
+        cv::cvtColor(bgr, rgb, cv::COLOR_BGR2RGB);
+        const QImage img = QImage(rgb.data, rgb.cols, rgb.rows, int(rgb.step), QImage::Format_RGB888).copy();
+        report("QImage::save only", run(iterations, [&]() {
+            QByteArray ba;
+            QBuffer buffer(&ba);
+            buffer.open(QIODevice::WriteOnly);
+            img.save(&buffer, "JPEG", quality);
+            return ba.size();
+        }));
+    }
+
+    // 3) JpegEncoder: 서브샘플링 × DCT 조합
+    JpegEncoder encoder;
+    const JpegEncoder::Subsampling samps[] = {
+        JpegEncoder::Subsampling::S444, JpegEncoder::Subsampling::S422, JpegEncoder::Subsampling::S420 };
+    for (JpegEncoder::Subsampling samp : samps) {
+        for (bool fast : {false, true}) {
+            JpegEncoder::Options opt;
+            opt.quality = quality;
+            opt.subsampling = samp;
+            opt.fastDct = fast;
+            QByteArray ba;
+            const QString name = QString("JpegEncoder %1 %2").arg(sampName(samp), fast ? "fast-DCT" : "islow-DCT");
+            report(name, run(iterations, [&]() {
+                encoder.encode(bgr, opt, ba);
+                return ba.size();
+            }));
+        }
+    }
+    return 0;
+}
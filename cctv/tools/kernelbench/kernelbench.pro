@@ -0,0 +1,29 @@
+# 감지/표시/스트림 경로의 영상 커널 마이크로 벤치마크 (해상도별, 구현별 비교)
+QT       += core gui
+
+CONFIG += c++17 console link_pkgconfig
+CONFIG -= app_bundle
+
+TARGET = kernelbench
+PKGCONFIG += opencv4
+
+packagesExist(libturbojpeg) {
+    PKGCONFIG += libturbojpeg
+    DEFINES += CCTV_HAVE_TURBOJPEG
+}
+
+CCTV_SRC = $$PWD/../..
+INCLUDEPATH += $$CCTV_SRC
+
+# 앱의 커널 함수를 그대로 부름 (motiondetector.h/streamserver.h는 인라인 함수와 상수만 씀 → 링크하지 않음)
+SOURCES += \
+    main.cpp \
+    $$CCTV_SRC/clipcatalog.cpp \
+    $$CCTV_SRC/jpegencoder.cpp \
+    $$CCTV_SRC/motionpipeline.cpp
+
+HEADERS += \
+    $$CCTV_SRC/clipcatalog.h \
+    $$CCTV_SRC/jpegencoder.h \
+    $$CCTV_SRC/motionpipeline.h \
+    $$CCTV_SRC/tools/common/syntheticframe.h
@@ -0,0 +1,454 @@
+// 영상 커널 마이크로 벤치마크 (감지 루프, QImage 변환, 스트림 인코딩 경로)
+//
+//   ./kernelbench                                      모든 커널 × 720p/1080p/4K
+//   ./kernelbench -f clahe -r 1080p                    이름(커널/구현/해상도)에 clahe가 들어간 것만, 1080p만
+//   ./kernelbench --json new.json --compare old.json   결과 저장 + 이전 결과 대비 속도 비교
+//   ./kernelbench --list                               커널과 앱에서 쓰는 곳
+//
+// Google Benchmark처럼 최소 시간(--min-time)을 채울 때까지 반복 횟수를 늘려 정한 뒤, 그 횟수로 여러 번(-n) 재서
+// 중앙값/최소값/변동 계수를 냅니다. 입력은 고정 시드의 합성 영상이라 어느 장비에서나 같고,
+// 장비 간 비교를 위해 기본은 OpenCV 스레드 1개입니다 (-t 0이면 OpenCV 기본값). 결과 JSON에 CPU와 OpenCV 빌드 정보를 함께 남깁니다.
+//
+// 커널마다 앱이 지금 쓰는 구현은 "current"이고 앱의 함수(MotionPipeline 단계, MotionDetector::matToQImage,
+// StreamServer 단계 표)를 그대로 부릅니다. 다른 구현은 kernels()에 같은 커널 이름으로 추가하면 표에서 나란히 비교됩니다.
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QSysInfo>
+#include <QTextStream>
+#include <QThread>
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+#include "clipcatalog.h"
+#include "jpegencoder.h"
+#include "motiondetector.h"
+#include "motionpipeline.h"
+#include "streamserver.h"
+#include "tools/common/syntheticframe.h"
+
+namespace {
+
+constexpr double DEFAULT_MIN_TIME_S = 0.2;
+constexpr int    DEFAULT_REPS       = 5;
+constexpr qint64 MAX_ITERATIONS     = 1'000'000;
+constexpr int    MOG2_WARMUP        = 30;      // 모델이 자리 잡은 상태에서 재도록
+
+const MotionParams PARAMS;   // 앱의 기본 감지 파라미터 (MotionDetector와 같음)
+
+struct Resolution { const char* name; int width; int height; };
+const Resolution RESOLUTIONS[] = { { "720p", 1280, 720 }, { "1080p", 1920, 1080 }, { "4k", 3840, 2160 } };
+
+// 해상도 하나의 입력 (모든 커널이 공유, 읽기 전용)
+struct Inputs {
+    cv::Mat frame;        // BGR 프레임
+    cv::Mat moved;        // 같은 장면에서 물체가 움직인 프레임 (MOG2 입력을 번갈아 넣음)
+    cv::Mat dark;         // 자동 CLAHE가 켜지는 어두운 프레임
+    cv::Mat rawFg;        // MOG2 출력처럼 0 / 127(그림자) / 255인 전경
+    cv::Mat ignoreMask;   // 워밍업에서 확정된 무시 마스크
+    cv::Mat fg;           // 이진화 + 무시 마스크를 거친 최종 전경 (윤곽선 입력)
+};
+
+using Body = std::function<void()>;
+
+// 벤치마크 하나 = 커널 + 구현. prepare는 입력을 받아 반복할 본문을 만들고, 해당 없는 해상도면 빈 함수
+struct Kernel {
+    const char* name;
+    const char* variant;
+    const char* usedBy;
+    std::function<Body(const Inputs&)> prepare;
+};
+
+// 같은 장면에서 물체(높이 1/5)만 mover 위치에 있는 프레임
+cv::Mat sceneFrame(cv::Size size, cv::Point mover)
+{
+    const int h = size.height / 5;
+    return Synthetic::frame(size, cv::Rect(mover, cv::Size(h / 2, h)));
+}
+
+Inputs makeInputs(cv::Size size)
+{
+    Inputs in;
+    in.frame = sceneFrame(size, cv::Point(size.width / 4, size.height / 3));
+    in.moved = sceneFrame(size, cv::Point(size.width / 4 + size.width / 20, size.height / 3));
+    in.frame.convertTo(in.dark, -1, 0.3);
+
+    // 움직이는 물체 두 개 + 그림자 + 흩어진 잡음 (약 0.5%)
+    in.rawFg = cv::Mat::zeros(size, CV_8UC1);
+    const int h = size.height / 5;
+    cv::rectangle(in.rawFg, cv::Rect(size.width / 4, size.height / 3, h / 2, h), cv::Scalar(255), cv::FILLED);
+    cv::ellipse(in.rawFg, cv::Point(size.width * 2 / 3, size.height * 2 / 3), cv::Size(h / 2, h / 4), 0, 0, 360, cv::Scalar(255), cv::FILLED);
+    cv::rectangle(in.rawFg, cv::Rect(size.width / 4 + h / 2, size.height / 3 + h / 2, h / 3, h / 2), cv::Scalar(127), cv::FILLED);
+    cv::Mat speckle(size, CV_16UC1);
+    cv::theRNG().state = 4242;
+    cv::randu(speckle, 0, 1000);
+    in.rawFg.setTo(255, speckle < 5);
+
+    // 무시 마스크: 흔들리는 나무 같은 영역 몇 곳 (0 = 무시)
+    in.ignoreMask = cv::Mat(size, CV_8UC1, cv::Scalar(255));
+    cv::circle(in.ignoreMask, cv::Point(size.width / 10, size.height / 8), h / 2, cv::Scalar(0), cv::FILLED);
+    cv::circle(in.ignoreMask, cv::Point(size.width * 9 / 10, size.height / 6), h / 3, cv::Scalar(0), cv::FILLED);
+
+    cv::threshold(in.rawFg, in.fg, PARAMS.threshBin, 255, cv::THRESH_BINARY);
+    MotionPipeline::maskIgnored(in.fg, in.ignoreMask);
+    return in;
+}
+
+// 스트림 서버의 JPEG 단계 (이름으로)
+StreamServer::Rendition rendition(const QString& name)
+{
+    for (const StreamServer::Rendition& r : StreamServer::jpegRenditions()) {
+        if (r.name == name) return r;
+    }
+    qFatal("unknown rendition %s", qPrintable(name));
+}
+
+// 어두운 입력에서 자동 CLAHE가 고르는 강도와 같은 설정의 CLAHE
+cv::Ptr<cv::CLAHE> darkClahe(const Inputs& in)
+{
+    const double clipLimit = MotionPipeline::autoClipLimit(MotionPipeline::brightness(in.dark), PARAMS);
+    return cv::createCLAHE(clipLimit > 0.0 ? clipLimit : PARAMS.claheClipLimit, PARAMS.claheGridSize);
+}
+
+// 스트림 서버가 maxHeight 단계로 축소하는 본문. 축소할 필요가 없는 해상도면 빈 함수
+Body streamResize(const Inputs& in, int maxHeight)
+{
+    const cv::Size size = StreamServer::renditionSize(in.frame.size(), maxHeight);
+    if (size == in.frame.size()) return Body();
+    return [frame = in.frame, size]() {
+        cv::Mat scaled;
+        cv::resize(frame, scaled, size, 0, 0, cv::INTER_AREA);
+    };
+}
+
+const std::vector<Kernel>& kernels()
+{
+    static const std::vector<Kernel> list = {
+        { "brightness", "current", "MotionPipeline: auto CLAHE brightness", [](const Inputs& in) -> Body {
+              return [frame = in.frame]() { MotionPipeline::brightness(frame); };
+          } },
+        { "clahe", "current", "MotionPipeline: BGR->Lab, CLAHE on L, Lab->BGR (split/merge)", [](const Inputs& in) -> Body {
+              return [clahe = darkClahe(in), frame = in.dark]() {
+                  cv::Mat processed;
+                  MotionPipeline::applyClahe(*clahe, frame, processed);
+              };
+          } },
+        { "clahe", "lab-extract", "same output, L plane only via extract/insertChannel", [](const Inputs& in) -> Body {
+              return [clahe = darkClahe(in), frame = in.dark]() {
+                  cv::Mat lab, l, processed;
+                  cv::cvtColor(frame, lab, cv::COLOR_BGR2Lab);
+                  cv::extractChannel(lab, l, 0);
+                  clahe->apply(l, l);
+                  cv::insertChannel(l, lab, 0);
+                  cv::cvtColor(lab, processed, cv::COLOR_Lab2BGR);
+              };
+          } },
+        { "copy", "current", "MotionPipeline: copy of the reused capture buffer (no CLAHE)", [](const Inputs& in) -> Body {
+              return [frame = in.frame]() {
+                  cv::Mat processed;
+                  frame.copyTo(processed);
+              };
+          } },
+        { "mog2", "current", "MotionPipeline: MOG2 apply (armed learning rate)", [](const Inputs& in) -> Body {
+              cv::Ptr<cv::BackgroundSubtractorMOG2> mog2 =
+                  cv::createBackgroundSubtractorMOG2(PARAMS.mog2History, PARAMS.mog2VarThreshold, true);
+              cv::Mat fg;
+              for (int i = 0; i < MOG2_WARMUP; ++i) mog2->apply(i % 2 ? in.moved : in.frame, fg, PARAMS.lrWarmup);
+              return [mog2, a = in.frame, b = in.moved, fg, n = 0]() mutable {
+                  mog2->apply(n++ % 2 ? b : a, fg, PARAMS.lrArmed);
+              };
+          } },
+        { "threshold_and", "current", "MotionPipeline: binarize + ignore mask (armed)", [](const Inputs& in) -> Body {
+              return [raw = in.rawFg, ignore = in.ignoreMask, fg = cv::Mat()]() mutable {
+                  cv::threshold(raw, fg, PARAMS.threshBin, 255, cv::THRESH_BINARY);
+                  MotionPipeline::maskIgnored(fg, ignore);
+              };
+          } },
+        { "dilate", "current", "MotionPipeline: ellipse dilate by ignDilateK (warm-up ignore mask)", [](const Inputs& in) -> Body {
+              cv::Mat bin;
+              cv::threshold(in.rawFg, bin, PARAMS.threshBin, 255, cv::THRESH_BINARY);
+              // 앱은 제자리(fg → fg)지만 입력이 매번 같도록 다른 버퍼에 씀
+              return [bin, out = cv::Mat()]() mutable {
+                  MotionPipeline::dilateIgnore(bin, out, PARAMS.ignDilateK);
+              };
+          } },
+        { "contours", "current", "MotionPipeline: findContours + area/bounding boxes", [](const Inputs& in) -> Body {
+              return [fg = in.fg]() {
+                  MotionPipeline::Result result;
+                  MotionPipeline::findBlobs(fg, PARAMS, result);
+              };
+          } },
+        { "qimage", "current", "MotionDetector::matToQImage: BGR2RGB into a temp, then QImage copy", [](const Inputs& in) -> Body {
+              return [frame = in.frame]() { const QImage image = MotionDetector::matToQImage(frame); };
+          } },
+        { "qimage", "cvt-into-qimage", "same output, BGR2RGB written straight into the QImage buffer", [](const Inputs& in) -> Body {
+              return [frame = in.frame]() {
+                  QImage image(frame.cols, frame.rows, QImage::Format_RGB888);
+                  cv::Mat dst(frame.rows, frame.cols, CV_8UC3, image.bits(), size_t(image.bytesPerLine()));
+                  cv::cvtColor(frame, dst, cv::COLOR_BGR2RGB);
+              };
+          } },
+        { "qimage", "bgr888-copy", "Format_BGR888 copy, no swap here (conversion moves to the GUI paint)", [](const Inputs& in) -> Body {
+              return [frame = in.frame]() {
+                  const QImage image = QImage(frame.data, frame.cols, frame.rows, int(frame.step), QImage::Format_BGR888).copy();
+              };
+          } },
+        { "proxy_resize", "current", "MotionDetector::writeProxy: INTER_AREA to 360p", [](const Inputs& in) -> Body {
+              const cv::Size size = ClipCatalog::fitInside(in.frame.size(),
+                                                           { MotionDetector::PROXY_MAX_W, MotionDetector::PROXY_MAX_H });
+              if (size.width >= in.frame.cols) return Body();
+              return [frame = in.frame, size]() {
+                  cv::Mat small;
+                  cv::resize(frame, small, size, 0, 0, cv::INTER_AREA);
+              };
+          } },
+        { "stream_resize_720p", "current", "StreamServer encode task: INTER_AREA to the 720p rendition", [](const Inputs& in) -> Body {
+              return streamResize(in, rendition("720p").maxHeight);
+          } },
+        { "stream_resize_360p", "current", "StreamServer encode task: INTER_AREA to the 360p rendition", [](const Inputs& in) -> Body {
+              return streamResize(in, rendition("360p").maxHeight);
+          } },
+        { "stream_jpeg", "current", "StreamServer encode task: JpegEncoder with the full rendition's options", [](const Inputs& in) -> Body {
+              return [frame = in.frame, opt = rendition("full").jpeg]() {
+                  QByteArray jpeg;
+                  JpegEncoder::threadLocal().encode(frame, opt, jpeg);
+              };
+          } },
+    };
+    return list;
+}
+
+struct Result {
+    QString name;
+    const Kernel* kernel = nullptr;
+    const Resolution* resolution = nullptr;
+    qint64 iterations = 0;   // 한 번 잴 때의 반복 횟수
+    double medianNs = 0.0;   // 반복 1회당
+    double minNs = 0.0;
+    double cpuNs = 0.0;      // 프로세스 CPU 시간 (OpenCV 스레드 포함)
+    double cv = 0.0;         // 변동 계수 (표준편차 / 평균)
+
+    double mpixPerS() const { return resolution->width * double(resolution->height) / medianNs * 1e3; }
+};
+
+void measure(const Body& body, double minTimeS, int repetitions, Result& r)
+{
+    body();   // 워밍업 (버퍼 할당, 캐시)
+
+    // 반복 횟수 정하기: 한 번 재는 데 최소 시간을 넘을 때까지 늘림
+    QElapsedTimer t;
+    qint64 iterations = 1;
+    for (;;) {
+        t.start();
+        for (qint64 i = 0; i < iterations; ++i) body();
+        const qint64 ns = t.nsecsElapsed();
+        if (ns >= minTimeS * 1e9 || iterations >= MAX_ITERATIONS) break;
+        const double grow = ns > 0 ? std::min(10.0, minTimeS * 1e9 * 1.4 / ns) : 10.0;
+        iterations = std::min(MAX_ITERATIONS, std::max(iterations + 1, qint64(iterations * grow)));
+    }
+
+    std::vector<double> samples;
+    double cpuTotal = 0.0;
+    for (int rep = 0; rep < repetitions; ++rep) {
+        const std::clock_t cpu0 = std::clock();
+        t.start();
+        for (qint64 i = 0; i < iterations; ++i) body();
+        samples.push_back(double(t.nsecsElapsed()) / iterations);
+        cpuTotal += double(std::clock() - cpu0) * 1e9 / CLOCKS_PER_SEC / iterations;
+    }
+    std::sort(samples.begin(), samples.end());
+    const size_t n = samples.size();
+    double mean = 0.0, var = 0.0;
+    for (double s : samples) mean += s / n;
+    for (double s : samples) var += (s - mean) * (s - mean) / n;
+
+    r.iterations = iterations;
+    r.medianNs = n % 2 ? samples[n / 2] : (samples[n / 2 - 1] + samples[n / 2]) / 2.0;
+    r.minNs = samples.front();
+    r.cpuNs = cpuTotal / repetitions;
+    r.cv = mean > 0.0 ? std::sqrt(var) / mean : 0.0;
+}
+
+QString formatTime(double ns)
+{
+    if (ns >= 1e6) return QString::number(ns / 1e6, 'f', 3) + " ms";
+    if (ns >= 1e3) return QString::number(ns / 1e3, 'f', 3) + " us";
+    return QString::number(ns, 'f', 1) + " ns";
+}
+
+QString cpuModel()
+{
+    QFile f("/proc/cpuinfo");
+    if (f.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        while (!f.atEnd()) {
+            const QByteArray line = f.readLine();
+            if (line.startsWith("model name")) return QString::fromUtf8(line.mid(line.indexOf(':') + 1)).trimmed();
+        }
+    }
+    return QSysInfo::currentCpuArchitecture();
+}
+
+QJsonObject hostJson()
+{
+    return {
+        { "cpu", cpuModel() },
+        { "cpu_arch", QSysInfo::currentCpuArchitecture() },
+        { "os", QSysInfo::prettyProductName() },
+        { "logical_cpus", QThread::idealThreadCount() },
+        { "opencv", CV_VERSION },
+        { "opencv_cpu_features", QString::fromStdString(cv::getCPUFeaturesLine()) },
+        { "opencv_optimized", cv::useOptimized() },
+        { "cv_threads", cv::getNumThreads() },
+#ifdef CCTV_HAVE_TURBOJPEG
+        { "jpeg", "turbojpeg" },
+#else
+        { "jpeg", "imencode" },
+#endif
+    };
+}
+
+QJsonObject resultJson(const Result& r)
+{
+    return {
+        { "name", r.name },
+        { "kernel", r.kernel->name },
+        { "variant", r.kernel->variant },
+        { "resolution", r.resolution->name },
+        { "width", r.resolution->width },
+        { "height", r.resolution->height },
+        { "iterations", double(r.iterations) },
+        { "median_ns", r.medianNs },
+        { "min_ns", r.minNs },
+        { "cpu_ns", r.cpuNs },
+        { "cv", r.cv },
+        { "mpix_per_s", r.mpixPerS() },
+    };
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Micro-benchmark the image kernels on the detection, display and streaming hot paths");
+    parser.addHelpOption();
+    parser.addOption({{"f", "filter"}, "Only benchmarks whose kernel/variant/resolution name matches this regex.", "regex"});
+    parser.addOption({{"r", "resolutions"}, "Comma-separated subset of 720p,1080p,4k (default all).", "list"});
+    parser.addOption({"min-time", "Minimum seconds per measurement (default 0.2).", "s", QString::number(DEFAULT_MIN_TIME_S)});
+    parser.addOption({{"n", "repetitions"}, "Measurements per benchmark, median reported (default 5).", "n", QString::number(DEFAULT_REPS)});
+    parser.addOption({{"t", "threads"}, "OpenCV worker threads; 0 = OpenCV default (default 1 for comparable numbers).", "n", "1"});
+    parser.addOption({"json", "Write results as JSON.", "file"});
+    parser.addOption({"compare", "Show the speedup against a previous --json result.", "file"});
+    parser.addOption({"list", "List kernels and where the app uses them, then exit."});
+    parser.process(app);
+
+    QTextStream out(stdout);
+    if (parser.isSet("list")) {
+        for (const Kernel& k : kernels()) {
+            out << QString("%1/%2").arg(k.name, k.variant).leftJustified(36) << k.usedBy << '\n';
+        }
+        return 0;
+    }
+
+    const int threads = parser.value("threads").toInt();
+    if (threads > 0) cv::setNumThreads(threads);
+    const double minTimeS = std::max(0.01, parser.value("min-time").toDouble());
+    const int repetitions = std::max(1, parser.value("repetitions").toInt());
+
+    QRegularExpression filter;
+    if (parser.isSet("filter")) {
+        filter = QRegularExpression(parser.value("filter"), QRegularExpression::CaseInsensitiveOption);
+        if (!filter.isValid()) {
+            qCritical("Invalid --filter: %s", qPrintable(filter.errorString()));
+            return 1;
+        }
+    }
+    QStringList resolutions;
+    for (const QString& r : parser.value("resolutions").split(',', Qt::SkipEmptyParts)) resolutions << r.trimmed().toLower();
+
+    QHash<QString, double> baseline;
+    if (parser.isSet("compare")) {
+        QFile f(parser.value("compare"));
+        const QJsonObject base = f.open(QIODevice::ReadOnly) ? QJsonDocument::fromJson(f.readAll()).object() : QJsonObject();
+        if (base.isEmpty()) {
+            qCritical("Cannot read %s", qPrintable(parser.value("compare")));
+            return 1;
+        }
+        for (const QJsonValue& v : base.value("benchmarks").toArray()) {
+            baseline.insert(v["name"].toString(), v["median_ns"].toDouble());
+        }
+        const QJsonObject host = base.value("host").toObject();
+        out << "baseline: " << host.value("cpu").toString() << ", OpenCV " << host.value("opencv").toString()
+            << ", " << host.value("cv_threads").toInt() << " thread(s)\n";
+    }
+
+    const QJsonObject host = hostJson();
+    out << host.value("cpu").toString() << ", OpenCV " << host.value("opencv").toString()
+        << ", " << cv::getNumThreads() << " thread(s), JPEG " << host.value("jpeg").toString() << "\n\n";
+    out << QString("Benchmark").leftJustified(40) << QString("Time").rightJustified(13) << QString("CPU").rightJustified(13)
+        << QString("MPix/s").rightJustified(10) << QString("Iter").rightJustified(8) << QString("CV").rightJustified(7);
+    if (!baseline.isEmpty()) out << QString("vs base").rightJustified(9);
+    out << '\n' << QString(100, '-') << '\n';
+    out.flush();
+
+    std::vector<Result> results;
+    for (const Resolution& res : RESOLUTIONS) {
+        if (!resolutions.isEmpty() && !resolutions.contains(res.name)) continue;
+        std::unique_ptr<Inputs> inputs;   // 이 해상도에서 돌릴 것이 있을 때만 만듦 (4K 입력은 수십 MB)
+        for (const Kernel& k : kernels()) {
+            Result r;
+            r.name = QString("%1/%2/%3").arg(k.name, k.variant, res.name);
+            if (parser.isSet("filter") && !filter.match(r.name).hasMatch()) continue;
+            if (!inputs) inputs = std::make_unique<Inputs>(makeInputs(cv::Size(res.width, res.height)));
+            const Body body = k.prepare(*inputs);
+            if (!body) continue;
+            r.kernel = &k;
+            r.resolution = &res;
+            measure(body, minTimeS, repetitions, r);
+
+            out << r.name.leftJustified(40) << formatTime(r.medianNs).rightJustified(13) << formatTime(r.cpuNs).rightJustified(13)
+                << QString::number(r.mpixPerS(), 'f', 1).rightJustified(10) << QString::number(r.iterations).rightJustified(8)
+                << (QString::number(r.cv * 100.0, 'f', 1) + '%').rightJustified(7);
+            if (!baseline.isEmpty()) {
+                const double base = baseline.value(r.name);
+                out << (base > 0.0 ? QString::number(base / r.medianNs, 'f', 2) + 'x' : QString("-")).rightJustified(9);
+            }
+            out << '\n';
+            out.flush();
+            results.push_back(r);
+        }
+    }
+
+    if (parser.isSet("json")) {
+        QJsonArray benchmarks;
+        for (const Result& r : results) benchmarks.append(resultJson(r));
+        const QJsonObject doc {
+            { "tool", "kernelbench" },
+            { "host", host },
+            { "config", QJsonObject { { "min_time_s", minTimeS }, { "repetitions", repetitions } } },
+            { "benchmarks", benchmarks },
+        };
+        QFile f(parser.value("json"));
+        const QByteArray json = QJsonDocument(doc).toJson(QJsonDocument::Indented);
+        if (!f.open(QIODevice::WriteOnly) || f.write(json) != json.size()) {
+            qCritical("Cannot write %s", qPrintable(parser.value("json")));
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,11 @@
+# 스트림 서버 부하 생성기: 로컬에서 WebSocket 시청자 수백 개를 열어 팬아웃 처리량/지연을 측정
+QT       += core network websockets
+QT       -= gui
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = loadgen
+
+SOURCES += \
+    main.cpp
@@ -0,0 +1,250 @@
+// 스트림 서버 부하 생성기
+//
+//   ./loadgen                                  ws://127.0.0.1:8080/ 에 시청자 200개, 10초
+//   ./loadgen -n 500 -t 8 -d 30 -q 360p        시청자 수/스레드/측정 시간/화질 지정
+//   ./loadgen ws://10.10.16.44:8080/           다른 호스트
+//
+// 모든 시청자가 받은 바이너리 메시지를 내용으로 식별해, 같은 프레임을 가장 먼저 받은 시청자 대비
+// 얼마나 늦게 받았는지(팬아웃 지연)와 시청자별 수신 fps/누락률을 보고합니다.
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QHash>
+#include <QTextStream>
+#include <QThread>
+#include <QTimer>
+#include <QUrl>
+#include <QUrlQuery>
+#include <QWebSocket>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace {
+
+constexpr int CONNECT_TIMEOUT_MS = 10000;
+constexpr int FRAME_ID_TAIL      = 256;    // 프레임 식별에 쓰는 끝부분 바이트 수 (엔트로피 데이터)
+
+struct Viewer {
+    QWebSocket* ws = nullptr;
+    qint64  openedNs    = 0;
+    qint64  connectedNs = -1;
+    quint64 frames      = 0;
+    quint64 bytes       = 0;
+};
+
+struct Arrival {
+    quint64 frameId;
+    qint64  ns;
+};
+
+// 스레드 하나가 맡는 시청자들. 시청자 소켓은 그 스레드의 이벤트 루프에서만 다룸
+struct Worker {
+    QThread              thread;
+    QObject*             ctx = nullptr;
+    std::vector<Viewer>  viewers;
+    std::vector<Arrival> arrivals;
+    int                  disconnects = 0;
+};
+
+struct Shared {
+    QElapsedTimer        clock;            // 모든 스레드가 같은 기준 시각 사용 (단조 시계)
+    std::atomic_bool     measuring{false};
+    std::atomic_int      connected{0};
+    std::atomic<quint64> frames{0};
+    std::atomic<quint64> bytes{0};
+};
+
+quint64 frameId(const QByteArray& msg)
+{
+    const qsizetype tail = qMin<qsizetype>(msg.size(), FRAME_ID_TAIL);
+    return (quint64(qHash(QByteArrayView(msg.constData() + msg.size() - tail, tail))) << 24) ^ quint64(msg.size());
+}
+
+double percentile(std::vector<double>& v, double p)
+{
+    if (v.empty()) return 0.0;
+    const size_t k = std::min(v.size() - 1, size_t(p * (v.size() - 1) + 0.5));
+    std::nth_element(v.begin(), v.begin() + k, v.end());
+    return v[k];
+}
+
+void openViewers(Worker* w, Shared* shared, const QUrl& url)
+{
+    for (size_t i = 0; i < w->viewers.size(); ++i) {
+        auto* ws = new QWebSocket(QString(), QWebSocketProtocol::VersionLatest, w->ctx);
+        w->viewers[i].ws = ws;
+        QObject::connect(ws, &QWebSocket::connected, w->ctx, [w, shared, i]() {
+            w->viewers[i].connectedNs = shared->clock.nsecsElapsed();
+            ++shared->connected;
+        });
+        QObject::connect(ws, &QWebSocket::disconnected, w->ctx, [w, shared, i]() {
+            if (w->viewers[i].connectedNs >= 0 && shared->measuring) ++w->disconnects;
+        });
+        QObject::connect(ws, &QWebSocket::binaryMessageReceived, w->ctx, [w, shared, i](const QByteArray& msg) {
+            if (!shared->measuring) return;
+            const qint64 now = shared->clock.nsecsElapsed();
+            Viewer& v = w->viewers[i];
+            ++v.frames;
+            v.bytes += msg.size();
+            w->arrivals.push_back({ frameId(msg), now });
+            shared->frames.fetch_add(1, std::memory_order_relaxed);
+            shared->bytes.fetch_add(msg.size(), std::memory_order_relaxed);
+        });
+        w->viewers[i].openedNs = shared->clock.nsecsElapsed();
+        ws->open(url);
+    }
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("WebSocket fan-out load generator for the CCTV stream server");
+    parser.addHelpOption();
+    parser.addOption({{"n", "viewers"}, "Number of WebSocket viewers (default 200).", "n", "200"});
+    parser.addOption({{"t", "threads"}, "Client threads (default: ideal thread count).", "n",
+                      QString::number(QThread::idealThreadCount())});
+    parser.addOption({{"d", "duration"}, "Measurement time in seconds (default 10).", "sec", "10"});
+    parser.addOption({{"q", "quality"}, "Rendition to request (?q=), e.g. 360p, full, h264.", "name"});
+    parser.addPositionalArgument("url", "Stream server URL (default ws://127.0.0.1:8080/).");
+    parser.process(app);
+
+    const int viewers = qMax(1, parser.value("viewers").toInt());
+    const int threads = qBound(1, parser.value("threads").toInt(), viewers);
+    const int duration = qMax(1, parser.value("duration").toInt());
+    QUrl url(parser.positionalArguments().value(0, QStringLiteral("ws://127.0.0.1:8080/")));
+    if (parser.isSet("quality")) {
+        QUrlQuery q(url);
+        q.addQueryItem("q", parser.value("quality"));
+        url.setQuery(q);
+    }
+
+    QTextStream out(stdout);
+    out << "url " << url.toString() << ", " << viewers << " viewers on " << threads << " threads, "
+        << duration << " s\n";
+    out.flush();
+
+    Shared shared;
+    shared.clock.start();
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (int t = 0; t < threads; ++t) {
+        auto w = std::make_unique<Worker>();
+        w->viewers.resize(viewers / threads + (t < viewers % threads ? 1 : 0));
+        w->arrivals.reserve(w->viewers.size() * duration * 32);
+        w->ctx = new QObject;
+        w->ctx->moveToThread(&w->thread);
+        w->thread.start();
+        Worker* wp = w.get();
+        QMetaObject::invokeMethod(wp->ctx, [wp, &shared, url]() { openViewers(wp, &shared, url); },
+                                  Qt::QueuedConnection);
+        workers.push_back(std::move(w));
+    }
+
+    // 1) 접속 단계
+    QEventLoop loop;
+    QTimer poll;
+    QObject::connect(&poll, &QTimer::timeout, &loop, [&]() {
+        if (shared.connected == viewers || shared.clock.elapsed() > CONNECT_TIMEOUT_MS) loop.quit();
+    });
+    poll.start(50);
+    loop.exec();
+    poll.stop();
+    out << "connected " << shared.connected << "/" << viewers << " in " << shared.clock.elapsed() << " ms\n";
+    out.flush();
+
+    // 2) 측정 단계 (1초마다 전체 수신량 출력). 아무도 접속하지 못했으면 건너뛰고 정리만
+    const qint64 measureStartNs = shared.clock.nsecsElapsed();
+    shared.measuring = true;
+    quint64 lastFrames = 0, lastBytes = 0;
+    int elapsedSec = shared.connected > 0 ? 0 : duration;
+    QTimer tick;
+    QObject::connect(&tick, &QTimer::timeout, &loop, [&]() {
+        const quint64 f = shared.frames, b = shared.bytes;
+        ++elapsedSec;
+        out << QString("  t=%1s  %2 msg/s  %3 MB/s  %4 viewers\n")
+                   .arg(elapsedSec, 3)
+                   .arg(f - lastFrames, 8)
+                   .arg((b - lastBytes) / 1e6, 8, 'f', 1)
+                   .arg(shared.connected.load());
+        out.flush();
+        lastFrames = f;
+        lastBytes = b;
+        if (elapsedSec >= duration) loop.quit();
+    });
+    tick.start(1000);
+    if (elapsedSec < duration) loop.exec();
+    shared.measuring = false;
+    const double measuredSec = (shared.clock.nsecsElapsed() - measureStartNs) / 1e9;
+
+    // 3) 정리: 각 스레드에서 소켓을 닫고 스레드 종료 후 결과 수집
+    for (auto& w : workers) {
+        Worker* wp = w.get();
+        QMetaObject::invokeMethod(wp->ctx, [wp]() {
+            for (Viewer& v : wp->viewers) if (v.ws) v.ws->abort();
+        }, Qt::BlockingQueuedConnection);
+        w->thread.quit();
+        w->thread.wait();
+        delete w->ctx;   // 스레드가 끝났으므로 여기서 지워도 안전 (자식 소켓도 함께)
+        w->ctx = nullptr;
+    }
+
+    if (shared.connected == 0) {
+        qCritical("No viewer could connect to %s", qPrintable(url.toString()));
+        return 1;
+    }
+
+    QHash<quint64, qint64> firstArrival;
+    std::vector<double> connectMs, viewerFps;
+    quint64 totalFrames = 0, totalBytes = 0;
+    int disconnects = 0;
+    for (const auto& w : workers) {
+        disconnects += w->disconnects;
+        for (const Arrival& a : w->arrivals) {
+            auto it = firstArrival.find(a.frameId);
+            if (it == firstArrival.end()) firstArrival.insert(a.frameId, a.ns);
+            else if (a.ns < it.value()) it.value() = a.ns;
+        }
+        for (const Viewer& v : w->viewers) {
+            if (v.connectedNs < 0) continue;
+            connectMs.push_back((v.connectedNs - v.openedNs) / 1e6);
+            viewerFps.push_back(v.frames / measuredSec);
+            totalFrames += v.frames;
+            totalBytes += v.bytes;
+        }
+    }
+    std::vector<double> skewMs;
+    skewMs.reserve(totalFrames);
+    for (const auto& w : workers) {
+        for (const Arrival& a : w->arrivals) skewMs.push_back((a.ns - firstArrival.value(a.frameId)) / 1e6);
+    }
+
+    const double distinct = firstArrival.size();
+    const double meanFps = viewerFps.empty() ? 0.0 : totalFrames / measuredSec / viewerFps.size();
+    auto ms = [](double v) { return QString::number(v, 'f', 2); };
+
+    out << "\nviewers            " << viewerFps.size() << " connected, " << disconnects << " dropped during run\n"
+        << "connect time       p50 " << ms(percentile(connectMs, 0.5)) << " ms, max "
+        << ms(percentile(connectMs, 1.0)) << " ms\n"
+        << "source frames      " << distinct << " distinct (" << QString::number(distinct / measuredSec, 'f', 1)
+        << " fps)\n"
+        << "per-viewer fps     mean " << QString::number(meanFps, 'f', 1)
+        << ", p5 " << QString::number(percentile(viewerFps, 0.05), 'f', 1)
+        << ", min " << QString::number(percentile(viewerFps, 0.0), 'f', 1) << "\n"
+        << "delivered          " << QString::number(distinct > 0 ? 100.0 * meanFps * measuredSec / distinct : 0.0, 'f', 1)
+        << " % of source frames per viewer\n"
+        << "throughput         " << QString::number(totalBytes / measuredSec / 1e6, 'f', 1) << " MB/s ("
+        << QString::number(totalBytes * 8 / measuredSec / 1e6, 'f', 0) << " Mbit/s), "
+        << QString::number(totalFrames / measuredSec, 'f', 0) << " msg/s\n"
+        << "fan-out delay      p50 " << ms(percentile(skewMs, 0.5)) << "  p95 " << ms(percentile(skewMs, 0.95))
+        << "  p99 " << ms(percentile(skewMs, 0.99)) << "  max " << ms(percentile(skewMs, 1.0))
+        << " ms  (vs. first viewer to receive the same frame)\n";
+    return 0;
+}
@@ -0,0 +1,514 @@
+// 움직임 감지 파라미터 스윕 (녹화 영상 재분석)
+//
+//   ./motionsweep                                         ~/Videos/cctv 의 클립 전부, 기본 설정
+//   ./motionsweep -s thresh=120,150,180 -s min-area=800,1200 ~/Videos/cctv
+//   ./motionsweep -s clahe=off,auto -s var-threshold=16,25 -l labels.csv --csv out.csv a.mp4 b.mp4
+//
+// 클립마다 작업 하나(-j개 동시)가 영상을 한 번 디코딩하면서 모든 설정 조합의 MotionPipeline에 같은 프레임을 넣습니다.
+// 시각은 영상 안의 위치(프레임 번호 / fps)라서 실시간보다 빠르게 돌려도 워밍업/이벤트 판정이 녹화 당시와 같습니다.
+// 조합 하나가 프레임 크기 × 약 100바이트(MOG2 모델)를 쓰므로 조합이 많으면 -b로 한 번에 돌릴 개수를 줄이세요.
+//
+// labels.csv (선택): 한 줄에 실제 움직임 구간 하나 "파일 이름,시작 초,끝 초" (# 은 주석).
+// 라벨 파일을 주면 거기 없는 클립은 움직임이 없는 영상으로 보고, 라벨 구간과 겹치지 않는 이벤트를 오탐으로 셉니다.
+// 워밍업 동안 끝나는 라벨 구간은 어떤 설정으로도 잡을 수 없으므로 놓침에서 뺍니다.
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <type_traits>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+#include "motionpipeline.h"
+
+namespace {
+
+constexpr double FALLBACK_FPS   = 30.0;   // 컨테이너에 fps가 없을 때
+constexpr int    EVENT_GAP_S    = 5;      // 녹화기의 REC_GRACE_PERIOD_S와 같게 (이보다 짧게 끊긴 감지는 한 이벤트)
+constexpr int    DEFAULT_BATCH  = 4;      // 디코딩 한 번에 함께 돌리는 설정 조합 수
+
+using Interval = QPair<qint64, qint64>;   // [시작, 끝] ms
+using Labels   = QHash<QString, QList<Interval>>;
+
+// -s 이름=값,값,... 으로 바꿀 수 있는 파라미터
+struct ParamSpec {
+    const char* name;
+    const char* help;
+    std::function<bool(MotionParams&, const QString&)> apply;
+};
+
+// [min, max] 밖의 값이나 정수 파라미터의 소수는 거부 (풀 워커 안에서 OpenCV 예외가 나지 않도록 여기서 걸러냄)
+template <typename T>
+std::function<bool(MotionParams&, const QString&)> number(T MotionParams::*field, double min = 0.0,
+                                                          double max = std::numeric_limits<double>::max())
+{
+    return [field, min, max](MotionParams& p, const QString& value) {
+        bool ok = false;
+        const double v = value.toDouble(&ok);
+        if (!ok || v < min || v > max) return false;
+        if (std::is_integral_v<T> && v != std::floor(v)) return false;
+        p.*field = static_cast<T>(v);
+        return true;
+    };
+}
+
+// 형태 연산 커널 크기: 1 이상의 홀수 (짝수면 타원의 중심이 한쪽으로 치우침)
+std::function<bool(MotionParams&, const QString&)> kernelSize(int MotionParams::*field)
+{
+    const auto set = number(field, 1.0);
+    return [set](MotionParams& p, const QString& value) {
+        bool ok = false;
+        const int k = value.toInt(&ok);
+        return ok && k % 2 == 1 && set(p, value);
+    };
+}
+
+const std::vector<ParamSpec>& paramSpecs()
+{
+    static const std::vector<ParamSpec> specs = {
+        { "thresh",        "MOG2 foreground binarization threshold, 0-255 (150)", number(&MotionParams::threshBin, 0.0, 255.0) },
+        { "min-area",      "minimum contour area to count as motion (1200)", number(&MotionParams::minArea) },
+        { "warmup",        "warm-up length in ms, >= 1 (3000)", number(&MotionParams::warmupMs, 1.0) },
+        { "dilate",        "ignore-mask dilation kernel, odd (21)", kernelSize(&MotionParams::ignDilateK) },
+        { "trim",          "ignore-mask erosion kernel, odd (15)", kernelSize(&MotionParams::ignTrimK) },
+        { "history",       "MOG2 history, >= 1 (500)", number(&MotionParams::mog2History, 1.0) },
+        { "var-threshold", "MOG2 variance threshold (16)", number(&MotionParams::mog2VarThreshold) },
+        { "lr-armed",      "MOG2 learning rate when armed, 0-1 (0.002)", number(&MotionParams::lrArmed, 0.0, 1.0) },
+        { "lr-warmup",     "MOG2 learning rate during warm-up, 0-1 (0.01)", number(&MotionParams::lrWarmup, 0.0, 1.0) },
+        { "clahe",         "off | on | auto (off)", [](MotionParams& p, const QString& v) {
+              if (v == "off")       { p.useClahe = false; p.autoClahe = false; }
+              else if (v == "on")   { p.useClahe = true;  p.autoClahe = false; }
+              else if (v == "auto") { p.useClahe = false; p.autoClahe = true; }
+              else return false;
+              return true;
+          } },
+        { "clip-limit",    "CLAHE clip limit when on (2.0)", number(&MotionParams::claheClipLimit) },
+        { "grid",          "CLAHE tile grid, N or WxH (8x8)", [](MotionParams& p, const QString& v) {
+              const QStringList wh = v.split('x');
+              const int w = wh.value(0).toInt(), h = wh.size() > 1 ? wh.value(1).toInt() : w;
+              if (w <= 0 || h <= 0) return false;
+              p.claheGridSize = cv::Size(w, h);
+              return true;
+          } },
+        { "darkness",      "auto-CLAHE brightness threshold, 1-255 (80)", number(&MotionParams::darknessThreshold, 1.0, 255.0) },
+        { "max-clip",      "auto-CLAHE clip limit in full darkness, >= 1 (8.0)", number(&MotionParams::claheMaxClip, 1.0) },
+    };
+    return specs;
+}
+
+const ParamSpec* findSpec(const QString& name)
+{
+    for (const ParamSpec& spec : paramSpecs()) {
+        if (name == QLatin1String(spec.name)) return &spec;
+    }
+    return nullptr;
+}
+
+struct Config {
+    MotionParams params;
+    QStringList  values;   // 스윕한 파라미터 값 (축 순서)
+};
+
+// 축마다 값 목록 → 모든 조합
+bool buildGrid(const QStringList& axes, QStringList& names, std::vector<Config>& configs, QString& error)
+{
+    configs.assign(1, Config());
+    for (const QString& axis : axes) {
+        const int eq = axis.indexOf('=');
+        const ParamSpec* spec = eq > 0 ? findSpec(axis.left(eq)) : nullptr;
+        if (!spec) {
+            error = QString("unknown parameter in '%1' (see --params)").arg(axis);
+            return false;
+        }
+        const QStringList values = axis.mid(eq + 1).split(',', Qt::SkipEmptyParts);
+        if (values.isEmpty()) {
+            error = QString("no values in '%1'").arg(axis);
+            return false;
+        }
+        std::vector<Config> next;
+        next.reserve(configs.size() * values.size());
+        for (const Config& base : configs) {
+            for (const QString& value : values) {
+                Config c = base;
+                if (!spec->apply(c.params, value.trimmed())) {
+                    error = QString("bad value '%1' for %2").arg(value, spec->name);
+                    return false;
+                }
+                c.values << value.trimmed();
+                next.push_back(c);
+            }
+        }
+        configs.swap(next);
+        names << spec->name;
+    }
+    return true;
+}
+
+QStringList collectClips(const QStringList& args)
+{
+    static const QStringList patterns = { "*.mp4", "*.avi", "*.mkv", "*.mov" };
+    QStringList clips;
+    for (const QString& arg : args) {
+        const QFileInfo fi(arg);
+        if (fi.isDir()) {
+            // 숨김 파일(녹화 중인 .detect_..., .proxy/ 등)은 QDir 기본 필터에서 빠짐
+            for (const QFileInfo& f : QDir(arg).entryInfoList(patterns, QDir::Files, QDir::Name)) clips << f.filePath();
+        } else if (fi.isFile()) {
+            clips << fi.filePath();
+        }
+    }
+    return clips;
+}
+
+bool loadLabels(const QString& path, Labels& out, QString& error)
+{
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        error = QString("cannot open %1").arg(path);
+        return false;
+    }
+    QTextStream in(&f);
+    int lineNo = 0;
+    while (!in.atEnd()) {
+        const QString line = in.readLine().trimmed();
+        ++lineNo;
+        if (line.isEmpty() || line.startsWith('#')) continue;
+        const QStringList parts = line.split(',');
+        bool okStart = false, okEnd = false;
+        const double start = parts.value(1).trimmed().toDouble(&okStart);
+        const double end = parts.value(2).trimmed().toDouble(&okEnd);
+        if (parts.size() < 3 || !okStart || !okEnd || end < start) {
+            error = QString("%1:%2: expected 'file,start_s,end_s'").arg(path).arg(lineNo);
+            return false;
+        }
+        out[QFileInfo(parts.at(0).trimmed()).fileName()].append({ qint64(start * 1000), qint64(end * 1000) });
+    }
+    return true;
+}
+
+// 감지 프레임을 녹화기처럼 이벤트로 묶음 (gapMs 넘게 감지가 없으면 끝)
+struct EventTracker {
+    qint64 gapMs = 0;
+    bool   open = false;
+    qint64 start = 0, last = 0;
+    QList<Interval> events;
+
+    void feed(bool detected, qint64 t)
+    {
+        if (detected) {
+            if (!open) { open = true; start = t; }
+            last = t;
+        } else if (open && t - last >= gapMs) {
+            events.append({ start, last });
+            open = false;
+        }
+    }
+    void finish()
+    {
+        if (open) events.append({ start, last });
+        open = false;
+    }
+};
+
+constexpr int STAGES = 5;
+const char* const STAGE_NAMES[STAGES] = { "bright", "clahe", "mog2", "mask", "contour" };
+
+struct Stats {
+    qint64 frames = 0;
+    qint64 footageMs = 0;
+    qint64 detectedFrames = 0;
+    int    events = 0;
+    int    falseAlarms = 0;
+    int    labelsTotal = 0;
+    int    labelsCaught = 0;
+    qint64 stageNs[STAGES] = {};
+
+    void add(const Stats& o)
+    {
+        frames += o.frames;
+        footageMs += o.footageMs;
+        detectedFrames += o.detectedFrames;
+        events += o.events;
+        falseAlarms += o.falseAlarms;
+        labelsTotal += o.labelsTotal;
+        labelsCaught += o.labelsCaught;
+        for (int i = 0; i < STAGES; ++i) stageNs[i] += o.stageNs[i];
+    }
+    qint64 totalNs() const
+    {
+        qint64 sum = 0;
+        for (qint64 ns : stageNs) sum += ns;
+        return sum;
+    }
+};
+
+struct ClipResult {
+    QString            error;
+    qint64             frames = 0;
+    qint64             decodeNs = 0;
+    std::vector<Stats> perConfig;
+};
+
+bool overlaps(const Interval& a, const Interval& b) { return a.first <= b.second && b.first <= a.second; }
+
+// 이벤트와 라벨 비교 (labels가 없으면 이벤트 수만)
+void score(const QList<Interval>& events, const QList<Interval>* labels, int warmupMs, Stats& s)
+{
+    s.events = events.size();
+    if (!labels) return;
+    for (const Interval& e : events) {
+        bool hit = false;
+        for (const Interval& l : *labels) hit = hit || overlaps(e, l);
+        if (!hit) ++s.falseAlarms;
+    }
+    for (const Interval& l : *labels) {
+        if (l.second < warmupMs) continue;
+        ++s.labelsTotal;
+        for (const Interval& e : events) {
+            if (overlaps(e, l)) { ++s.labelsCaught; break; }
+        }
+    }
+}
+
+// 클립 하나를 모든 설정으로 재생 (작업자 스레드)
+void replayClip(const QString& path, const std::vector<Config>& configs, int batch, const Labels* labels,
+                ClipResult& out)
+{
+    out.perConfig.assign(configs.size(), Stats());
+    const QList<Interval> noLabels;
+    const QList<Interval>* clipLabels = nullptr;
+    if (labels) {
+        auto it = labels->constFind(QFileInfo(path).fileName());
+        clipLabels = it != labels->constEnd() ? &it.value() : &noLabels;
+    }
+
+    for (size_t first = 0; first < configs.size(); first += batch) {
+        const size_t n = std::min(configs.size() - first, size_t(batch));
+        cv::VideoCapture cap(path.toStdString());
+        if (!cap.isOpened()) {
+            out.error = "cannot open";
+            return;
+        }
+        double fps = cap.get(cv::CAP_PROP_FPS);
+        if (!(fps > 0 && fps < 1000)) fps = FALLBACK_FPS;
+
+        std::vector<MotionPipeline> pipelines;
+        std::vector<EventTracker> trackers(n);
+        pipelines.reserve(n);
+        for (size_t i = 0; i < n; ++i) {
+            pipelines.emplace_back(configs[first + i].params, 0);
+            trackers[i].gapMs = EVENT_GAP_S * 1000;
+        }
+
+        MotionPipeline::Result result;
+        cv::Mat frame;
+        qint64 index = 0;
+        QElapsedTimer decode;
+        for (;;) {
+            decode.start();
+            if (!cap.read(frame) || frame.empty()) break;
+            if (first == 0) out.decodeNs += decode.nsecsElapsed();
+            const qint64 t = qint64(index * 1000.0 / fps);
+            for (size_t i = 0; i < n; ++i) {
+                pipelines[i].process(frame, t, configs[first + i].params, false, result);
+                const MotionPipeline::StageTimes& st = result.times;
+                qint64* ns = out.perConfig[first + i].stageNs;
+                ns[0] += st.brightness;
+                ns[1] += st.clahe;
+                ns[2] += st.mog2;
+                ns[3] += st.mask;
+                ns[4] += st.contours;
+                if (result.detected) ++out.perConfig[first + i].detectedFrames;
+                trackers[i].feed(result.detected, t);
+            }
+            ++index;
+        }
+        out.frames = index;
+
+        for (size_t i = 0; i < n; ++i) {
+            Stats& s = out.perConfig[first + i];
+            s.frames = index;
+            s.footageMs = qint64(index * 1000.0 / fps);
+            trackers[i].finish();
+            score(trackers[i].events, clipLabels, configs[first + i].params.warmupMs, s);
+        }
+    }
+}
+
+QString perHour(int count, qint64 ms)
+{
+    return ms > 0 ? QString::number(count * 3600000.0 / ms, 'f', 1) : QString("-");
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Replay recorded clips through the motion detection pipeline and compare parameter sets");
+    parser.addHelpOption();
+    parser.addOption({{"s", "set"}, "Sweep a parameter: name=v1,v2,... (repeatable, all combinations).", "name=values"});
+    parser.addOption({"params", "List sweepable parameters and exit."});
+    parser.addOption({{"l", "labels"}, "CSV of true motion intervals: file,start_s,end_s.", "file"});
+    parser.addOption({{"j", "jobs"}, "Clips replayed in parallel (default: all cores).", "n",
+                      QString::number(QThread::idealThreadCount())});
+    parser.addOption({{"b", "batch"}, "Configurations per decode pass (default 4).", "n", QString::number(DEFAULT_BATCH)});
+    parser.addOption({"csv", "Also write per-configuration results as CSV.", "file"});
+    parser.addPositionalArgument("clips", "Video files or folders (default ~/Videos/cctv).", "[clips...]");
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    if (parser.isSet("params")) {
+        for (const ParamSpec& spec : paramSpecs()) out << QString(spec.name).leftJustified(16) << spec.help << "\n";
+        return 0;
+    }
+
+    QStringList names;
+    std::vector<Config> configs;
+    QString error;
+    if (!buildGrid(parser.values("set"), names, configs, error)) {
+        qCritical("%s", qPrintable(error));
+        return 1;
+    }
+
+    QStringList args = parser.positionalArguments();
+    if (args.isEmpty()) args << QDir::homePath() + "/Videos/cctv";
+    const QStringList clips = collectClips(args);
+    if (clips.isEmpty()) {
+        qCritical("No clips found in %s", qPrintable(args.join(' ')));
+        return 1;
+    }
+
+    Labels labels;
+    const bool haveLabels = parser.isSet("labels");
+    if (haveLabels && !loadLabels(parser.value("labels"), labels, error)) {
+        qCritical("%s", qPrintable(error));
+        return 1;
+    }
+
+    const int jobs = qMax(1, parser.value("jobs").toInt());
+    const int batch = qMax(1, parser.value("batch").toInt());
+    // 병렬화는 클립 단위로: OpenCV 내부 스레드까지 쓰면 코어를 두고 서로 다툼
+    if (jobs > 1) cv::setNumThreads(1);
+
+    out << clips.size() << " clips x " << configs.size() << " configurations, " << jobs << " workers\n";
+    out.flush();
+
+    std::vector<ClipResult> results(clips.size());
+    QThreadPool pool;
+    pool.setMaxThreadCount(jobs);
+    QMutex progressMutex;
+    int done = 0;
+    QElapsedTimer wall;
+    wall.start();
+    for (int i = 0; i < clips.size(); ++i) {
+        pool.start([&, i]() {
+            QElapsedTimer t;
+            t.start();
+            replayClip(clips.at(i), configs, batch, haveLabels ? &labels : nullptr, results[i]);
+            const ClipResult& r = results[i];
+            const qint64 footageMs = r.perConfig.empty() ? 0 : r.perConfig.front().footageMs;
+            QMutexLocker lock(&progressMutex);
+            ++done;
+            err << QString("[%1/%2] ").arg(done).arg(clips.size()) << QFileInfo(clips.at(i)).fileName();
+            if (!r.error.isEmpty()) err << "  " << r.error << "\n";
+            else err << "  " << r.frames << " frames, " << QString::number(double(footageMs) / qMax<qint64>(1, t.elapsed()), 'f', 1)
+                     << "x real time\n";
+            err.flush();
+        });
+    }
+    pool.waitForDone();
+    const double wallSec = wall.elapsed() / 1000.0;
+
+    // 설정별 합계
+    std::vector<Stats> totals(configs.size());
+    qint64 decodeNs = 0, decodedFrames = 0, footageMs = 0;
+    int failed = 0;
+    for (const ClipResult& r : results) {
+        if (!r.error.isEmpty()) { ++failed; continue; }
+        decodeNs += r.decodeNs;
+        decodedFrames += r.frames;
+        footageMs += r.perConfig.empty() ? 0 : r.perConfig.front().footageMs;
+        for (size_t c = 0; c < configs.size(); ++c) totals[c].add(r.perConfig[c]);
+    }
+    if (decodedFrames == 0) {
+        qCritical("No frames decoded (%d clips failed)", failed);
+        return 1;
+    }
+
+    auto msPerFrame = [](qint64 ns, qint64 frames) { return QString::number(frames > 0 ? ns / 1e6 / frames : 0.0, 'f', 2); };
+
+    out << "\nfootage " << QString::number(footageMs / 3600000.0, 'f', 2) << " h (" << decodedFrames << " frames"
+        << (failed ? QString(", %1 clips failed").arg(failed) : QString()) << "), wall "
+        << QString::number(wallSec, 'f', 1) << " s, decode " << msPerFrame(decodeNs, decodedFrames) << " ms/frame\n";
+    out << "events are detections merged with a " << EVENT_GAP_S << " s gap; stage costs are ms/frame; "
+           "xRT is the real-time factor of one configuration on one core (decode excluded)\n\n";
+
+    out << "  #" << "  events" << "   ev/h";
+    if (haveLabels) out << "    FA" << "   FA/h" << "  recall";
+    for (const char* stage : STAGE_NAMES) out << QString(stage).rightJustified(8);
+    out << "   total" << "     xRT" << "  " << (names.isEmpty() ? QString("(defaults)") : names.join(' ')) << "\n";
+
+    for (size_t c = 0; c < configs.size(); ++c) {
+        const Stats& s = totals[c];
+        const qint64 pipelineNs = s.totalNs();
+        out << QString::number(c + 1).rightJustified(3)
+            << QString::number(s.events).rightJustified(8)
+            << perHour(s.events, s.footageMs).rightJustified(7);
+        if (haveLabels) {
+            out << QString::number(s.falseAlarms).rightJustified(6)
+                << perHour(s.falseAlarms, s.footageMs).rightJustified(7)
+                << (s.labelsTotal > 0 ? QString::number(100.0 * s.labelsCaught / s.labelsTotal, 'f', 0) + "%"
+                                      : QString("-")).rightJustified(8);
+        }
+        for (qint64 ns : s.stageNs) out << msPerFrame(ns, s.frames).rightJustified(8);
+        out << msPerFrame(pipelineNs, s.frames).rightJustified(8)
+            << QString::number(pipelineNs > 0 ? s.footageMs * 1e6 / pipelineNs : 0.0, 'f', 0).rightJustified(8)
+            << "  " << configs[c].values.join(' ') << "\n";
+    }
+    out.flush();
+
+    if (parser.isSet("csv")) {
+        QFile f(parser.value("csv"));
+        if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+            qCritical("Cannot write %s", qPrintable(parser.value("csv")));
+            return 1;
+        }
+        QTextStream csv(&f);
+        csv << "config";
+        for (const QString& name : std::as_const(names)) csv << "," << name;
+        csv << ",frames,footage_s,detected_frames,events,events_per_hour,false_alarms,false_alarms_per_hour,"
+               "labels,labels_caught";
+        for (const char* stage : STAGE_NAMES) csv << "," << stage << "_ms";
+        csv << ",total_ms\n";
+        for (size_t c = 0; c < configs.size(); ++c) {
+            const Stats& s = totals[c];
+            csv << c + 1;
+            for (const QString& v : configs[c].values) csv << "," << v;
+            csv << "," << s.frames << "," << s.footageMs / 1000.0 << "," << s.detectedFrames
+                << "," << s.events << "," << perHour(s.events, s.footageMs)
+                << "," << (haveLabels ? QString::number(s.falseAlarms) : QString())
+                << "," << (haveLabels ? perHour(s.falseAlarms, s.footageMs) : QString())
+                << "," << s.labelsTotal << "," << s.labelsCaught;
+            for (qint64 ns : s.stageNs) csv << "," << msPerFrame(ns, s.frames);
+            csv << "," << msPerFrame(s.totalNs(), s.frames) << "\n";
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,19 @@
+# 움직임 감지 파라미터 스윕: 녹화 영상을 감지 파이프라인(MotionPipeline)으로 다시 돌려 설정 조합을 비교
+QT       += core
+QT       -= gui
+
+CONFIG += c++17 console link_pkgconfig
+CONFIG -= app_bundle
+
+TARGET = motionsweep
+PKGCONFIG += opencv4
+
+CCTV_SRC = $$PWD/../..
+INCLUDEPATH += $$CCTV_SRC
+
+SOURCES += \
+    main.cpp \
+    $$CCTV_SRC/motionpipeline.cpp
+
+HEADERS += \
+    $$CCTV_SRC/motionpipeline.h
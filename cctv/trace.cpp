@@ -0,0 +1,242 @@
+#include "trace.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QMutex>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QThread>
+#include <QThreadPool>
+#include <array>
+#include <memory>
+#include <vector>
+
+namespace {
+constexpr int    RING_SIZE         = 16384;   // 스레드당 이벤트 수 (감지 스레드 30fps 기준 약 30초)
+constexpr int    DEFAULT_SPIKE_MS  = 300;
+constexpr qint64 SPIKE_COOLDOWN_NS = 30'000'000'000;   // 계속 느려도 30초에 한 번만 저장
+constexpr int    POST_SPIKE_MS     = 500;     // 느린 프레임 뒤의 인코딩/전송/표시까지 담기도록 기다림
+
+struct Event {
+    qint64      ts = 0;
+    qint64      dur = 0;
+    const char* name = nullptr;
+    quint64     frame = 0;
+    char        phase = 0;
+};
+
+// 링 버퍼 한 칸. 필드는 relaxed 원자 값(일반 저장과 같은 명령)이고 seq로 온전한 칸인지 확인
+struct Slot {
+    std::atomic<quint64>     seq{0};   // 기록을 마친 순번 + 1 (0 = 비었거나 쓰는 중)
+    std::atomic<qint64>      ts{0};
+    std::atomic<qint64>      dur{0};
+    std::atomic<const char*> name{nullptr};
+    std::atomic<quint64>     frame{0};
+    std::atomic<char>        phase{0};
+};
+
+// 스레드 하나가 쓰는 링 버퍼. 쓰는 쪽은 잠금 없이, 읽는 쪽은 칸마다 seq로 덮어쓰기 중인 칸을 걸러냄
+struct ThreadBuffer {
+    int                      tid = 0;
+    std::atomic<const char*> name{nullptr};
+    std::atomic<quint64>     head{0};
+    bool                     inUse = true;   // g_mutex 아래에서만
+    std::array<Slot, RING_SIZE> slots;
+};
+
+QMutex g_mutex;   // 버퍼 등록/반납/덤프 (기록 경로에서는 잡지 않음)
+std::vector<std::unique_ptr<ThreadBuffer>> g_buffers;
+int g_nextTid = 1;
+std::atomic_int     g_spikeMs{DEFAULT_SPIKE_MS};
+std::atomic<qint64> g_lastSpikeNs{0};
+
+thread_local const char* t_threadName = nullptr;
+
+// 스레드가 끝나면 버퍼를 반납 → 스레드 풀이 새로 만드는 스레드가 이어서 씀 (버퍼 수가 계속 늘지 않도록).
+// 지난 기록은 지우지 않으므로 끝난 스레드와 새 스레드가 한 트랙에 나옴
+struct BufferHolder {
+    ThreadBuffer* buffer = nullptr;
+    ~BufferHolder()
+    {
+        if (!buffer) return;
+        QMutexLocker lock(&g_mutex);
+        buffer->inUse = false;
+    }
+};
+
+ThreadBuffer* acquireBuffer()
+{
+    QMutexLocker lock(&g_mutex);
+    ThreadBuffer* b = nullptr;
+    for (auto& candidate : g_buffers) {
+        if (candidate->inUse) continue;
+        b = candidate.get();
+        b->inUse = true;
+        break;
+    }
+    if (!b) {
+        g_buffers.push_back(std::make_unique<ThreadBuffer>());
+        b = g_buffers.back().get();
+        b->tid = g_nextTid++;
+    }
+    if (t_threadName) b->name.store(t_threadName, std::memory_order_relaxed);
+    return b;
+}
+
+ThreadBuffer* threadBuffer(bool create)
+{
+    thread_local BufferHolder holder;
+    if (!holder.buffer && create) holder.buffer = acquireBuffer();
+    return holder.buffer;
+}
+
+void push(char phase, const char* name, qint64 ts, qint64 dur, quint64 frame)
+{
+    ThreadBuffer* b = threadBuffer(true);
+    const quint64 i = b->head.load(std::memory_order_relaxed);
+    Slot& e = b->slots[i % RING_SIZE];
+    e.seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    e.ts.store(ts, std::memory_order_relaxed);
+    e.dur.store(dur, std::memory_order_relaxed);
+    e.name.store(name, std::memory_order_relaxed);
+    e.frame.store(frame, std::memory_order_relaxed);
+    e.phase.store(phase, std::memory_order_relaxed);
+    e.seq.store(i + 1, std::memory_order_release);
+    b->head.store(i + 1, std::memory_order_release);
+}
+
+QByteArray micros(qint64 ns)
+{
+    return QByteArray::number(ns / 1000.0, 'f', 3);
+}
+
+void appendEvent(QByteArray& out, const Event& e, int tid)
+{
+    out += "{\"ph\":\"";
+    out += e.phase;
+    out += "\",\"pid\":1,\"tid\":" + QByteArray::number(tid) + ",\"ts\":" + micros(e.ts);
+    if (e.phase == 'X') {
+        out += ",\"name\":\"" + QByteArray(e.name) + "\",\"dur\":" + micros(e.dur);
+        if (e.frame) out += ",\"args\":{\"frame\":" + QByteArray::number(e.frame) + '}';
+    } else {
+        // 흐름 이벤트는 감싸는 구간에 붙음 (bp:e)
+        out += ",\"name\":\"frame\",\"cat\":\"frame\",\"bp\":\"e\",\"id\":" + QByteArray::number(e.frame);
+    }
+    out += "},\n";
+}
+}
+
+namespace Trace {
+
+namespace detail { std::atomic_bool enabled{false}; }
+
+void setEnabled(bool enabled)
+{
+    detail::enabled.store(enabled, std::memory_order_relaxed);
+    qDebug() << "[Trace]" << (enabled ? "enabled" : "disabled");
+}
+
+void configureFromEnvironment()
+{
+    if (qEnvironmentVariableIsSet("CCTV_TRACE_SPIKE_MS")) setSpikeThresholdMs(qEnvironmentVariableIntValue("CCTV_TRACE_SPIKE_MS"));
+    if (qEnvironmentVariableIntValue("CCTV_TRACE") != 0) setEnabled(true);
+}
+
+void setThreadName(const char* name)
+{
+    t_threadName = name;
+    if (ThreadBuffer* b = threadBuffer(false)) b->name.store(name, std::memory_order_relaxed);
+}
+
+void complete(const char* name, qint64 startNs, qint64 endNs, quint64 frameId)
+{
+    if (!isEnabled()) return;
+    push('X', name, startNs, endNs - startNs, frameId);
+}
+
+void flow(Flow phase, quint64 frameId)
+{
+    if (!isEnabled() || frameId == 0) return;
+    push(char(phase), nullptr, nowNs(), 0, frameId);
+}
+
+QByteArray toJson(qint64 windowNs)
+{
+    const qint64 cutoff = windowNs > 0 ? nowNs() - windowNs : 0;
+    QByteArray out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+                     "{\"ph\":\"M\",\"pid\":1,\"name\":\"process_name\",\"args\":{\"name\":\"cctv\"}},\n";
+
+    QMutexLocker lock(&g_mutex);
+    for (const auto& b : g_buffers) {
+        const quint64 head = b->head.load(std::memory_order_acquire);
+        if (head == 0) continue;
+        const char* name = b->name.load(std::memory_order_relaxed);
+        out += "{\"ph\":\"M\",\"pid\":1,\"tid\":" + QByteArray::number(b->tid) + ",\"name\":\"thread_name\",\"args\":{\"name\":\""
+             + (name ? QByteArray(name) : "thread-" + QByteArray::number(b->tid)) + "\"}},\n";
+
+        for (quint64 i = head > RING_SIZE ? head - RING_SIZE : 0; i < head; ++i) {
+            const Slot& slot = b->slots[i % RING_SIZE];
+            if (slot.seq.load(std::memory_order_acquire) != i + 1) continue;
+            Event copy;
+            copy.ts = slot.ts.load(std::memory_order_relaxed);
+            copy.dur = slot.dur.load(std::memory_order_relaxed);
+            copy.name = slot.name.load(std::memory_order_relaxed);
+            copy.frame = slot.frame.load(std::memory_order_relaxed);
+            copy.phase = slot.phase.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) != i + 1) continue;   // 읽는 동안 덮어씀
+            if (copy.ts + copy.dur < cutoff) continue;
+            appendEvent(out, copy, b->tid);
+        }
+    }
+    if (out.endsWith(",\n")) out.chop(2);
+    out += "\n]}\n";
+    return out;
+}
+
+QString dumpDirectory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/traces";
+}
+
+QString dump(const QString& reason)
+{
+    const QString dir = dumpDirectory();
+    QDir().mkpath(dir);
+    const QString path = dir + "/trace-" + QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss_zzz")
+                         + "-" + reason + ".json";
+    const QByteArray json = toJson();
+    QSaveFile f(path);
+    if (!f.open(QIODevice::WriteOnly) || f.write(json) != json.size() || !f.commit()) {
+        qWarning() << "[Trace] Failed to write" << path;
+        return QString();
+    }
+    return path;
+}
+
+void setSpikeThresholdMs(int ms)
+{
+    g_spikeMs.store(qMax(0, ms), std::memory_order_relaxed);
+}
+
+void reportFrame(qint64 frameNs)
+{
+    if (!isEnabled()) return;
+    const int spikeMs = g_spikeMs.load(std::memory_order_relaxed);
+    if (spikeMs <= 0 || frameNs < qint64(spikeMs) * 1'000'000) return;
+
+    const qint64 now = nowNs();
+    qint64 last = g_lastSpikeNs.load(std::memory_order_relaxed);
+    if (last != 0 && now - last < SPIKE_COOLDOWN_NS) return;
+    if (!g_lastSpikeNs.compare_exchange_strong(last, now, std::memory_order_relaxed)) return;
+
+    QThreadPool::globalInstance()->start([frameNs]() {
+        QThread::msleep(POST_SPIKE_MS);
+        const QString path = dump("spike");
+        if (!path.isEmpty()) qWarning() << "[Trace] slow frame" << frameNs / 1'000'000 << "ms, trace saved:" << path;
+    });
+}
+
+} // namespace Trace
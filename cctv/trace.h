@@ -0,0 +1,69 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <QByteArray>
+#include <QString>
+#include <atomic>
+#include <chrono>
+
+// 파이프라인 추적 (Chrome trace / Perfetto JSON, chrome://tracing 또는 ui.perfetto.dev에서 열기).
+// 스레드마다 고정 크기 링 버퍼에 구간(complete) 이벤트와 프레임 번호 흐름(flow) 이벤트를 잠금 없이 기록하고,
+// 요청하거나(Tab1의 T 키, GET /trace.json) 프레임 하나가 임계값보다 오래 걸리면 최근 기록을 JSON으로 씁니다.
+// 꺼져 있으면 원자 변수 하나만 읽고, 켜져 있어도 이벤트 하나가 시계 읽기 + 저장 몇 번이라 상시 켜 둘 수 있습니다.
+//
+// 환경 변수: CCTV_TRACE=1 이면 시작할 때 켬, CCTV_TRACE_SPIKE_MS=임계값 (기본 300, 0이면 자동 저장 안 함)
+namespace Trace {
+
+namespace detail { extern std::atomic_bool enabled; }
+
+inline bool isEnabled() { return detail::enabled.load(std::memory_order_relaxed); }
+void setEnabled(bool enabled);
+void configureFromEnvironment();
+
+inline qint64 nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// 이 스레드의 이름 (추적 화면의 트랙 이름). name은 정적 문자열이어야 함
+void setThreadName(const char* name);
+
+// [startNs, endNs] 구간 하나. name은 정적 문자열, frameId가 있으면 인자로 함께 표시
+void complete(const char* name, qint64 startNs, qint64 endNs, quint64 frameId = 0);
+
+// 프레임 번호로 스레드 사이를 잇는 화살표: 감지 스레드에서 시작, 인코딩/전송에서 경유, 화면 표시에서 끝.
+// 지금 열려 있는(곧 complete로 기록할) 구간 안에서 호출
+enum class Flow : char { Start = 's', Step = 't', End = 'f' };
+void flow(Flow phase, quint64 frameId);
+
+// 범위를 벗어날 때 구간 기록 (꺼져 있으면 시계도 읽지 않음)
+class Scope
+{
+public:
+    explicit Scope(const char* name, quint64 frameId = 0)
+        : m_name(name), m_frameId(frameId), m_startNs(isEnabled() ? nowNs() : 0) {}
+    ~Scope() { if (m_startNs) complete(m_name, m_startNs, nowNs(), m_frameId); }
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+private:
+    const char* m_name;
+    quint64     m_frameId;
+    qint64      m_startNs;
+};
+
+// 모든 스레드 버퍼의 최근 windowNs(0이면 전부)를 Chrome trace JSON으로
+QByteArray toJson(qint64 windowNs = 0);
+// 추적 파일을 둘 폴더 (캐시 폴더/traces)
+QString dumpDirectory();
+// 파일로 저장하고 경로를 돌려줌 (실패하면 빈 문자열). reason은 파일 이름에 붙음
+QString dump(const QString& reason);
+
+// 프레임 하나의 처리 시간을 알림. 임계값을 넘으면 잠시 뒤(뒤따르는 인코딩/표시까지 담기도록) 백그라운드에서 저장
+void setSpikeThresholdMs(int ms);
+void reportFrame(qint64 frameNs);
+
+} // namespace Trace
+
+#endif // TRACE_H
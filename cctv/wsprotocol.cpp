@@ -0,0 +1,92 @@
+#include "wsprotocol.h"
+#include "httprequest.h"
+
+#include <QCryptographicHash>
+#include <QtEndian>
+
+namespace {
+const QByteArray WS_GUID = QByteArrayLiteral("258EAFA5-E914-47DA-95CA-C5AB0DC85B11");
+}
+
+namespace Ws {
+
+QByteArray handshakeResponse(const HttpRequest& req)
+{
+    const QByteArray key = req.header("sec-websocket-key").trimmed();
+    if (req.method != "GET" || key.isEmpty() || req.header("sec-websocket-version").trimmed() != "13")
+        return QByteArray();
+
+    const QByteArray accept = QCryptographicHash::hash(key + WS_GUID, QCryptographicHash::Sha1).toBase64();
+    return "HTTP/1.1 101 Switching Protocols\r\n"
+           "Upgrade: websocket\r\n"
+           "Connection: Upgrade\r\n"
+           "Sec-WebSocket-Accept: " + accept + "\r\n\r\n";
+}
+
+QByteArray frame(Opcode opcode, const QByteArray& payload)
+{
+    const qsizetype n = payload.size();
+    QByteArray out;
+    out.reserve(n + 10);
+    out.append(char(0x80 | quint8(opcode)));
+    if (n <= 125) {
+        out.append(char(n));
+    } else if (n <= 0xFFFF) {
+        out.append(char(126));
+        char len[2];
+        qToBigEndian(quint16(n), len);
+        out.append(len, 2);
+    } else {
+        out.append(char(127));
+        char len[8];
+        qToBigEndian(quint64(n), len);
+        out.append(len, 8);
+    }
+    out.append(payload);
+    return out;
+}
+
+QByteArray closeFrame(quint16 code)
+{
+    char payload[2];
+    qToBigEndian(code, payload);
+    return frame(Opcode::Close, QByteArray(payload, 2));
+}
+
+ParseResult takeFrame(QByteArray& buf, Frame& out, qint64 maxPayload)
+{
+    if (buf.size() < 2) return ParseResult::Incomplete;
+    const auto* p = reinterpret_cast<const uchar*>(buf.constData());
+
+    // RSV 비트는 확장을 협상하지 않았으므로 0이어야 하고, 클라이언트 프레임은 마스킹 필수
+    if ((p[0] & 0x70) || !(p[1] & 0x80)) return ParseResult::Error;
+
+    qint64 len = p[1] & 0x7F;
+    qsizetype pos = 2;
+    if (len == 126) {
+        if (buf.size() < 4) return ParseResult::Incomplete;
+        len = qFromBigEndian<quint16>(p + 2);
+        pos = 4;
+    } else if (len == 127) {
+        if (buf.size() < 10) return ParseResult::Incomplete;
+        const quint64 len64 = qFromBigEndian<quint64>(p + 2);
+        if (len64 > quint64(maxPayload)) return ParseResult::Error;
+        len = qint64(len64);
+        pos = 10;
+    }
+    if (len > maxPayload) return ParseResult::Error;
+    if (buf.size() < pos + 4 + len) return ParseResult::Incomplete;
+
+    const uchar* mask = p + pos;
+    pos += 4;
+    out.fin = (p[0] & 0x80) != 0;
+    out.opcode = Opcode(p[0] & 0x0F);
+    out.payload = buf.mid(pos, len);
+    char* d = out.payload.data();
+    for (qint64 i = 0; i < len; ++i) d[i] ^= mask[i & 3];
+
+    buf.remove(0, pos + len);
+    return ParseResult::Ok;
+}
+
+} // namespace Ws
@@ -0,0 +1,43 @@
+#ifndef WSPROTOCOL_H
+#define WSPROTOCOL_H
+
+#include <QByteArray>
+
+struct HttpRequest;
+
+// 스트림 서버용 최소 WebSocket(RFC 6455) 구현.
+// 서버 → 클라이언트 프레임은 마스킹이 없으므로 한 번 만든 프레임 바이트를
+// 모든 시청자의 소켓에 그대로 써서 공유할 수 있습니다 (클라이언트마다 다시 프레이밍하지 않음).
+namespace Ws {
+
+enum class Opcode : quint8 {
+    Continuation = 0x0,
+    Text         = 0x1,
+    Binary       = 0x2,
+    Close        = 0x8,
+    Ping         = 0x9,
+    Pong         = 0xA,
+};
+
+struct Frame {
+    bool       fin = true;
+    Opcode     opcode = Opcode::Binary;
+    QByteArray payload;     // 마스킹 해제된 데이터
+};
+
+enum class ParseResult { Ok, Incomplete, Error };
+
+// 업그레이드 요청을 검사해 101 응답 헤더를 만듭니다. 지원하지 않는 요청이면 빈 배열.
+QByteArray handshakeResponse(const HttpRequest& req);
+
+// 헤더 + payload 한 덩어리 (서버 → 클라이언트, 마스킹 없음, FIN=1)
+QByteArray frame(Opcode opcode, const QByteArray& payload);
+QByteArray closeFrame(quint16 code);
+
+// buf 앞부분에서 클라이언트 프레임 하나를 꺼내 out에 담고 buf에서 제거합니다.
+// 클라이언트 프레임은 반드시 마스킹돼 있어야 하며, payload가 maxPayload를 넘으면 Error.
+ParseResult takeFrame(QByteArray& buf, Frame& out, qint64 maxPayload);
+
+} // namespace Ws
+
+#endif // WSPROTOCOL_H